@@ -0,0 +1,192 @@
+/*******************************************************************************
+ * benchmarks/fm_index_benchmark.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * PaStA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PaStA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PaStA.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <pasta/bit_vector/fm_index.hpp>
+#include <pasta/utils/benchmark/do_not_optimize.hpp>
+#if defined(DNDEBUG)
+#  include <pasta/utils/benchmark/memory_monitor.hpp>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <pasta/utils/benchmark/timer.hpp>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+#include <vector>
+
+class FmIndexBenchmark {
+  static constexpr bool debug = true;
+  static constexpr auto LOG_PREFIX = "[FmIndexBenchmark] ";
+
+public:
+  void run() {
+    die_verbose_unless(0 < alphabet_size_ && alphabet_size_ < 256,
+                       "-s [--alphabet_size] must be between 1 and 255.");
+    die_verbose_unless(pattern_length_ > 0 && pattern_length_ < text_size_,
+                       "-m [--pattern_length] must be between 1 and the "
+                       "text size.");
+
+    std::mt19937_64 randomness(42);
+
+    LOG << LOG_PREFIX << "Generating random text";
+    std::uniform_int_distribution<uint32_t> symbol_dist(1, alphabet_size_);
+    std::string text(text_size_, '\0');
+    for (size_t i = 0; i + 1 < text_size_; ++i) {
+      text[i] = static_cast<char>(symbol_dist(randomness));
+    }
+
+    // The suffix array is computed by comparison sorting, which is fast
+    // enough for random texts, where the longest common prefixes are short.
+    LOG << LOG_PREFIX << "Computing suffix array and BWT";
+    std::string_view const text_view = text;
+    std::vector<uint64_t> sa(text_size_);
+    std::iota(sa.begin(), sa.end(), 0);
+    std::sort(sa.begin(), sa.end(), [&](uint64_t const a, uint64_t const b) {
+      return text_view.substr(a) < text_view.substr(b);
+    });
+    std::vector<uint8_t> bwt(text_size_);
+    for (size_t i = 0; i < text_size_; ++i) {
+      bwt[i] = text[(sa[i] + text_size_ - 1) % text_size_];
+    }
+
+    LOG << LOG_PREFIX << "Preparing queries";
+    std::uniform_int_distribution<size_t> pos_dist(
+        0,
+        text_size_ - pattern_length_ - 1);
+    std::vector<std::string_view> patterns(query_count_);
+    for (auto& pattern : patterns) {
+      pattern = text_view.substr(pos_dist(randomness), pattern_length_);
+    }
+
+    LOG << LOG_PREFIX << "Creating FM-index";
+    pasta::Timer timer;
+#if defined(DNDEBUG)
+    pasta::MemoryMonitor& mem_monitor = pasta::MemoryMonitor::instance();
+    mem_monitor.reset();
+#endif
+    pasta::FmIndex fm(bwt, sa, sample_rate_);
+    size_t const construction_time = timer.get_and_reset();
+#if defined(DNDEBUG)
+    auto const construction_mem = mem_monitor.get_and_reset();
+#endif
+
+    LOG << LOG_PREFIX << "Benchmarking queries";
+    size_t count_checksum = 0;
+    for (auto const pattern : patterns) {
+      size_t const result = fm.count(pattern);
+      count_checksum += result;
+      PASTA_DO_NOT_OPTIMIZE(result);
+    }
+    size_t const count_query_time = timer.get_and_reset();
+
+    std::vector<size_t> batch_counts(query_count_);
+    fm.count_batch(patterns, batch_counts);
+    size_t const count_batch_query_time = timer.get_and_reset();
+    size_t const batch_checksum =
+        std::accumulate(batch_counts.begin(), batch_counts.end(), size_t{0});
+    die_unequal(count_checksum, batch_checksum);
+
+    timer.reset();
+    size_t occurrences = 0;
+    for (auto const pattern : patterns) {
+      auto const result = fm.locate(pattern);
+      occurrences += result.size();
+      PASTA_DO_NOT_OPTIMIZE(result);
+    }
+    size_t const locate_query_time = timer.get_and_reset();
+
+    LOG << LOG_PREFIX << "Finished FM-index benchmark";
+
+    std::cout << "RESULT "
+              << "algo=pasta_fm_index "
+              << "text_size=" << text_size_ << " "
+              << "alphabet_size=" << alphabet_size_ << " "
+              << "sample_rate=" << sample_rate_ << " "
+              << "pattern_length=" << pattern_length_ << " "
+              << "query_count=" << query_count_ << " "
+              << "occurrences=" << occurrences << " "
+              << "construction_time=" << construction_time << " "
+#if defined(DNDEBUG)
+              << "construction_mem=" << construction_mem.cur_peak << " "
+#endif
+              << "space_usage=" << fm.space_usage() << " "
+              << "count_query_time=" << count_query_time << " "
+              << "count_batch_query_time=" << count_batch_query_time << " "
+              << "locate_query_time=" << locate_query_time << " "
+              << "\n";
+  }
+
+  size_t text_size_ = 1024 * 1024;
+  uint32_t alphabet_size_ = 4;
+  size_t sample_rate_ = 32;
+  size_t pattern_length_ = 12;
+  size_t query_count_ = 10000;
+}; // class FmIndexBenchmark
+
+int32_t main(int32_t argc, char const* const argv[]) {
+  FmIndexBenchmark fmb;
+
+  tlx::CmdlineParser cp;
+
+  cp.set_description("Benchmark tool for PaStA's FM-index implementation.");
+  cp.set_author("Florian Kurpicz <florian@kurpicz.org>");
+
+  cp.add_bytes('n',
+               "text_size",
+               fmb.text_size_,
+               "Length of the random text including the sentinel "
+               "(accepts SI units, default 1024^2).");
+
+  cp.add_uint('s',
+              "alphabet_size",
+              fmb.alphabet_size_,
+              "Number of distinct symbols in the text (default 4).");
+
+  cp.add_bytes('r',
+               "sample_rate",
+               fmb.sample_rate_,
+               "Suffix array sample rate (default 32).");
+
+  cp.add_bytes('m',
+               "pattern_length",
+               fmb.pattern_length_,
+               "Length of the patterns (default 12).");
+
+  cp.add_bytes('q',
+               "query_count",
+               fmb.query_count_,
+               "Number of count and locate queries (accepts SI units, "
+               "default is 10000)");
+
+  if (!cp.process(argc, argv)) {
+    return -1;
+  }
+
+  fmb.run();
+
+  return 0;
+}
+
+/******************************************************************************/
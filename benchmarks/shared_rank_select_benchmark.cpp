@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * benchmarks/shared_rank_select_benchmark.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * PaStA is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PaStA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PaStA.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/shared_flat_rank_select.hpp>
+#include <pasta/bit_vector/support/flat_rank_select.hpp>
+#include <pasta/utils/benchmark/do_not_optimize.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <pasta/utils/benchmark/timer.hpp>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+#include <unistd.h>
+#include <vector>
+
+class SharedRankSelectBenchmark {
+  static constexpr bool debug = true;
+  static constexpr auto LOG_PREFIX = "[SharedRankSelectBenchmark] ";
+
+  //! Statistics reported by each worker process to the parent.
+  struct WorkerResult {
+    size_t setup_time;
+    size_t query_time;
+    size_t rss_kib;
+    size_t pss_kib;
+    size_t checksum;
+  }; // struct WorkerResult
+
+public:
+  void run() {
+    die_verbose_unless(process_count_ > 0,
+                       "-p [--processes] must be at least 1.");
+    die_verbose_unless(fill_percentage_ <= 100,
+                       "-f [--fill_percentage] must be at most 100.");
+
+    std::string const name =
+        "/pasta_shared_rank_select_benchmark_" + std::to_string(getpid());
+
+    for (bool const shared : {false, true}) {
+      pasta::Timer timer;
+      if (shared) {
+        LOG << LOG_PREFIX << "Creating shared memory segment";
+        pasta::BitVector bv = generate_bit_vector();
+        pasta::SharedFlatRankSelect<>::remove(name);
+        die_verbose_unless(pasta::SharedFlatRankSelect<>::create(name, bv),
+                           "Could not create shared memory segment.");
+      }
+      size_t const creation_time = timer.get_and_reset();
+
+      LOG << LOG_PREFIX << "Starting " << process_count_ << " "
+          << (shared ? "shared" : "private") << " workers";
+      std::vector<WorkerResult> results(process_count_);
+      std::vector<std::array<int, 2>> pipes(process_count_);
+      std::vector<pid_t> pids(process_count_);
+      for (size_t p = 0; p < process_count_; ++p) {
+        die_unless(pipe(pipes[p].data()) == 0);
+        pids[p] = fork();
+        die_unless(pids[p] >= 0);
+        if (pids[p] == 0) {
+          close(pipes[p][0]);
+          WorkerResult const result = shared ? shared_worker(name, p) :
+                                               private_worker(p);
+          die_unless(write(pipes[p][1], &result, sizeof(result)) ==
+                     sizeof(result));
+          close(pipes[p][1]);
+          _exit(0);
+        }
+        close(pipes[p][1]);
+      }
+      size_t checksum = 0;
+      for (size_t p = 0; p < process_count_; ++p) {
+        die_unless(read(pipes[p][0], &results[p], sizeof(WorkerResult)) ==
+                   sizeof(WorkerResult));
+        close(pipes[p][0]);
+        int status = 0;
+        waitpid(pids[p], &status, 0);
+        checksum += results[p].checksum;
+      }
+      size_t const total_time = timer.get_and_reset();
+      if (shared) {
+        pasta::SharedFlatRankSelect<>::remove(name);
+      }
+
+      size_t max_setup_time = 0;
+      size_t max_query_time = 0;
+      size_t max_rss = 0;
+      size_t sum_rss = 0;
+      size_t sum_pss = 0;
+      for (auto const& result : results) {
+        max_setup_time = std::max(max_setup_time, result.setup_time);
+        max_query_time = std::max(max_query_time, result.query_time);
+        max_rss = std::max(max_rss, result.rss_kib);
+        sum_rss += result.rss_kib;
+        sum_pss += result.pss_kib;
+      }
+
+      std::cout << "RESULT "
+                << "algo=pasta_flat_rank_select "
+                << "mode=" << (shared ? "shared" : "private") << " "
+                << "bit_size=" << bit_size_ << " "
+                << "fill_percentage=" << fill_percentage_ << " "
+                << "processes=" << process_count_ << " "
+                << "query_count=" << query_count_ << " "
+                << "creation_time=" << creation_time << " "
+                << "max_setup_time=" << max_setup_time << " "
+                << "max_query_time=" << max_query_time << " "
+                << "total_time=" << total_time << " "
+                << "max_rss_kib=" << max_rss << " "
+                << "sum_rss_kib=" << sum_rss << " "
+                << "sum_pss_kib=" << sum_pss << " "
+                << "checksum=" << checksum << " "
+                << "\n";
+    }
+    LOG << LOG_PREFIX << "Finished shared rank and select benchmark";
+  }
+
+  size_t bit_size_ = 1024ULL * 1024 * 1024;
+  uint32_t fill_percentage_ = 50;
+  size_t process_count_ = 4;
+  size_t query_count_ = 1'000'000;
+
+private:
+  //! Generates the (same) random bit vector in each call.
+  pasta::BitVector generate_bit_vector() const {
+    std::mt19937_64 randomness(42);
+    std::uniform_int_distribution<uint32_t> dist(0, 99);
+    pasta::BitVector bv(bit_size_, false);
+    auto data = bv.data();
+    for (size_t i = 0; i < bit_size_; ++i) {
+      if (dist(randomness) < fill_percentage_) {
+        data[i / 64] |= 1ULL << (i % 64);
+      }
+    }
+    return bv;
+  }
+
+  //! Worker that builds its own copy of the bit vector and rank and select.
+  WorkerResult private_worker(size_t const id) const {
+    pasta::Timer timer;
+    pasta::BitVector bv = generate_bit_vector();
+    pasta::FlatRankSelect<> rs(bv);
+    size_t const setup_time = timer.get_and_reset();
+    return run_queries(rs, id, setup_time);
+  }
+
+  //! Worker that attaches the shared memory segment.
+  WorkerResult shared_worker(std::string const& name, size_t const id) const {
+    pasta::Timer timer;
+    auto rs = pasta::SharedFlatRankSelect<>::attach(name);
+    die_verbose_unless(rs.has_value(), "Could not attach shared segment.");
+    size_t const setup_time = timer.get_and_reset();
+    return run_queries(*rs, id, setup_time);
+  }
+
+  //! Runs random rank and select queries and measures the memory usage.
+  template <typename RankSelect>
+  WorkerResult run_queries(RankSelect const& rs,
+                           size_t const id,
+                           size_t const setup_time) const {
+    std::mt19937_64 randomness(id);
+    size_t const ones = rs.rank1(bit_size_);
+    std::uniform_int_distribution<size_t> pos_dist(0, bit_size_ - 1);
+    std::uniform_int_distribution<size_t> rank_dist(1, std::max(ones, size_t{1}));
+    pasta::Timer timer;
+    size_t checksum = 0;
+    for (size_t i = 0; i < query_count_; ++i) {
+      size_t const result = rs.rank1(pos_dist(randomness));
+      checksum += result;
+      PASTA_DO_NOT_OPTIMIZE(result);
+    }
+    if (ones > 0) {
+      for (size_t i = 0; i < query_count_; ++i) {
+        size_t const result = rs.select1(rank_dist(randomness));
+        checksum += result;
+        PASTA_DO_NOT_OPTIMIZE(result);
+      }
+    }
+    size_t const query_time = timer.get_and_reset();
+    return {setup_time,
+            query_time,
+            memory_kib("VmRSS:", "/proc/self/status"),
+            memory_kib("Pss:", "/proc/self/smaps_rollup"),
+            checksum};
+  }
+
+  //! Reads a memory statistic (in KiB) from a file in \c /proc.
+  static size_t memory_kib(std::string const& key, char const* const path) {
+    std::ifstream in(path);
+    std::string token;
+    while (in >> token) {
+      if (token == key) {
+        size_t value = 0;
+        in >> value;
+        return value;
+      }
+    }
+    return 0;
+  }
+}; // class SharedRankSelectBenchmark
+
+int32_t main(int32_t argc, char const* const argv[]) {
+  SharedRankSelectBenchmark srsb;
+
+  tlx::CmdlineParser cp;
+
+  cp.set_description("Benchmark tool comparing the memory usage of multiple "
+                     "processes querying private copies of a bit vector with "
+                     "rank and select support and one copy placed in shared "
+                     "memory.");
+  cp.set_author("Florian Kurpicz <florian@kurpicz.org>");
+
+  cp.add_bytes('n',
+               "bit_size",
+               srsb.bit_size_,
+               "Size of the bit vector in bits (accepts SI units, default "
+               "1024^3).");
+
+  cp.add_uint('f',
+              "fill_percentage",
+              srsb.fill_percentage_,
+              "Percentage of set bits (default 50).");
+
+  cp.add_bytes('p',
+               "processes",
+               srsb.process_count_,
+               "Number of worker processes (default 4).");
+
+  cp.add_bytes('q',
+               "query_count",
+               srsb.query_count_,
+               "Number of rank and select queries per process (accepts SI "
+               "units, default is 1000000)");
+
+  if (!cp.process(argc, argv)) {
+    return -1;
+  }
+
+  srsb.run();
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,559 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/popcount.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <pasta/utils/debug_asserts.hpp>
+#include <queue>
+#include <span>
+#include <vector>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Contiguous collection of fixed-size bit codes (e.g., binary
+ * embeddings) supporting brute-force Hamming distance search.
+ *
+ * The codes are stored in blocks of \c BLOCK_CODES = 8 codes. Within a
+ * block, the codes are interleaved word-wise, i.e., the j-th 64-bit words of
+ * all eight codes are stored contiguously in one 64-byte aligned cache line.
+ * This way, the distances of a query to all eight codes of a block are
+ * computed simultaneously: with AVX-512 VPOPCNTDQ using one \c vpopcntq per
+ * word, with AVX2 using the nibble-lookup popcount (\c vpshufb and
+ * \c vpsadbw), and with \c popcnt otherwise.
+ *
+ * Searches are tiled: the codes are processed in tiles of about 256 KiB and
+ * each tile is compared with a batch of up to \c QUERY_BATCH queries before
+ * the next tile is loaded, such that multiple queries share the memory
+ * bandwidth. With OpenMP, single queries are split into one range of codes
+ * per thread and batches of queries are distributed among the threads.
+ */
+class BitCodeArray {
+public:
+  //! Number of codes that are stored interleaved in one block.
+  static constexpr size_t BLOCK_CODES = 8;
+  //! Number of queries that are compared with a tile of codes at once.
+  static constexpr size_t QUERY_BATCH = 8;
+  //! Size of a tile of codes in bytes.
+  static constexpr size_t TILE_BYTES = 256 * 1024;
+
+  /*!
+   * \brief Result of a top-k query.
+   */
+  struct Neighbor {
+    //! Index of the code.
+    size_t index;
+    //! Hamming distance between the code and the query.
+    size_t distance;
+
+    //! Neighbors are ordered by distance first and index second.
+    friend bool operator<(Neighbor const& a, Neighbor const& b) noexcept {
+      return (a.distance < b.distance) ||
+             (a.distance == b.distance && a.index < b.index);
+    }
+
+    //! Comparison for equality.
+    friend bool operator==(Neighbor const& a, Neighbor const& b) noexcept {
+      return a.index == b.index && a.distance == b.distance;
+    }
+  }; // struct BitCodeArray::Neighbor
+
+private:
+  //! Deleter for the aligned storage.
+  struct AlignedDelete {
+    void operator()(uint64_t* const ptr) const noexcept {
+      ::operator delete[](ptr, std::align_val_t{64});
+    }
+  }; // struct BitCodeArray::AlignedDelete
+
+  //! Number of bits per code.
+  size_t code_bits_ = 0;
+  //! Number of 64-bit words per code.
+  size_t code_words_ = 0;
+  //! Mask for the last word of each code.
+  uint64_t last_word_mask_ = ~0ULL;
+  //! Number of codes.
+  size_t size_ = 0;
+  //! Number of blocks the storage has space for.
+  size_t capacity_blocks_ = 0;
+  //! Interleaved codes (64-byte aligned).
+  std::unique_ptr<uint64_t[], AlignedDelete> data_;
+
+public:
+  //! Default constructor w/o parameter.
+  BitCodeArray() = default;
+
+  /*!
+   * \brief Constructor. Creates an empty collection of codes.
+   * \param code_bits Number of bits per code.
+   * \param capacity Number of codes space is reserved for.
+   */
+  BitCodeArray(size_t const code_bits, size_t const capacity = 0)
+      : code_bits_(code_bits),
+        code_words_((code_bits + 63) / 64),
+        last_word_mask_((code_bits % 64 == 0) ? ~0ULL :
+                                                (1ULL << (code_bits % 64)) - 1) {
+    PASTA_ASSERT(code_bits > 0, "Codes must contain at least one bit.");
+    reserve(capacity);
+  }
+
+  //! Default move constructor.
+  BitCodeArray(BitCodeArray&&) = default;
+
+  //! Default move assignment.
+  BitCodeArray& operator=(BitCodeArray&&) = default;
+
+  /*!
+   * \brief Reserve space for a number of codes.
+   * \param capacity Number of codes space is reserved for.
+   */
+  void reserve(size_t const capacity) {
+    size_t const blocks = (capacity + BLOCK_CODES - 1) / BLOCK_CODES;
+    if (blocks <= capacity_blocks_) {
+      return;
+    }
+    size_t const block_words = code_words_ * BLOCK_CODES;
+    std::unique_ptr<uint64_t[], AlignedDelete> data(
+        static_cast<uint64_t*>(::operator new[](
+            blocks * block_words * sizeof(uint64_t), std::align_val_t{64})));
+    if (capacity_blocks_ > 0) {
+      std::memcpy(data.get(),
+                  data_.get(),
+                  capacity_blocks_ * block_words * sizeof(uint64_t));
+    }
+    // Unused slots of the last block must be zero.
+    std::memset(data.get() + (capacity_blocks_ * block_words),
+                0,
+                (blocks - capacity_blocks_) * block_words * sizeof(uint64_t));
+    data_ = std::move(data);
+    capacity_blocks_ = blocks;
+  }
+
+  /*!
+   * \brief Append a code.
+   * \param code The \c code_words() 64-bit words of the code. Bits after
+   * the code size are ignored.
+   */
+  void push_back(std::span<uint64_t const> const code) {
+    PASTA_ASSERT(code.size() >= code_words_, "Code is too short.");
+    if (size_ == capacity_blocks_ * BLOCK_CODES) {
+      reserve(std::max<size_t>(2 * size_, BLOCK_CODES));
+    }
+    uint64_t* const block = block_data(size_ / BLOCK_CODES);
+    size_t const lane = size_ % BLOCK_CODES;
+    for (size_t j = 0; j < code_words_; ++j) {
+      block[(j * BLOCK_CODES) + lane] =
+          (j + 1 == code_words_) ? (code[j] & last_word_mask_) : code[j];
+    }
+    ++size_;
+  }
+
+  /*!
+   * \brief Append a code stored in a \ref BitVector.
+   * \param code \ref BitVector containing the code (\c code_bits() bits).
+   */
+  void push_back(BitVector const& code) {
+    PASTA_ASSERT(code.size() == code_bits_, "Code has the wrong size.");
+    push_back(code.data());
+  }
+
+  /*!
+   * \brief Get a word of a code.
+   * \param index Index of the code.
+   * \param word Index of the 64-bit word within the code.
+   * \return The \c word-th 64-bit word of the \c index-th code.
+   */
+  [[nodiscard("word computed but not used")]] uint64_t
+  word(size_t const index, size_t const word) const noexcept {
+    return block_data(index / BLOCK_CODES)[(word * BLOCK_CODES) +
+                                           (index % BLOCK_CODES)];
+  }
+
+  /*!
+   * \brief Hamming distance between a code and a query.
+   * \param index Index of the code.
+   * \param query The \c code_words() 64-bit words of the query.
+   * \return Hamming distance between the \c index-th code and \c query.
+   */
+  [[nodiscard("hamming distance computed but not used")]] size_t
+  hamming_distance(size_t const index,
+                   std::span<uint64_t const> const query) const {
+    size_t result = 0;
+    for (size_t j = 0; j < code_words_; ++j) {
+      uint64_t const q =
+          (j + 1 == code_words_) ? (query[j] & last_word_mask_) : query[j];
+      result += std::popcount(word(index, j) ^ q);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Find the \c k codes closest to a query.
+   * \param query The \c code_words() 64-bit words of the query.
+   * \param k Number of codes that are reported.
+   * \return The \c min(k, size()) closest codes ordered by distance (ties
+   * are broken by index).
+   */
+  [[nodiscard("top-k computed but not used")]] std::vector<Neighbor>
+  top_k(std::span<uint64_t const> const query, size_t const k) const {
+    std::vector<uint64_t> const masked = masked_queries(query, 1);
+    size_t const blocks = num_blocks();
+#if defined(_OPENMP)
+    size_t const num_chunks = std::max<size_t>(
+        1,
+        std::min(static_cast<size_t>(omp_get_max_threads()), blocks));
+#else
+    size_t const num_chunks = 1;
+#endif
+    std::vector<std::vector<Neighbor>> chunk_results(num_chunks);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      std::priority_queue<Neighbor> heap;
+      scan(masked.data(),
+           1,
+           (blocks * chunk) / num_chunks,
+           (blocks * (chunk + 1)) / num_chunks,
+           [&](size_t, size_t const index, size_t const distance) {
+             offer(heap, k, Neighbor{index, distance});
+           });
+      chunk_results[chunk] = sorted(heap);
+    }
+
+    std::vector<Neighbor> result;
+    for (auto const& chunk_result : chunk_results) {
+      result.insert(result.end(), chunk_result.begin(), chunk_result.end());
+    }
+    std::sort(result.begin(), result.end());
+    result.resize(std::min(result.size(), k));
+    return result;
+  }
+
+  /*!
+   * \brief Find the \c k codes closest to each of multiple queries.
+   * \param queries The queries, each consisting of \c code_words()
+   * consecutive 64-bit words.
+   * \param k Number of codes that are reported per query.
+   * \return For each query, the \c min(k, size()) closest codes ordered by
+   * distance (ties are broken by index).
+   */
+  [[nodiscard("top-k computed but not used")]] std::vector<
+      std::vector<Neighbor>>
+  top_k_batch(std::span<uint64_t const> const queries, size_t const k) const {
+    size_t const num_queries = queries.size() / code_words_;
+    std::vector<uint64_t> const masked = masked_queries(queries, num_queries);
+    std::vector<std::vector<Neighbor>> result(num_queries);
+    size_t const num_batches = (num_queries + QUERY_BATCH - 1) / QUERY_BATCH;
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (size_t batch = 0; batch < num_batches; ++batch) {
+      size_t const first = batch * QUERY_BATCH;
+      size_t const batch_size = std::min(QUERY_BATCH, num_queries - first);
+      std::array<std::priority_queue<Neighbor>, QUERY_BATCH> heaps;
+      scan(masked.data() + (first * code_words_),
+           batch_size,
+           0,
+           num_blocks(),
+           [&](size_t const q, size_t const index, size_t const distance) {
+             offer(heaps[q], k, Neighbor{index, distance});
+           });
+      for (size_t q = 0; q < batch_size; ++q) {
+        result[first + q] = sorted(heaps[q]);
+      }
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Find all codes within a Hamming radius of a query.
+   * \param query The \c code_words() 64-bit words of the query.
+   * \param radius Maximum Hamming distance.
+   * \return Indices of all codes with distance at most \c radius in
+   * increasing order.
+   */
+  [[nodiscard("radius search computed but not used")]] std::vector<size_t>
+  within_radius(std::span<uint64_t const> const query,
+                size_t const radius) const {
+    std::vector<uint64_t> const masked = masked_queries(query, 1);
+    size_t const blocks = num_blocks();
+#if defined(_OPENMP)
+    size_t const num_chunks = std::max<size_t>(
+        1,
+        std::min(static_cast<size_t>(omp_get_max_threads()), blocks));
+#else
+    size_t const num_chunks = 1;
+#endif
+    std::vector<std::vector<size_t>> chunk_results(num_chunks);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      scan(masked.data(),
+           1,
+           (blocks * chunk) / num_chunks,
+           (blocks * (chunk + 1)) / num_chunks,
+           [&](size_t, size_t const index, size_t const distance) {
+             if (distance <= radius) {
+               chunk_results[chunk].push_back(index);
+             }
+           });
+    }
+
+    std::vector<size_t> result;
+    for (auto const& chunk_result : chunk_results) {
+      result.insert(result.end(), chunk_result.begin(), chunk_result.end());
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Find all codes within a Hamming radius of each of multiple
+   * queries.
+   * \param queries The queries, each consisting of \c code_words()
+   * consecutive 64-bit words.
+   * \param radius Maximum Hamming distance.
+   * \return For each query, the indices of all codes with distance at most
+   * \c radius in increasing order.
+   */
+  [[nodiscard("radius search computed but not used")]] std::vector<
+      std::vector<size_t>>
+  within_radius_batch(std::span<uint64_t const> const queries,
+                      size_t const radius) const {
+    size_t const num_queries = queries.size() / code_words_;
+    std::vector<uint64_t> const masked = masked_queries(queries, num_queries);
+    std::vector<std::vector<size_t>> result(num_queries);
+    size_t const num_batches = (num_queries + QUERY_BATCH - 1) / QUERY_BATCH;
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (size_t batch = 0; batch < num_batches; ++batch) {
+      size_t const first = batch * QUERY_BATCH;
+      scan(masked.data() + (first * code_words_),
+           std::min(QUERY_BATCH, num_queries - first),
+           0,
+           num_blocks(),
+           [&](size_t const q, size_t const index, size_t const distance) {
+             if (distance <= radius) {
+               result[first + q].push_back(index);
+             }
+           });
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Get the number of codes.
+   * \return Number of codes.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of bits per code.
+   * \return Number of bits per code.
+   */
+  [[nodiscard("code bits computed but not used")]] size_t
+  code_bits() const noexcept {
+    return code_bits_;
+  }
+
+  /*!
+   * \brief Get the number of 64-bit words per code.
+   * \return Number of 64-bit words per code.
+   */
+  [[nodiscard("code words computed but not used")]] size_t
+  code_words() const noexcept {
+    return code_words_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) +
+           (capacity_blocks_ * code_words_ * BLOCK_CODES * sizeof(uint64_t));
+  }
+
+private:
+  //! Number of blocks containing at least one code.
+  size_t num_blocks() const noexcept {
+    return (size_ + BLOCK_CODES - 1) / BLOCK_CODES;
+  }
+
+  //! Pointer to the first word of a block.
+  uint64_t* block_data(size_t const block) const noexcept {
+    return data_.get() + (block * code_words_ * BLOCK_CODES);
+  }
+
+  //! Copies queries and removes bits after the code size.
+  std::vector<uint64_t> masked_queries(std::span<uint64_t const> const queries,
+                                       size_t const num_queries) const {
+    PASTA_ASSERT(queries.size() >= num_queries * code_words_,
+                 "Query is too short.");
+    std::vector<uint64_t> result(queries.begin(),
+                                 queries.begin() + (num_queries * code_words_));
+    for (size_t q = 0; q < num_queries; ++q) {
+      result[((q + 1) * code_words_) - 1] &= last_word_mask_;
+    }
+    return result;
+  }
+
+  //! Adds a neighbor to a heap containing at most \c k neighbors.
+  static void offer(std::priority_queue<Neighbor>& heap,
+                    size_t const k,
+                    Neighbor const neighbor) {
+    if (heap.size() < k) {
+      heap.push(neighbor);
+    } else if (k > 0 && neighbor < heap.top()) {
+      heap.pop();
+      heap.push(neighbor);
+    }
+  }
+
+  //! Empties a heap and returns its neighbors in increasing order.
+  static std::vector<Neighbor> sorted(std::priority_queue<Neighbor>& heap) {
+    std::vector<Neighbor> result(heap.size());
+    for (size_t i = result.size(); i > 0; --i) {
+      result[i - 1] = heap.top();
+      heap.pop();
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes the distances between a query and the eight codes of a
+   * block.
+   * \param block Index of the block.
+   * \param query The (masked) query.
+   * \param distances Array the eight distances are written to.
+   */
+  void block_distances(size_t const block,
+                       uint64_t const* const query,
+                       std::array<uint64_t, BLOCK_CODES>& distances) const {
+    uint64_t const* const data = block_data(block);
+#if defined(__AVX512VPOPCNTDQ__)
+    __m512i sum = _mm512_setzero_si512();
+    for (size_t j = 0; j < code_words_; ++j) {
+      __m512i const codes = _mm512_load_si512(data + (j * BLOCK_CODES));
+      __m512i const q = _mm512_set1_epi64(static_cast<int64_t>(query[j]));
+      sum = _mm512_add_epi64(sum,
+                             _mm512_popcnt_epi64(_mm512_xor_si512(codes, q)));
+    }
+    _mm512_storeu_si512(distances.data(), sum);
+#elif defined(__AVX2__)
+    __m256i sum_lo = _mm256_setzero_si256();
+    __m256i sum_hi = _mm256_setzero_si256();
+    for (size_t j = 0; j < code_words_; ++j) {
+      __m256i const q = _mm256_set1_epi64x(static_cast<int64_t>(query[j]));
+      __m256i const codes_lo = _mm256_load_si256(
+          reinterpret_cast<__m256i const*>(data + (j * BLOCK_CODES)));
+      __m256i const codes_hi = _mm256_load_si256(
+          reinterpret_cast<__m256i const*>(data + (j * BLOCK_CODES) + 4));
+      sum_lo = _mm256_add_epi64(sum_lo,
+                                popcount_epi64(_mm256_xor_si256(codes_lo, q)));
+      sum_hi = _mm256_add_epi64(sum_hi,
+                                popcount_epi64(_mm256_xor_si256(codes_hi, q)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances.data()), sum_lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances.data() + 4),
+                        sum_hi);
+#else
+    distances.fill(0);
+    for (size_t j = 0; j < code_words_; ++j) {
+      for (size_t lane = 0; lane < BLOCK_CODES; ++lane) {
+        distances[lane] +=
+            std::popcount(data[(j * BLOCK_CODES) + lane] ^ query[j]);
+      }
+    }
+#endif
+  }
+
+  /*!
+   * \brief Computes the distances between a batch of queries and all codes
+   * in a range of blocks.
+   *
+   * The blocks are processed in tiles of about \c TILE_BYTES bytes. Each
+   * tile is compared with all queries of the batch before the next tile is
+   * processed.
+   * \param queries The (masked) queries.
+   * \param num_queries Number of queries.
+   * \param begin First block that is considered.
+   * \param end Block after the last block that is considered.
+   * \param visit Called with the index of the query, the index of the code,
+   * and their distance for each pair (in increasing order of the codes per
+   * query).
+   */
+  template <typename Visit>
+  void scan(uint64_t const* const queries,
+            size_t const num_queries,
+            size_t const begin,
+            size_t const end,
+            Visit&& visit) const {
+    size_t const tile_blocks = std::max<size_t>(
+        1,
+        TILE_BYTES / (code_words_ * BLOCK_CODES * sizeof(uint64_t)));
+    std::array<uint64_t, BLOCK_CODES> distances;
+    for (size_t tile = begin; tile < end; tile += tile_blocks) {
+      size_t const tile_end = std::min(end, tile + tile_blocks);
+      for (size_t q = 0; q < num_queries; ++q) {
+        uint64_t const* const query = queries + (q * code_words_);
+        for (size_t block = tile; block < tile_end; ++block) {
+          block_distances(block, query, distances);
+          size_t const codes =
+              std::min(BLOCK_CODES, size_ - (block * BLOCK_CODES));
+          for (size_t lane = 0; lane < codes; ++lane) {
+            visit(q, (block * BLOCK_CODES) + lane, distances[lane]);
+          }
+        }
+      }
+    }
+  }
+}; // class BitCodeArray
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -22,15 +22,31 @@
 
 #include "pasta/bit_vector/support/find_l2_flat_with.hpp"
 #include "pasta/bit_vector/support/find_l2_wide_with.hpp"
+#include "pasta/bit_vector/support/file_mapping.hpp"
+#include "pasta/bit_vector/support/find_pattern.hpp"
+#include "pasta/bit_vector/support/find_word.hpp"
+#include "pasta/bit_vector/support/gather_bits.hpp"
 #include "pasta/bit_vector/support/optimized_for.hpp"
+#include "pasta/bit_vector/support/stream_copy.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <new>
+#include <optional>
+#include <pasta/utils/debug_asserts.hpp>
 #include <span>
+#include <string>
 #include <tlx/container/simple_vector.hpp>
+#include <utility>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
 
 namespace pasta {
 
@@ -46,10 +62,16 @@ class BitAccess {
   //! Forward declaration.
   friend class BitVector;
 
+  //! Number of bits covered by one bit of the dirty-region bitmap.
+  static constexpr size_t DIRTY_REGION_BITS = 4096;
+
   //! 64-bit word the bit is contained in.
   uint64_t* const data_;
   //! Position of the bit within the 64-bit word.
   size_t position_;
+  //! Bitmap of modified regions (see \ref BitVector::track_dirty_regions())
+  //! or \c nullptr if modifications are not tracked.
+  uint64_t* const dirty_;
 
 public:
   //! Deleted constructor.
@@ -72,10 +94,15 @@ public:
    *
    * \param data Pointer to the 64-bit word that contains the bit.
    * \param position Position of the bit within the 64-bit word.
+   * \param dirty Bitmap where writes mark the region of the bit as modified
+   * or \c nullptr if modifications are not tracked.
    */
-  BitAccess(uint64_t* const data, size_t const position) noexcept
+  BitAccess(uint64_t* const data,
+            size_t const position,
+            uint64_t* const dirty = nullptr) noexcept
       : data_(data),
-        position_(position) {}
+        position_(position),
+        dirty_(dirty) {}
 
   /*!
    * \brief User-defined conversion function to bool.
@@ -98,6 +125,9 @@ public:
     // (ConditionalSetOrClearBitsWithoutBranching)
     uint64_t const mask = 1ULL << (uint64_t(position_) & uint64_t(0b111111));
     data_[position_ >> 6] = (data_[position_ >> 6] & ~mask) | (-value & mask);
+    if (dirty_ != nullptr) [[unlikely]] {
+      mark_dirty();
+    }
     return *this;
   }
 
@@ -145,6 +175,22 @@ public:
   }
 
 private:
+  /*!
+   * \brief Mark the region containing the bit as modified.
+   *
+   * The bitmap word is only written if the bit is not set already, i.e.,
+   * repeated writes to the same region do not cause any stores. Concurrent
+   * writes to different bits are safe, since the bit is set atomically.
+   */
+  void mark_dirty() const noexcept {
+    size_t const region = position_ / DIRTY_REGION_BITS;
+    uint64_t const mask = 1ULL << (region % 64);
+    std::atomic_ref<uint64_t> word(dirty_[region / 64]);
+    if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+      word.fetch_or(mask, std::memory_order_relaxed);
+    }
+  }
+
   /*!
    * \brief The copy constructor is private and should not be used.
    *
@@ -170,6 +216,13 @@ private:
  *
  * | 7 6 5 4 3 2 1 0 | 15 14 13 12 11 10 9 8 | 23 22 21 20 19 18 17 16 | ...
  *
+ * By default, the words are stored in anonymous memory. Alternatively, they
+ * can be stored in a file that is mapped into memory (see \c create_file()
+ * and \c open_file()), e.g., for a persistent bit vector that is larger
+ * than the memory one wants to spend on it. The file contains a small header
+ * followed by the raw data. All other functionality, including rank and
+ * select support, works the same for both storage modes.
+ *
  * \todo Add all required support to make bit vector work as a true (fixed
  * replacement of \c std::vector<bool>).
  * \todo Create dynamic sized bit vector (true replacement of
@@ -186,6 +239,14 @@ public:
   //! represent the bit vector.
   using RawDataConstAccess = RawDataType const*;
 
+  //! Number of bits covered by one bit of the dirty-region bitmap (see
+  //! \ref track_dirty_regions()).
+  static constexpr size_t DIRTY_REGION_BITS = BitAccess::DIRTY_REGION_BITS;
+
+  //! Size of the header of files containing a bit vector (see
+  //! \c create_file()). The raw data starts at this 64-byte boundary.
+  static constexpr size_t FILE_HEADER_BYTES = 64;
+
 private:
   //! Size of the bit vector in bits.
   size_t bit_size_ = 0;
@@ -195,6 +256,24 @@ private:
   tlx::SimpleVector<RawDataType, tlx::SimpleVectorMode::NoInitNoDestroy> data_;
   //! Pointer to the raw data of the bit vector.
   RawDataPointer raw_data_ = nullptr;
+  //! Bitmap containing one bit per \c DIRTY_REGION_BITS bits that is set if
+  //! a bit in the region has been written (empty if not tracked).
+  std::vector<uint64_t> dirty_;
+  //! Pointer to the dirty-region bitmap or \c nullptr if not tracked.
+  uint64_t* dirty_data_ = nullptr;
+  //! Mapping of the file containing the raw data (if file-backed).
+  FileMapping mapping_;
+
+  //! Magic number at the beginning of files containing a bit vector.
+  static constexpr uint64_t FILE_MAGIC = 0x70617374615f6276ULL;
+
+  //! Header at the beginning of files containing a bit vector.
+  struct FileHeader {
+    //! \c FILE_MAGIC.
+    uint64_t magic;
+    //! Size of the bit vector in bits.
+    uint64_t bit_size;
+  }; // struct FileHeader
 
 public:
   /*!
@@ -217,9 +296,13 @@ public:
      * pointer to data.
      * \param data Pointer to the beginning of the \c BitVector.
      * \param position Position the iterator is pointing at.
+     * \param dirty Bitmap of modified regions or \c nullptr if
+     * modifications are not tracked.
      */
-    Iterator(uint64_t* const data, size_t const position) noexcept
-        : bit_access_(data, position) {}
+    Iterator(uint64_t* const data,
+             size_t const position,
+             uint64_t* const dirty = nullptr) noexcept
+        : bit_access_(data, position, dirty) {}
 
     /*!
      * \brief Iterator is dereferenceable. Obtain value it is pointing at.
@@ -270,18 +353,171 @@ public:
     BitAccess bit_access_;
   }; // struct BitVector::Iterator
 
+  /*!
+   * \brief Maximal run of equal bits in a \c BitVector.
+   */
+  struct Run {
+    //! Position of the first bit of the run.
+    size_t start;
+    //! Number of bits in the run.
+    size_t length;
+    //! Value of all bits in the run.
+    bool value;
+  }; // struct BitVector::Run
+
+  /*!
+   * \brief Iterator over all maximal runs of equal bits in a \c BitVector.
+   *
+   * The end of each run is found using \c find_next0() or \c find_next1(),
+   * i.e., long runs are skipped word-wise.
+   */
+  class RunIterator {
+  public:
+    //! Iterator category.
+    using iterator_category = std::forward_iterator_tag;
+    //! Difference type.
+    using difference_type = std::ptrdiff_t;
+    //! Value type.
+    using value_type = Run;
+
+    /*!
+     * \brief Constructor. Creates an iterator pointing at the run starting
+     * at a specific position.
+     * \param bv \c BitVector whose runs are enumerated.
+     * \param position Position where the run starts.
+     */
+    RunIterator(BitVector const* bv, size_t const position) noexcept
+        : bv_(bv),
+          run_{position, 0, false} {
+      find_run_end();
+    }
+
+    //! Returns the current run.
+    Run const& operator*() const noexcept {
+      return run_;
+    }
+
+    //! Returns a pointer to the current run.
+    Run const* operator->() const noexcept {
+      return &run_;
+    }
+
+    //! Prefix increment.
+    RunIterator& operator++() noexcept {
+      run_.start += run_.length;
+      find_run_end();
+      return *this;
+    }
+
+    //! Postfix increment.
+    RunIterator operator++(int32_t) noexcept {
+      auto tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    //! Iterator comparison equality.
+    friend bool operator==(RunIterator const& a,
+                           RunIterator const& b) noexcept {
+      return a.run_.start == b.run_.start;
+    }
+
+    //! Iterator comparison inequality.
+    friend bool operator!=(RunIterator const& a,
+                           RunIterator const& b) noexcept {
+      return a.run_.start != b.run_.start;
+    }
+
+  private:
+    //! Computes length and value of the run starting at \c run_.start.
+    void find_run_end() noexcept {
+      if (run_.start >= bv_->size()) {
+        run_.length = 0;
+        return;
+      }
+      run_.value = (*bv_)[run_.start];
+      size_t const end = run_.value ? bv_->find_from<false>(run_.start) :
+                                      bv_->find_from<true>(run_.start);
+      run_.length = end - run_.start;
+    }
+
+    //! \c BitVector whose runs are enumerated.
+    BitVector const* bv_;
+    //! The current run.
+    Run run_;
+  }; // class BitVector::RunIterator
+
+  /*!
+   * \brief Range of all maximal runs of equal bits in a \c BitVector
+   * (see \c runs()).
+   */
+  class Runs {
+  public:
+    /*!
+     * \brief Constructor.
+     * \param bv \c BitVector whose runs are enumerated.
+     */
+    explicit Runs(BitVector const* bv) noexcept : bv_(bv) {}
+
+    //! Iterator pointing at the first run.
+    RunIterator begin() const noexcept {
+      return RunIterator(bv_, 0);
+    }
+
+    //! Iterator representing the end of the runs.
+    RunIterator end() const noexcept {
+      return RunIterator(bv_, bv_->size());
+    }
+
+  private:
+    //! \c BitVector whose runs are enumerated.
+    BitVector const* bv_;
+  }; // class BitVector::Runs
+
   //! Default empty constructor.
   BitVector() = default;
 
   //! Default  move constructor.
   BitVector(BitVector&&) = default;
 
-  //! Default copy constructor.
-  BitVector(BitVector const&) = default;
+  /*!
+   * \brief Copy constructor. Copies the words of another bit vector using a
+   * single thread (see \c clone() for a parallel copy).
+   * The copy is always stored in anonymous memory.
+   * \param other Bit vector that is copied.
+   */
+  BitVector(BitVector const& other) : BitVector(other.bit_size_) {
+    copy_words(other);
+    copy_dirty_regions(other);
+  }
 
-  //! Deleted copy assignment, due to \c SimpleVector not supporting copy
-  //! assignment.
-  BitVector& operator=(BitVector const&) = delete;
+  /*!
+   * \brief Copy assignment. The existing allocation is reused if it has the
+   * same number of words as \c other. A file-backed bit vector stays
+   * file-backed, i.e., the file is resized if required.
+   * \param other Bit vector that is copied.
+   * \return This after the bit vector has been copied.
+   */
+  BitVector& operator=(BitVector const& other) {
+    if (this == &other) {
+      return *this;
+    }
+    // A default-constructed bit vector has no words, but a copy always
+    // contains at least one word (like a bit vector of size 0).
+    size_t const words = (other.bit_size_ >> 6) + 1;
+    if (is_file_backed()) {
+      resize_storage(other.bit_size_);
+    } else if (size_ != words) {
+      size_ = words;
+      data_ = tlx::SimpleVector<RawDataType,
+                                tlx::SimpleVectorMode::NoInitNoDestroy>(size_);
+      raw_data_ = data_.data();
+    }
+    bit_size_ = other.bit_size_;
+    copy_words(other);
+    copy_dirty_regions(other);
+    return *this;
+  }
 
   //! Default move assignment.
   BitVector& operator=(BitVector&&) = default;
@@ -310,13 +546,74 @@ public:
     std::fill_n(raw_data_, size_, fill_value);
   }
 
+  /*!
+   * \brief Creates a bit vector that is stored in a new file, which is
+   * mapped into memory (shared, i.e., all writes go to the file).
+   * \param path Path of the file.
+   * \param size Number of bits the bit vector contains.
+   * \param init_value Value all bits initially are set to.
+   * \return The file-backed bit vector or \c std::nullopt if the file
+   * already exists or could not be created.
+   */
+  [[nodiscard("created bit vector not used")]] static std::optional<BitVector>
+  create_file(std::string const& path,
+              size_t const size,
+              bool const init_value = false) {
+    size_t const words = (size >> 6) + 1;
+    auto mapping = FileMapping::create(
+        path,
+        FILE_HEADER_BYTES + (words * sizeof(RawDataType)));
+    if (!mapping.has_value()) {
+      return std::nullopt;
+    }
+    BitVector result;
+    result.mapping_ = std::move(*mapping);
+    result.attach_mapping(size);
+    result.write_file_header();
+    if (init_value) {
+      std::fill_n(result.raw_data_, result.size_, ~(0ULL));
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Opens a bit vector that has been stored in a file using
+   * \c create_file() before. The file is mapped into memory (shared, i.e.,
+   * all writes go to the file). Opening the file does not modify it.
+   * \param path Path of the file.
+   * \param read_only If \c true, the file is opened and mapped read-only,
+   * i.e., only read permission is required. The bit vector must not be
+   * modified or resized then (writes to the mapping crash the program).
+   * \return The file-backed bit vector or \c std::nullopt if the file does
+   * not exist, cannot be opened, or does not contain a bit vector.
+   */
+  [[nodiscard("opened bit vector not used")]] static std::optional<BitVector>
+  open_file(std::string const& path, bool const read_only = false) {
+    auto mapping = FileMapping::open_existing(path, !read_only);
+    if (!mapping.has_value() || mapping->size() < FILE_HEADER_BYTES) {
+      return std::nullopt;
+    }
+    FileHeader const& header =
+        *static_cast<FileHeader const*>(mapping->data());
+    size_t const expected_size =
+        FILE_HEADER_BYTES + (((header.bit_size >> 6) + 1) * sizeof(uint64_t));
+    if (header.magic != FILE_MAGIC || mapping->size() != expected_size) {
+      return std::nullopt;
+    }
+    BitVector result;
+    size_t const bit_size = header.bit_size;
+    result.mapping_ = std::move(*mapping);
+    result.attach_mapping(bit_size);
+    return result;
+  }
+
   /*!
    * \brief Access operator to read/write to a bit of the bit vector.
    * \param index Index of the bit to be read/write to in the bit vector.
    * \return \c BitAccess that allows to access to a single bit.
    */
   BitAccess operator[](size_t const index) noexcept {
-    return BitAccess(raw_data_, index);
+    return BitAccess(raw_data_, index, dirty_data_);
   }
 
   /*!
@@ -330,13 +627,16 @@ public:
 
   /*!
    * \brief Resize the bit vector to contain \c size bits.
+   *
+   * If the bit vector is file-backed, the file is resized and mapped again,
+   * i.e., the raw data may move. Failing to resize the file is treated like
+   * a failed allocation.
    * \param size Number of bits the resized bit vector contains.
    */
   void resize(size_t const size) noexcept {
-    bit_size_ = size;
-    size_ = (bit_size_ >> 6) + 1;
-    data_.resize(size_);
-    raw_data_ = data_.data();
+    size_t const old_bit_size = bit_size_;
+    resize_storage(size);
+    resize_dirty_regions(old_bit_size);
   }
 
   /*!
@@ -347,10 +647,8 @@ public:
    */
   void resize(size_t const size, bool const init_value) noexcept {
     size_t const old_bit_size = bit_size_;
-    bit_size_ = size;
-    size_ = (bit_size_ >> 6) + 1;
-    data_.resize(size_);
-    raw_data_ = data_.data();
+    resize_storage(size);
+    resize_dirty_regions(old_bit_size);
 
     if (old_bit_size < bit_size_) {
       size_t max_bitwise = std::min(bit_size_, ((old_bit_size + 63) / 64) * 64);
@@ -368,7 +666,7 @@ public:
    * \return Iterator representing the first element of the \c BitVector.
    */
   Iterator begin() noexcept {
-    return Iterator(raw_data_, 0);
+    return Iterator(raw_data_, 0, dirty_data_);
   }
 
   /*!
@@ -379,7 +677,7 @@ public:
    * \return Iterator representing the end of the \c BitVector.
    */
   Iterator end() noexcept {
-    return Iterator(raw_data_, bit_size_);
+    return Iterator(raw_data_, bit_size_, dirty_data_);
   }
 
   /*!
@@ -417,13 +715,487 @@ public:
     return raw_data_[index];
   }
 
+  /*!
+   * \brief Enable or disable tracking of modified regions.
+   *
+   * If enabled, each write through \c operator[] or the iterators sets a bit
+   * in a bitmap that covers \c DIRTY_REGION_BITS bits of the bit vector per
+   * bit, i.e., the bitmap requires one bit per L1-block of \ref FlatRank.
+   * Rank and select support can use the bitmap to recompute only the
+   * information of modified regions (see \ref FlatRank::refresh()). Writes
+   * to the raw data (see \ref data()) are not tracked and have to be marked
+   * using \ref mark_dirty(). Enabling the tracking clears all marks.
+   * \param enable Whether modifications should be tracked.
+   */
+  void track_dirty_regions(bool const enable = true) {
+    if (enable) {
+      dirty_.assign((num_dirty_regions() + 63) / 64, 0ULL);
+      dirty_data_ = dirty_.data();
+    } else {
+      dirty_.clear();
+      dirty_.shrink_to_fit();
+      dirty_data_ = nullptr;
+    }
+  }
+
+  /*!
+   * \brief Check whether modified regions are tracked.
+   * \return \c true if modified regions are tracked.
+   */
+  [[nodiscard("tracks_dirty_regions computed but not used")]] bool
+  tracks_dirty_regions() const noexcept {
+    return dirty_data_ != nullptr;
+  }
+
+  /*!
+   * \brief Access the bitmap of modified regions.
+   *
+   * Bit \c i (bit \c i % 64 of word \c i / 64) is set if a bit in
+   * [i * DIRTY_REGION_BITS, (i + 1) * DIRTY_REGION_BITS) has been written
+   * since the tracking has been enabled or the marks have been cleared.
+   * \return Bitmap of modified regions (empty if not tracked).
+   */
+  std::span<uint64_t const> dirty_regions() const noexcept {
+    return std::span{dirty_.data(), dirty_.size()};
+  }
+
+  /*!
+   * \brief Mark all regions overlapping a range of bits as modified, e.g.,
+   * after the raw data has been written directly. Does nothing if modified
+   * regions are not tracked.
+   * \param begin First modified bit.
+   * \param end Bit after the last modified bit.
+   */
+  void mark_dirty(size_t const begin, size_t const end) noexcept {
+    if (dirty_data_ == nullptr || begin >= end) {
+      return;
+    }
+    size_t const last = std::min((end - 1) / DIRTY_REGION_BITS,
+                                 num_dirty_regions() - 1);
+    for (size_t region = begin / DIRTY_REGION_BITS; region <= last;
+         ++region) {
+      dirty_data_[region / 64] |= 1ULL << (region % 64);
+    }
+  }
+
+  //! Clear all marks of modified regions, e.g., after all rank and select
+  //! support of the bit vector has been refreshed.
+  void clear_dirty_regions() noexcept {
+    std::fill(dirty_.begin(), dirty_.end(), 0ULL);
+  }
+
+  /*!
+   * \brief Check whether the bit vector is stored in a file (see
+   * \c create_file() and \c open_file()).
+   * \return \c true if the bit vector is file-backed.
+   */
+  [[nodiscard("is_file_backed computed but not used")]] bool
+  is_file_backed() const noexcept {
+    return mapping_.is_mapped();
+  }
+
+  /*!
+   * \brief Write all modified words in a range of bits (and the header
+   * containing the size of the bit vector) of a file-backed bit vector to
+   * the file (see \c msync()). Does nothing if the bit vector is not
+   * file-backed.
+   *
+   * The range is extended to whole pages.
+   * \param begin First bit of the range.
+   * \param end Bit after the last bit of the range.
+   * \param async If \c true, the writes are only scheduled and the function
+   * returns immediately. Otherwise, it returns after the data is written.
+   * \return \c true on success.
+   */
+  bool flush(size_t const begin, size_t const end, bool const async = false) {
+    if (!is_file_backed()) {
+      return true;
+    }
+    auto const [first, last] = byte_range(begin, end);
+    return mapping_.sync(0, FILE_HEADER_BYTES, async) &&
+           mapping_.sync(first, last, async);
+  }
+
+  /*!
+   * \brief Write all modified words of a file-backed bit vector to the file.
+   * \param async See \ref flush(size_t, size_t, bool).
+   * \return \c true on success.
+   */
+  bool flush(bool const async = false) {
+    return flush(0, bit_size_, async);
+  }
+
+  /*!
+   * \brief Gives the operating system a hint about the expected access
+   * pattern of a range of bits of a file-backed bit vector (see
+   * \c madvise()), e.g., \c AccessPattern::RANDOM to avoid reading ahead
+   * when answering random rank and select queries, or
+   * \c AccessPattern::SEQUENTIAL before constructing rank and select
+   * support. Does nothing if the bit vector is not file-backed.
+   * \param pattern The expected access pattern.
+   * \param begin First bit of the range.
+   * \param end Bit after the last bit of the range.
+   * \return \c true on success.
+   */
+  bool advise(AccessPattern const pattern,
+              size_t const begin,
+              size_t const end) {
+    if (!is_file_backed()) {
+      return true;
+    }
+    auto const [first, last] = byte_range(begin, end);
+    return mapping_.advise(pattern, first, last);
+  }
+
+  /*!
+   * \brief Gives the operating system a hint about the expected access
+   * pattern of the whole file-backed bit vector.
+   * \param pattern The expected access pattern.
+   * \return \c true on success.
+   */
+  bool advise(AccessPattern const pattern) {
+    return advise(pattern, 0, bit_size_);
+  }
+
+  /*!
+   * \brief Find the first set bit.
+   * \return Position of the first set bit or \c size() if there is none.
+   */
+  [[nodiscard("find_first1 computed but not used")]] size_t
+  find_first1() const noexcept {
+    return find_from<true>(0);
+  }
+
+  /*!
+   * \brief Find the first unset bit.
+   * \return Position of the first unset bit or \c size() if there is none.
+   */
+  [[nodiscard("find_first0 computed but not used")]] size_t
+  find_first0() const noexcept {
+    return find_from<false>(0);
+  }
+
+  /*!
+   * \brief Find the next set bit after a position.
+   *
+   * Uses \c tzcnt within a 64-bit word and skips words without set bits
+   * 512 bits at a time (see \ref find_next_word_not()).
+   * \param index Position after which the next set bit is searched.
+   * \return Position of the first set bit after \c index or \c size() if
+   * there is none.
+   */
+  [[nodiscard("find_next1 computed but not used")]] size_t
+  find_next1(size_t const index) const noexcept {
+    // Avoid the overflow of index + 1 (e.g., for index == SIZE_MAX).
+    if (index >= bit_size_) {
+      return bit_size_;
+    }
+    return find_from<true>(index + 1);
+  }
+
+  /*!
+   * \brief Find the next unset bit after a position.
+   * \param index Position after which the next unset bit is searched.
+   * \return Position of the first unset bit after \c index or \c size() if
+   * there is none.
+   */
+  [[nodiscard("find_next0 computed but not used")]] size_t
+  find_next0(size_t const index) const noexcept {
+    // Avoid the overflow of index + 1 (e.g., for index == SIZE_MAX).
+    if (index >= bit_size_) {
+      return bit_size_;
+    }
+    return find_from<false>(index + 1);
+  }
+
+  /*!
+   * \brief Find the previous set bit before a position.
+   *
+   * Uses \c lzcnt within a 64-bit word and skips words without set bits
+   * 512 bits at a time (see \ref find_prev_word_not()).
+   * \param index Position before which the previous set bit is searched.
+   * \return Position of the last set bit before \c index or \c size() if
+   * there is none.
+   */
+  [[nodiscard("find_prev1 computed but not used")]] size_t
+  find_prev1(size_t const index) const noexcept {
+    return find_before<true>(index);
+  }
+
+  /*!
+   * \brief Find the previous unset bit before a position.
+   * \param index Position before which the previous unset bit is searched.
+   * \return Position of the last unset bit before \c index or \c size() if
+   * there is none.
+   */
+  [[nodiscard("find_prev0 computed but not used")]] size_t
+  find_prev0(size_t const index) const noexcept {
+    return find_before<false>(index);
+  }
+
+  /*!
+   * \brief Find the first run of at least \c k consecutive unset bits
+   * starting at or after a position.
+   *
+   * Runs inside a 64-bit word are found using shift-and operations, runs
+   * crossing word boundaries are found using \c tzcnt and \c lzcnt. Words
+   * without unset bits are skipped 512 bits at a time (see
+   * \ref find_next_word_not()).
+   * \param k Minimum length of the run.
+   * \param from Position the search starts at (inclusive).
+   * \return Position of the first bit of the first such run or \c size() if
+   * there is none.
+   */
+  [[nodiscard("find_zero_run computed but not used")]] size_t
+  find_zero_run(size_t const k, size_t const from = 0) const noexcept {
+    return find_run<false>(k, from);
+  }
+
+  /*!
+   * \brief Find the first run of at least \c k consecutive set bits starting
+   * at or after a position.
+   * \param k Minimum length of the run.
+   * \param from Position the search starts at (inclusive).
+   * \return Position of the first bit of the first such run or \c size() if
+   * there is none.
+   */
+  [[nodiscard("find_one_run computed but not used")]] size_t
+  find_one_run(size_t const k, size_t const from = 0) const noexcept {
+    return find_run<true>(k, from);
+  }
+
+  /*!
+   * \brief Enumerate all maximal runs of equal bits.
+   *
+   * \code{.cpp}
+   * for (auto const& run : bv.runs()) {
+   *   std::cout << run.start << " " << run.length << " " << run.value;
+   * }
+   * \endcode
+   * \return Range of all maximal runs (\ref Run) in increasing order.
+   */
+  [[nodiscard("runs computed but not used")]] Runs runs() const noexcept {
+    return Runs(this);
+  }
+
+  /*!
+   * \brief Find all occurrences of a short bit pattern.
+   *
+   * All 64 possible starting positions within a 64-bit word are checked at
+   * once (see \ref match_pattern()), i.e., the bit vector is scanned word by
+   * word.
+   * \param pattern The pattern, where the i-th least significant bit is the
+   * i-th bit of the pattern.
+   * \param length Length of the pattern in bits (between 1 and 64).
+   * \return All positions where the pattern starts in increasing order.
+   * Occurrences may overlap.
+   */
+  [[nodiscard("find_pattern computed but not used")]] std::vector<size_t>
+  find_pattern(uint64_t const pattern, size_t const length) const {
+    std::vector<size_t> result;
+    if (length == 0 || length > bit_size_) {
+      return result;
+    }
+    find_pattern_in_words(pattern,
+                          length,
+                          0,
+                          ((bit_size_ - length) / 64) + 1,
+                          result);
+    return result;
+  }
+
+  /*!
+   * \brief Find all occurrences of a short bit pattern using multiple
+   * threads.
+   *
+   * The words of the bit vector are split into one chunk per thread. Each
+   * thread reports all occurrences starting in its chunk, which includes
+   * occurrences crossing the chunk border, as the word following the chunk
+   * is also read. Without OpenMP, this is equivalent to \c find_pattern().
+   * \param pattern The pattern, where the i-th least significant bit is the
+   * i-th bit of the pattern.
+   * \param length Length of the pattern in bits (between 1 and 64).
+   * \return All positions where the pattern starts in increasing order.
+   * Occurrences may overlap.
+   */
+  [[nodiscard("find_pattern_parallel computed but not used")]] std::vector<
+      size_t>
+  find_pattern_parallel(uint64_t const pattern, size_t const length) const {
+    if (length == 0 || length > bit_size_) {
+      return {};
+    }
+    size_t const num_words = ((bit_size_ - length) / 64) + 1;
+#if defined(_OPENMP)
+    size_t const num_chunks = std::min<size_t>(
+        static_cast<size_t>(omp_get_max_threads()), num_words);
+#else
+    size_t const num_chunks = 1;
+#endif
+    std::vector<std::vector<size_t>> chunk_results(num_chunks);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      find_pattern_in_words(pattern,
+                            length,
+                            (num_words * chunk) / num_chunks,
+                            (num_words * (chunk + 1)) / num_chunks,
+                            chunk_results[chunk]);
+    }
+
+    if (num_chunks == 1) {
+      return std::move(chunk_results[0]);
+    }
+    std::vector<size_t> result;
+    size_t total = 0;
+    for (auto const& chunk_result : chunk_results) {
+      total += chunk_result.size();
+    }
+    result.reserve(total);
+    for (auto const& chunk_result : chunk_results) {
+      result.insert(result.end(), chunk_result.begin(), chunk_result.end());
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Create a copy of the bit vector using multiple threads.
+   *
+   * The words are split into one chunk of whole memory pages per thread.
+   * Each thread copies its chunk using non-temporal stores (see
+   * \ref stream_copy_words()). Since the memory of the copy is not
+   * initialized before, each page is first touched by the thread copying it,
+   * i.e., the pages are spread across the NUMA nodes of the threads. Without
+   * OpenMP, the words are copied by a single thread. The copy is always
+   * stored in anonymous memory.
+   * \param threads Number of threads used for copying (0 uses the maximum
+   * number of OpenMP threads).
+   * \return Copy of this bit vector.
+   */
+  [[nodiscard("clone computed but not used")]] BitVector
+  clone([[maybe_unused]] size_t const threads = 0) const {
+    // Words per 4 KiB page.
+    constexpr size_t page_words = 512;
+    BitVector result(bit_size_);
+    size_t const num_pages = (size_ + page_words - 1) / page_words;
+#if defined(_OPENMP)
+    size_t const num_chunks = std::max<size_t>(
+        1,
+        std::min<size_t>((threads == 0) ?
+                             static_cast<size_t>(omp_get_max_threads()) :
+                             threads,
+                         num_pages));
+#else
+    size_t const num_chunks = 1;
+#endif
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1) num_threads(num_chunks)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      size_t const begin = ((num_pages * chunk) / num_chunks) * page_words;
+      size_t const end = std::min(
+          ((num_pages * (chunk + 1)) / num_chunks) * page_words,
+          size_);
+      stream_copy_words(raw_data_ + begin,
+                        result.raw_data_ + begin,
+                        end - begin);
+    }
+    // Only a default-constructed bit vector has fewer words than the clone.
+    std::fill(result.raw_data_ + size_, result.raw_data_ + result.size_, 0ULL);
+    result.copy_dirty_regions(*this);
+    return result;
+  }
+
+  /*!
+   * \brief Read the bits at multiple (random) positions.
+   *
+   * The positions are processed in blocks of 64 using \ref gather_bits(),
+   * i.e., the words of later positions are prefetched and, with AVX-512, the
+   * words of eight positions are gathered at once. This way, the cache misses
+   * of different positions overlap.
+   * \param positions Positions of the bits that are read (each smaller than
+   * \c size()).
+   * \param out Span with at least \c positions.size() elements, where the
+   * i-th element is set to the bit at position \c positions[i] (0 or 1).
+   */
+  void get_bits(std::span<size_t const> const positions,
+                std::span<uint8_t> const out) const {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output span is smaller than number of positions.");
+    gather_blocks(positions,
+                  0,
+                  (positions.size() + 63) / 64,
+                  ByteWriter{out.data()});
+  }
+
+  /*!
+   * \brief Read the bits at multiple (random) positions into a bit vector.
+   *
+   * Same as \ref get_bits() but the bits are written to a \c BitVector one
+   * 64-bit word at a time. Bits of \c out after position
+   * \c positions.size() - 1 are not changed.
+   * \param positions Positions of the bits that are read (each smaller than
+   * \c size()).
+   * \param out Bit vector with at least \c positions.size() bits (different
+   * from this bit vector), where the i-th bit is set to the bit at position
+   * \c positions[i].
+   */
+  void get_bits(std::span<size_t const> const positions,
+                BitVector& out) const {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output bit vector is smaller than number of positions.");
+    gather_blocks(positions,
+                  0,
+                  (positions.size() + 63) / 64,
+                  WordWriter{out.raw_data_});
+    out.mark_dirty(0, positions.size());
+  }
+
+  /*!
+   * \brief Read the bits at multiple (random) positions using multiple
+   * threads.
+   *
+   * The blocks of 64 positions are split into one chunk per thread, i.e.,
+   * different threads never write to the same output word. Without OpenMP,
+   * this is equivalent to \c get_bits().
+   * \param positions Positions of the bits that are read (each smaller than
+   * \c size()).
+   * \param out Span with at least \c positions.size() elements, where the
+   * i-th element is set to the bit at position \c positions[i] (0 or 1).
+   */
+  void get_bits_parallel(std::span<size_t const> const positions,
+                         std::span<uint8_t> const out) const {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output span is smaller than number of positions.");
+    gather_blocks_parallel(positions, ByteWriter{out.data()});
+  }
+
+  /*!
+   * \brief Read the bits at multiple (random) positions into a bit vector
+   * using multiple threads.
+   *
+   * Parallel version of \ref get_bits() writing to a \c BitVector.
+   * \param positions Positions of the bits that are read (each smaller than
+   * \c size()).
+   * \param out Bit vector with at least \c positions.size() bits (different
+   * from this bit vector), where the i-th bit is set to the bit at position
+   * \c positions[i].
+   */
+  void get_bits_parallel(std::span<size_t const> const positions,
+                         BitVector& out) const {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output bit vector is smaller than number of positions.");
+    gather_blocks_parallel(positions, WordWriter{out.raw_data_});
+    out.mark_dirty(0, positions.size());
+  }
+
   /*!
    * \brief Estimate for the space usage.
    * \return Number of bytes used by this data structure.
    */
   [[nodiscard("space usage computed but not used")]] size_t
   space_usage() const {
-    return (data_.size() * sizeof(RawDataType)) + sizeof(*this);
+    return (size_ * sizeof(RawDataType)) + sizeof(*this);
   }
 
   /*!
@@ -442,6 +1214,365 @@ public:
     return os;
   }
 
+private:
+  /*!
+   * \brief Use the mapped file as storage of the raw data. The file's header
+   * is not modified (see \c write_file_header()).
+   * \param bit_size Size of the bit vector in bits.
+   */
+  void attach_mapping(size_t const bit_size) noexcept {
+    bit_size_ = bit_size;
+    size_ = (bit_size_ >> 6) + 1;
+    raw_data_ = reinterpret_cast<RawDataPointer>(
+        static_cast<char*>(mapping_.data()) + FILE_HEADER_BYTES);
+  }
+
+  //! Store the size of the bit vector in the header of the mapped file.
+  void write_file_header() noexcept {
+    auto* const header = static_cast<FileHeader*>(mapping_.data());
+    header->magic = FILE_MAGIC;
+    header->bit_size = bit_size_;
+  }
+
+  /*!
+   * \brief Change the number of bits (and words) of the storage, i.e., the
+   * allocated memory or the mapped file. The content of new words is
+   * undefined.
+   * \param bit_size New size of the bit vector in bits.
+   */
+  void resize_storage(size_t const bit_size) {
+    if (is_file_backed()) {
+      size_t const words = (bit_size >> 6) + 1;
+      if (!mapping_.resize(FILE_HEADER_BYTES +
+                           (words * sizeof(RawDataType)))) {
+        throw std::bad_alloc();
+      }
+      attach_mapping(bit_size);
+      write_file_header();
+      return;
+    }
+    bit_size_ = bit_size;
+    size_ = (bit_size_ >> 6) + 1;
+    data_.resize(size_);
+    raw_data_ = data_.data();
+  }
+
+  /*!
+   * \brief Get the range of bytes of the mapped file that contains a range
+   * of bits.
+   * \param begin First bit of the range.
+   * \param end Bit after the last bit of the range.
+   * \return Offsets (in bytes) of the first byte and after the last byte.
+   */
+  std::pair<size_t, size_t> byte_range(size_t const begin,
+                                       size_t const end) const noexcept {
+    size_t const first_word = std::min(begin / 64, size_);
+    size_t const last_word = std::min((end + 63) / 64, size_);
+    return {FILE_HEADER_BYTES + (first_word * sizeof(RawDataType)),
+            FILE_HEADER_BYTES + (last_word * sizeof(RawDataType))};
+  }
+
+  //! Number of regions covered by the dirty-region bitmap.
+  size_t num_dirty_regions() const noexcept {
+    return (size_ + 63) / 64;
+  }
+
+  /*!
+   * \brief Copy the words of another bit vector that has at most as many
+   * words as this bit vector. Words that \c other does not have (only if
+   * it is default-constructed) are set to zero.
+   * \param other Bit vector whose words are copied.
+   */
+  void copy_words(BitVector const& other) {
+    size_t const words = std::min(size_, other.size_);
+    std::copy_n(other.raw_data_, words, raw_data_);
+    std::fill(raw_data_ + words, raw_data_ + size_, 0ULL);
+  }
+
+  /*!
+   * \brief Copy the dirty-region bitmap (and whether modified regions are
+   * tracked) of another bit vector.
+   * \param other Bit vector whose bitmap is copied.
+   */
+  void copy_dirty_regions(BitVector const& other) {
+    dirty_ = other.dirty_;
+    dirty_data_ = other.tracks_dirty_regions() ? dirty_.data() : nullptr;
+  }
+
+  /*!
+   * \brief Adjust the dirty-region bitmap after the bit vector has been
+   * resized. All regions starting at the smaller of both ends are marked as
+   * modified.
+   * \param old_bit_size Size of the bit vector (in bits) before resizing.
+   */
+  void resize_dirty_regions(size_t const old_bit_size) {
+    if (dirty_data_ == nullptr) {
+      return;
+    }
+    size_t const num_regions = num_dirty_regions();
+    dirty_.resize((num_regions + 63) / 64, 0ULL);
+    if (num_regions % 64 != 0) {
+      dirty_.back() &= (1ULL << (num_regions % 64)) - 1;
+    }
+    dirty_data_ = dirty_.data();
+    mark_dirty(std::min(old_bit_size, bit_size_),
+               num_regions * DIRTY_REGION_BITS);
+  }
+
+  /*!
+   * \brief Find the first bit with a specific value at or after a position.
+   * \tparam value Value of the bit that is searched.
+   * \param index Position the search starts at (inclusive).
+   * \return Position of the first bit equal to \c value at or after
+   * \c index or \c size() if there is none.
+   */
+  template <bool value>
+  size_t find_from(size_t const index) const noexcept {
+    if (index >= bit_size_) {
+      return bit_size_;
+    }
+    constexpr uint64_t skip = value ? 0ULL : ~0ULL;
+    size_t word_pos = index / 64;
+    uint64_t word = (raw_data_[word_pos] ^ skip) & (~0ULL << (index % 64));
+    if (word == 0ULL) {
+      size_t const used_words = (bit_size_ + 63) / 64;
+      word_pos = find_next_word_not<skip>(raw_data_, word_pos + 1, used_words);
+      if (word_pos == used_words) {
+        return bit_size_;
+      }
+      word = raw_data_[word_pos] ^ skip;
+    }
+    // Bits after the end of the bit vector are not initialized and might
+    // be reported here.
+    return std::min((word_pos * 64) + std::countr_zero(word), bit_size_);
+  }
+
+  /*!
+   * \brief Find the last bit with a specific value before a position.
+   * \tparam value Value of the bit that is searched.
+   * \param index Position the search ends at (exclusive).
+   * \return Position of the last bit equal to \c value before \c index or
+   * \c size() if there is none.
+   */
+  template <bool value>
+  size_t find_before(size_t index) const noexcept {
+    index = std::min(index, bit_size_);
+    if (index == 0) {
+      return bit_size_;
+    }
+    constexpr uint64_t skip = value ? 0ULL : ~0ULL;
+    size_t const last = index - 1;
+    size_t word_pos = last / 64;
+    uint64_t word = (raw_data_[word_pos] ^ skip) &
+                    (~0ULL >> (63 - (last % 64)));
+    if (word == 0ULL) {
+      word_pos = find_prev_word_not<skip>(raw_data_, 0, word_pos);
+      if (word_pos == last / 64) {
+        return bit_size_;
+      }
+      word = raw_data_[word_pos] ^ skip;
+    }
+    return (word_pos * 64) + 63 - std::countl_zero(word);
+  }
+
+  //! Writes blocks of gathered bits to an array with one byte per bit.
+  struct ByteWriter {
+    //! Pointer to the output array.
+    uint8_t* const out;
+
+    /*!
+     * \brief Writes a block of gathered bits.
+     * \param block Index of the block of 64 positions.
+     * \param bits The gathered bits.
+     * \param count Number of valid bits in \c bits.
+     */
+    void operator()(size_t const block,
+                    uint64_t const bits,
+                    size_t const count) const {
+      uint8_t* const block_out = out + (block * 64);
+      for (size_t i = 0; i < count; ++i) {
+        block_out[i] = static_cast<uint8_t>((bits >> i) & 1ULL);
+      }
+    }
+  }; // struct ByteWriter
+
+  //! Writes blocks of gathered bits to the words of a bit vector.
+  struct WordWriter {
+    //! Pointer to the words of the output bit vector.
+    uint64_t* const out;
+
+    /*!
+     * \brief Writes a block of gathered bits.
+     * \param block Index of the block of 64 positions.
+     * \param bits The gathered bits.
+     * \param count Number of valid bits in \c bits.
+     */
+    void operator()(size_t const block,
+                    uint64_t const bits,
+                    size_t const count) const {
+      if (count == 64) {
+        out[block] = bits;
+      } else {
+        uint64_t const mask = (1ULL << count) - 1;
+        out[block] = (out[block] & ~mask) | bits;
+      }
+    }
+  }; // struct WordWriter
+
+  /*!
+   * \brief Read the bits of a range of blocks of 64 positions.
+   * \param positions Positions of the bits that are read.
+   * \param begin_block Index of the first block that is read.
+   * \param end_block Index one past the last block that is read.
+   * \param write Writer that receives the gathered bits of each block.
+   */
+  template <typename Writer>
+  void gather_blocks(std::span<size_t const> const positions,
+                     size_t const begin_block,
+                     size_t const end_block,
+                     Writer const write) const {
+    for (size_t block = begin_block; block < end_block; ++block) {
+      size_t const first = block * 64;
+      size_t const available = positions.size() - first;
+      size_t const count = std::min<size_t>(64, available);
+      write(block,
+            gather_bits(raw_data_, positions.data() + first, count, available),
+            count);
+    }
+  }
+
+  /*!
+   * \brief Read the bits of all blocks of 64 positions using one chunk of
+   * blocks per thread.
+   * \param positions Positions of the bits that are read.
+   * \param write Writer that receives the gathered bits of each block.
+   */
+  template <typename Writer>
+  void gather_blocks_parallel(std::span<size_t const> const positions,
+                              Writer const write) const {
+    size_t const num_blocks = (positions.size() + 63) / 64;
+#if defined(_OPENMP)
+    size_t const num_chunks = std::min<size_t>(
+        static_cast<size_t>(omp_get_max_threads()), num_blocks);
+#else
+    size_t const num_chunks = 1;
+#endif
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      gather_blocks(positions,
+                    (num_blocks * chunk) / num_chunks,
+                    (num_blocks * (chunk + 1)) / num_chunks,
+                    write);
+    }
+  }
+
+  /*!
+   * \brief Find all occurrences of a short bit pattern starting in a range
+   * of words.
+   * \param pattern The pattern (least significant bit first).
+   * \param length Length of the pattern in bits (between 1 and the size of
+   * the bit vector).
+   * \param begin_word First word where occurrences may start.
+   * \param end_word Word after the last word where occurrences may start
+   * (at most the number of words containing valid starting positions).
+   * \param result Vector the starting positions are appended to.
+   */
+  void find_pattern_in_words(uint64_t pattern,
+                             size_t const length,
+                             size_t const begin_word,
+                             size_t const end_word,
+                             std::vector<size_t>& result) const {
+    PASTA_ASSERT(0 < length && length <= 64,
+                 "Pattern length must be between 1 and 64.");
+    if (length < 64) {
+      pattern &= (1ULL << length) - 1;
+    }
+    size_t const last_start = bit_size_ - length;
+    for (size_t word_pos = begin_word; word_pos < end_word; ++word_pos) {
+      // The word after the last word is only required if it exists.
+      uint64_t const next_word =
+          (word_pos + 1 < size_) ? raw_data_[word_pos + 1] : 0ULL;
+      uint64_t matches =
+          match_pattern(raw_data_[word_pos], next_word, pattern, length);
+      if (word_pos == last_start / 64 && last_start % 64 != 63) {
+        matches &= (1ULL << ((last_start % 64) + 1)) - 1;
+      }
+      while (matches != 0ULL) {
+        result.push_back((word_pos * 64) + std::countr_zero(matches));
+        matches &= matches - 1;
+      }
+    }
+  }
+
+  /*!
+   * \brief Find the first run of at least \c k bits with a specific value
+   * starting at or after a position.
+   * \tparam value Value of the bits in the run.
+   * \param k Minimum length of the run.
+   * \param from Position the search starts at (inclusive).
+   * \return Position of the first bit of the first such run or \c size() if
+   * there is none.
+   */
+  template <bool value>
+  size_t find_run(size_t const k, size_t const from) const noexcept {
+    if (from >= bit_size_ || k > bit_size_ - from) {
+      return bit_size_;
+    }
+    if (k == 0) {
+      return from;
+    }
+    constexpr uint64_t skip = value ? 0ULL : ~0ULL;
+    size_t const first_word = from / 64;
+    size_t const used_words = (bit_size_ + 63) / 64;
+    // Length of the run of bits equal to value that ends at the current
+    // word boundary.
+    size_t run = 0;
+    for (size_t word_pos = first_word; word_pos < used_words; ++word_pos) {
+      // Bits equal to value are ones in word.
+      uint64_t word = raw_data_[word_pos] ^ skip;
+      if (word_pos == first_word) {
+        word &= ~0ULL << (from % 64);
+      }
+      if (word_pos + 1 == used_words && bit_size_ % 64 != 0) {
+        word &= (1ULL << (bit_size_ % 64)) - 1;
+      }
+
+      if (word == ~0ULL) {
+        if ((run += 64) >= k) {
+          return ((word_pos + 1) * 64) - run;
+        }
+        continue;
+      }
+      if (word == 0ULL) {
+        run = 0;
+        word_pos =
+            find_next_word_not<skip>(raw_data_, word_pos + 1, used_words) - 1;
+        continue;
+      }
+      // Run crossing the word boundary.
+      if (run + std::countr_one(word) >= k) {
+        return (word_pos * 64) - run;
+      }
+      // Run within the word: after the loop, the i-th bit of starts is set iff
+      // bits i to i + k - 1 of word are set.
+      if (k < 64) {
+        uint64_t starts = word;
+        for (size_t length = 1; length < k && starts != 0ULL;) {
+          size_t const shift = std::min(length, k - length);
+          starts &= starts >> shift;
+          length += shift;
+        }
+        if (starts != 0ULL) {
+          return (word_pos * 64) + std::countr_zero(starts);
+        }
+      }
+      run = std::countl_one(word);
+    }
+    return bit_size_;
+  }
+
 }; // class BitVector
 
 //! \}
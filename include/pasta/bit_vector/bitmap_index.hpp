@@ -0,0 +1,422 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Bitmap index over an integer column supporting equality and range
+ * predicates.
+ *
+ * The column contains (dictionary encoded) values in \f$[0, c)\f$. For each
+ * value \f$v\f$, the equality-encoded bitmap marks all rows with value
+ * \f$v\f$. Optionally, for each value \f$v < c - 1\f$, the range-encoded
+ * bitmap marks all rows with value at most \f$v\f$, such that each range
+ * predicate touches at most two bitmaps. All bitmaps are \ref BitVector with
+ * \ref FlatRank support, which is used to count the matching rows (within a
+ * prefix of the rows).
+ *
+ * Optionally, sparse equality-encoded bitmaps (with fewer ones than words)
+ * are compressed, i.e., stored as sorted list of rows, which is the case for
+ * most values of high-cardinality columns.
+ */
+class BitmapIndex {
+  //! Type of the rank support used to count matching rows.
+  using RankType = FlatRank<OptimizedFor::ONE_QUERIES, BitVector>;
+
+  //! Number of rows.
+  size_t size_ = 0;
+  //! Number of distinct values (largest value plus one).
+  size_t cardinality_ = 0;
+  //! Equality-encoded bitmaps (empty if the bitmap is compressed).
+  std::vector<BitVector> equality_;
+  //! Rank support for \c equality_.
+  std::vector<RankType> equality_ranks_;
+  //! Rows of compressed equality-encoded bitmaps (empty otherwise).
+  std::vector<std::vector<size_t>> compressed_;
+  //! Whether the equality-encoded bitmap of each value is compressed.
+  std::vector<bool> is_compressed_;
+  //! Range-encoded bitmaps (empty if there is no range encoding).
+  std::vector<BitVector> range_;
+  //! Rank support for \c range_.
+  std::vector<RankType> range_ranks_;
+
+public:
+  //! Default constructor w/o parameter.
+  BitmapIndex() = default;
+
+  /*!
+   * \brief Constructor. Creates the bitmap index for a column.
+   *
+   * The words of the bitmaps are split into one chunk per thread (if OpenMP
+   * is available). Each thread reads the rows of its words once, computes
+   * the equality-encoded words of all values, and writes them directly.
+   * The range-encoded words are the prefix-ORs of the equality-encoded
+   * words. If compression is enabled, an additional counting pass
+   * determines the sparse values and where each thread writes their rows.
+   * \param column The values of the column (smaller than \c cardinality).
+   * \param cardinality Number of distinct values (0 uses the largest value
+   * plus one).
+   * \param range_encoded Whether range-encoded bitmaps are created.
+   * \param compress_sparse Whether sparse equality-encoded bitmaps are
+   * compressed.
+   */
+  BitmapIndex(std::span<uint32_t const> const column,
+              size_t const cardinality = 0,
+              bool const range_encoded = true,
+              bool const compress_sparse = false)
+      : size_(column.size()),
+        cardinality_(cardinality) {
+    if (cardinality_ == 0 && !column.empty()) {
+      cardinality_ = size_t{*std::max_element(column.begin(), column.end())} +
+                     1;
+    }
+    size_t const num_words = (size_ / 64) + 1;
+#if defined(_OPENMP)
+    size_t const num_chunks = std::min<size_t>(
+        static_cast<size_t>(omp_get_max_threads()), num_words);
+#else
+    size_t const num_chunks = 1;
+#endif
+    auto const chunk_begin = [&](size_t const chunk) {
+      return std::min(((num_words * chunk) / num_chunks) * 64, size_);
+    };
+
+    // Number of occurrences of each value in each chunk (only required to
+    // place the rows of compressed bitmaps).
+    std::vector<std::vector<size_t>> cursors;
+    is_compressed_.resize(cardinality_, false);
+    compressed_.resize(cardinality_);
+    if (compress_sparse) {
+      cursors.resize(num_chunks, std::vector<size_t>(cardinality_, 0));
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+      for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        for (size_t row = chunk_begin(chunk); row < chunk_begin(chunk + 1);
+             ++row) {
+          PASTA_ASSERT(column[row] < cardinality_, "Value out of bounds.");
+          ++cursors[chunk][column[row]];
+        }
+      }
+      for (size_t v = 0; v < cardinality_; ++v) {
+        size_t total = 0;
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+          size_t const count = cursors[chunk][v];
+          cursors[chunk][v] = total;
+          total += count;
+        }
+        is_compressed_[v] = (total < num_words);
+        if (is_compressed_[v]) {
+          compressed_[v].resize(total);
+        }
+      }
+    }
+
+    // The memory of the bit vectors is not initialized, i.e., each word is
+    // first touched by the thread computing it.
+    equality_.reserve(cardinality_);
+    for (size_t v = 0; v < cardinality_; ++v) {
+      equality_.emplace_back(is_compressed_[v] ? 0 : size_);
+    }
+    if (range_encoded && cardinality_ > 1) {
+      range_.reserve(cardinality_ - 1);
+      for (size_t v = 0; v + 1 < cardinality_; ++v) {
+        range_.emplace_back(size_);
+      }
+    }
+
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      std::vector<uint64_t> words(cardinality_);
+      for (size_t w = (num_words * chunk) / num_chunks;
+           w < (num_words * (chunk + 1)) / num_chunks;
+           ++w) {
+        std::fill(words.begin(), words.end(), 0ULL);
+        for (size_t row = w * 64; row < std::min((w + 1) * 64, size_);
+             ++row) {
+          uint32_t const v = column[row];
+          PASTA_ASSERT(v < cardinality_, "Value out of bounds.");
+          words[v] |= 1ULL << (row % 64);
+          if (is_compressed_[v]) {
+            compressed_[v][cursors[chunk][v]++] = row;
+          }
+        }
+        uint64_t prefix_or = 0;
+        for (size_t v = 0; v < cardinality_; ++v) {
+          if (!is_compressed_[v]) {
+            equality_[v].data()[w] = words[v];
+          }
+          prefix_or |= words[v];
+          if (v < range_.size()) {
+            range_[v].data()[w] = prefix_or;
+          }
+        }
+      }
+    }
+
+    equality_ranks_.resize(cardinality_);
+    range_ranks_.resize(range_.size());
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (size_t v = 0; v < cardinality_; ++v) {
+      if (!is_compressed_[v]) {
+        equality_ranks_[v] = RankType(equality_[v]);
+      }
+      if (v < range_.size()) {
+        range_ranks_[v] = RankType(range_[v]);
+      }
+    }
+  }
+
+  //! Default move constructor.
+  BitmapIndex(BitmapIndex&&) = default;
+
+  //! Default move assignment.
+  BitmapIndex& operator=(BitmapIndex&&) = default;
+
+  /*!
+   * \brief Computes all rows with a specific value.
+   * \param value The value.
+   * \return Bit vector marking all rows with value \c value.
+   */
+  [[nodiscard("equal computed but not used")]] BitVector
+  equal(size_t const value) const {
+    if (value >= cardinality_) {
+      return BitVector(size_, false);
+    }
+    if (!is_compressed_[value]) {
+      return equality_[value];
+    }
+    BitVector result(size_, false);
+    auto data = result.data();
+    for (size_t const row : compressed_[value]) {
+      data[row / 64] |= 1ULL << (row % 64);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Computes all rows with a value in a range.
+   *
+   * With range encoding, at most two bitmaps are combined. Otherwise, the
+   * equality-encoded bitmaps of all values in the range are combined.
+   * \param min_value Smallest value in the range.
+   * \param max_value Largest value in the range (inclusive).
+   * \return Bit vector marking all rows with a value in [\c min_value,
+   * \c max_value].
+   */
+  [[nodiscard("range computed but not used")]] BitVector
+  range(size_t const min_value, size_t max_value) const {
+    max_value = std::min(max_value, cardinality_ - 1);
+    if (min_value > max_value || cardinality_ == 0) {
+      return BitVector(size_, false);
+    }
+    if (range_.empty()) {
+      BitVector result(size_, false);
+      auto data = result.data();
+      for (size_t v = min_value; v <= max_value; ++v) {
+        if (is_compressed_[v]) {
+          for (size_t const row : compressed_[v]) {
+            data[row / 64] |= 1ULL << (row % 64);
+          }
+        } else {
+          auto const bitmap = equality_[v].data();
+          for (size_t w = 0; w < data.size(); ++w) {
+            data[w] |= bitmap[w];
+          }
+        }
+      }
+      return result;
+    }
+
+    BitVector result(size_);
+    auto data = result.data();
+    size_t const num_words = data.size();
+    uint64_t const last_mask =
+        (size_ % 64 == 0) ? 0ULL : ((1ULL << (size_ % 64)) - 1);
+    // Rows with value at most max_value (all rows for the largest value).
+    auto const upper = [&](size_t const w) {
+      return (max_value < range_.size()) ? range_[max_value].data(w) :
+             (w + 1 < num_words)         ? ~0ULL :
+                                           last_mask;
+    };
+    if (min_value == 0) {
+      for (size_t w = 0; w < num_words; ++w) {
+        data[w] = upper(w);
+      }
+    } else {
+      auto const lower = range_[min_value - 1].data();
+      for (size_t w = 0; w < num_words; ++w) {
+        data[w] = upper(w) & ~lower[w];
+      }
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Counts the rows with a specific value (in a prefix of the rows).
+   * \param value The value.
+   * \param row_end Only rows before \c row_end are counted.
+   * \return Number of rows before \c row_end with value \c value.
+   */
+  [[nodiscard("count_equal computed but not used")]] size_t
+  count_equal(size_t const value, size_t row_end) const {
+    row_end = std::min(row_end, size_);
+    if (value >= cardinality_) {
+      return 0;
+    }
+    if (is_compressed_[value]) {
+      auto const& rows = compressed_[value];
+      return std::lower_bound(rows.begin(), rows.end(), row_end) -
+             rows.begin();
+    }
+    return equality_ranks_[value].rank1(row_end);
+  }
+
+  /*!
+   * \brief Counts the rows with a specific value.
+   * \param value The value.
+   * \return Number of rows with value \c value.
+   */
+  [[nodiscard("count_equal computed but not used")]] size_t
+  count_equal(size_t const value) const {
+    return count_equal(value, size_);
+  }
+
+  /*!
+   * \brief Counts the rows with a value in a range (in a prefix of the
+   * rows).
+   *
+   * With range encoding, this requires at most two rank queries.
+   * \param min_value Smallest value in the range.
+   * \param max_value Largest value in the range (inclusive).
+   * \param row_end Only rows before \c row_end are counted.
+   * \return Number of rows before \c row_end with a value in [\c min_value,
+   * \c max_value].
+   */
+  [[nodiscard("count_range computed but not used")]] size_t
+  count_range(size_t const min_value,
+              size_t max_value,
+              size_t row_end) const {
+    row_end = std::min(row_end, size_);
+    max_value = std::min(max_value, cardinality_ - 1);
+    if (min_value > max_value || cardinality_ == 0) {
+      return 0;
+    }
+    if (range_.empty()) {
+      size_t result = 0;
+      for (size_t v = min_value; v <= max_value; ++v) {
+        result += count_equal(v, row_end);
+      }
+      return result;
+    }
+    size_t const upper = (max_value < range_.size()) ?
+                             range_ranks_[max_value].rank1(row_end) :
+                             row_end;
+    size_t const lower =
+        (min_value == 0) ? 0 : range_ranks_[min_value - 1].rank1(row_end);
+    return upper - lower;
+  }
+
+  /*!
+   * \brief Counts the rows with a value in a range.
+   * \param min_value Smallest value in the range.
+   * \param max_value Largest value in the range (inclusive).
+   * \return Number of rows with a value in [\c min_value, \c max_value].
+   */
+  [[nodiscard("count_range computed but not used")]] size_t
+  count_range(size_t const min_value, size_t const max_value) const {
+    return count_range(min_value, max_value, size_);
+  }
+
+  /*!
+   * \brief Checks whether the equality-encoded bitmap of a value is
+   * compressed.
+   * \param value The value.
+   * \return \c true if the rows of \c value are stored as list.
+   */
+  [[nodiscard("is_compressed computed but not used")]] bool
+  is_compressed(size_t const value) const {
+    return value < cardinality_ && is_compressed_[value];
+  }
+
+  /*!
+   * \brief Get the number of rows.
+   * \return Number of rows of the column.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of distinct values.
+   * \return Number of distinct values (largest value plus one).
+   */
+  [[nodiscard("cardinality computed but not used")]] size_t
+  cardinality() const noexcept {
+    return cardinality_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t result = sizeof(*this) + (is_compressed_.size() / 8);
+    for (size_t v = 0; v < cardinality_; ++v) {
+      result += equality_[v].space_usage() + equality_ranks_[v].space_usage() +
+                sizeof(compressed_[v]) +
+                (compressed_[v].size() * sizeof(size_t));
+    }
+    for (size_t v = 0; v < range_.size(); ++v) {
+      result += range_[v].space_usage() + range_ranks_[v].space_usage();
+    }
+    return result;
+  }
+}; // class BitmapIndex
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,304 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <tlx/container/simple_vector.hpp>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Directly addressable codes (DACs) \cite BrisaboaLN2013DACs for
+ * variable-length integers with random access.
+ *
+ * Each integer is split into chunks of \c ChunkBits bits. The i-th chunks of
+ * all integers that require at least i chunks are stored in the i-th level.
+ * For each level (except the last one), a \ref BitVector marks which of the
+ * integers require another chunk. The position of the next chunk of an
+ * integer in the following level is given by a rank query (using
+ * \ref FlatRank) on this bit vector.
+ *
+ * Random access requires one rank query per additional chunk. The integers
+ * can also be decoded sequentially (see \c decode()), which does not require
+ * any rank queries (apart from the initialization if the decoding does not
+ * start at the beginning).
+ *
+ * \tparam ChunkBits Number of bits of each chunk.
+ */
+template <size_t ChunkBits = 8>
+class DirectlyAddressableCodes {
+  static_assert(0 < ChunkBits && ChunkBits < 64,
+                "Chunk size must be between 1 and 63 bits.");
+
+  //! Type of the rank support used to find the next chunk of an integer.
+  using RankType = FlatRank<OptimizedFor::ONE_QUERIES, BitVector>;
+
+  template <typename T>
+  using Array = tlx::SimpleVector<T, tlx::SimpleVectorMode::NoInitNoDestroy>;
+
+  //! Maximum number of levels required to store 64-bit integers.
+  static constexpr size_t MAX_LEVELS = (64 + ChunkBits - 1) / ChunkBits;
+  //! Mask covering the lowest \c ChunkBits bits of a 64-bit word.
+  static constexpr uint64_t CHUNK_MASK = (1ULL << ChunkBits) - 1;
+
+  /*!
+   * \brief All chunks of one level and the bit vector (with rank support)
+   * marking the integers that require another chunk.
+   */
+  struct Level {
+    //! Number of chunks stored in this level.
+    size_t size = 0;
+    //! Chunks packed in 64-bit words (with one word of padding at the end).
+    Array<uint64_t> chunks;
+    //! Bit vector marking chunks that are followed by another chunk.
+    BitVector continues;
+    //! Rank support for \c continues.
+    RankType rank;
+
+    /*!
+     * \brief Get the chunk at a specific position of this level.
+     * \param index Position of the chunk within this level.
+     * \return The chunk at position \c index.
+     */
+    uint64_t chunk(size_t const index) const noexcept {
+      size_t const bit_pos = index * ChunkBits;
+      size_t const word_pos = bit_pos / 64;
+      size_t const offset = bit_pos % 64;
+      // The padding word at the end allows us to always read the next word.
+      // The double shift avoids undefined behavior if offset is 0.
+      return ((chunks[word_pos] >> offset) |
+              ((chunks[word_pos + 1] << 1) << (63 - offset))) &
+             CHUNK_MASK;
+    }
+  }; // struct Level
+
+  //! Number of integers stored.
+  size_t size_ = 0;
+  //! All levels.
+  std::vector<Level> levels_;
+
+public:
+  //! Default constructor w/o parameter.
+  DirectlyAddressableCodes() = default;
+
+  /*!
+   * \brief Constructor. Encodes a sequence of integers.
+   * \param values The integers that are encoded.
+   */
+  DirectlyAddressableCodes(std::span<uint64_t const> const values)
+      : size_(values.size()) {
+    // Count the number of chunks in each level.
+    std::array<size_t, MAX_LEVELS> level_sizes = {};
+    for (uint64_t const value : values) {
+      size_t const chunks = required_chunks(value);
+      for (size_t l = 0; l < chunks; ++l) {
+        ++level_sizes[l];
+      }
+    }
+    size_t num_levels = 1;
+    while (num_levels < MAX_LEVELS && level_sizes[num_levels] > 0) {
+      ++num_levels;
+    }
+
+    levels_.resize(num_levels);
+    for (size_t l = 0; l < num_levels; ++l) {
+      Level& level = levels_[l];
+      level.size = level_sizes[l];
+      size_t const words = ((level.size * ChunkBits) / 64) + 2;
+      level.chunks = Array<uint64_t>(words);
+      std::fill_n(level.chunks.data(), words, 0ULL);
+      if (l + 1 < num_levels) {
+        level.continues = BitVector(level.size, false);
+      }
+    }
+
+    // Write chunks and continuation bits. Because the integers are processed
+    // in order, the position of the next chunk in each level is just the
+    // number of chunks written to that level so far.
+    std::array<size_t, MAX_LEVELS> level_pos = {};
+    for (uint64_t value : values) {
+      size_t const chunks = required_chunks(value);
+      for (size_t l = 0; l < chunks; ++l) {
+        size_t const pos = level_pos[l]++;
+        write_chunk(levels_[l], pos, value & CHUNK_MASK);
+        value >>= ChunkBits;
+        if (l + 1 < chunks) {
+          levels_[l].continues[pos] = true;
+        }
+      }
+    }
+
+    for (size_t l = 0; l + 1 < num_levels; ++l) {
+      levels_[l].rank = RankType(levels_[l].continues);
+    }
+  }
+
+  //! Default move constructor.
+  DirectlyAddressableCodes(DirectlyAddressableCodes&&) = default;
+
+  //! Default move assignment.
+  DirectlyAddressableCodes& operator=(DirectlyAddressableCodes&&) = default;
+
+  /*!
+   * \brief Random access to an encoded integer.
+   *
+   * Requires one rank query for each chunk (except the first one) of the
+   * integer.
+   * \param index Position of the integer.
+   * \return The integer at position \c index.
+   */
+  [[nodiscard("access computed but not used")]] uint64_t
+  operator[](size_t index) const {
+    uint64_t result = levels_[0].chunk(index);
+    size_t const last_level = levels_.size() - 1;
+    for (size_t l = 0; l < last_level && levels_[l].continues[index]; ++l) {
+      index = levels_[l].rank.rank1(index);
+      result |= levels_[l + 1].chunk(index) << ((l + 1) * ChunkBits);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Sequentially decode consecutive integers.
+   *
+   * For each level, we keep a cursor pointing at the next chunk that is
+   * required. Since the chunks in each level are ordered by the position of
+   * their integer, the cursors only have to be advanced and no rank queries
+   * are required. Only when the decoding does not start at the beginning, one
+   * rank query per level is required to initialize the cursors.
+   *
+   * \param begin Position of the first integer that is decoded.
+   * \param out Span the decoded integers are written to. The number of
+   * decoded integers is the size of the span.
+   */
+  void decode(size_t const begin, std::span<uint64_t> const out) const {
+    PASTA_ASSERT(begin + out.size() <= size_,
+                 "Trying to decode integers that are out of bounds.");
+    size_t const last_level = levels_.size() - 1;
+    std::array<size_t, MAX_LEVELS> cursors = {};
+    cursors[0] = begin;
+    for (size_t l = 0; l < last_level && cursors[l] > 0; ++l) {
+      cursors[l + 1] = levels_[l].rank.rank1(cursors[l]);
+    }
+
+    for (uint64_t& result : out) {
+      size_t pos = cursors[0]++;
+      result = levels_[0].chunk(pos);
+      for (size_t l = 0; l < last_level && levels_[l].continues[pos]; ++l) {
+        pos = cursors[l + 1]++;
+        result |= levels_[l + 1].chunk(pos) << ((l + 1) * ChunkBits);
+      }
+    }
+  }
+
+  /*!
+   * \brief Decode all integers.
+   * \param out Span with at least \c size() elements the integers are
+   * written to.
+   */
+  void decode(std::span<uint64_t> const out) const {
+    decode(0, out.subspan(0, size_));
+  }
+
+  /*!
+   * \brief Get the number of encoded integers.
+   * \return Number of encoded integers.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of levels.
+   * \return Number of levels, i.e., the maximum number of chunks of an
+   * integer.
+   */
+  [[nodiscard("levels computed but not used")]] size_t
+  levels() const noexcept {
+    return levels_.size();
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t result = sizeof(*this);
+    for (size_t l = 0; l < levels_.size(); ++l) {
+      result += sizeof(Level) + (levels_[l].chunks.size() * sizeof(uint64_t));
+      if (l + 1 < levels_.size()) {
+        result += (levels_[l].continues.space_usage() - sizeof(BitVector)) +
+                  (levels_[l].rank.space_usage() - sizeof(RankType));
+      }
+    }
+    return result;
+  }
+
+private:
+  /*!
+   * \brief Computes the number of chunks required to represent an integer.
+   * \param value The integer.
+   * \return Number of chunks required to represent \c value (at least 1).
+   */
+  static size_t required_chunks(uint64_t const value) noexcept {
+    size_t const bits = std::max<size_t>(1, std::bit_width(value));
+    return (bits + ChunkBits - 1) / ChunkBits;
+  }
+
+  /*!
+   * \brief Writes a chunk to a level.
+   * \param level Level the chunk is written to.
+   * \param index Position of the chunk within the level.
+   * \param chunk The chunk, i.e., an integer with at most \c ChunkBits bits.
+   */
+  static void write_chunk(Level& level,
+                          size_t const index,
+                          uint64_t const chunk) noexcept {
+    size_t const bit_pos = index * ChunkBits;
+    size_t const word_pos = bit_pos / 64;
+    size_t const offset = bit_pos % 64;
+    level.chunks[word_pos] |= chunk << offset;
+    if (offset + ChunkBits > 64) {
+      level.chunks[word_pos + 1] |= chunk >> (64 - offset);
+    }
+  }
+}; // class DirectlyAddressableCodes
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,377 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank_select.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mpi.h>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector
+//! \{
+
+/*!
+ * \brief Bit vector that is partitioned across the processes of an MPI
+ * communicator, supporting batched global rank and select queries.
+ *
+ * Each process holds a contiguous part of the global bit vector (the parts
+ * are ordered by the rank of the process) as local \ref BitVector with
+ * \ref FlatRankSelect support. The global offsets of the parts and the
+ * number of ones before each part are computed using \c MPI_Exscan and then
+ * made known to all processes, such that each process can route a query to
+ * the process owning the answer.
+ *
+ * All query functions are collective, i.e., they must be called by all
+ * processes of the communicator (possibly with empty batches). Queries are
+ * sent to their owning processes using one \c MPI_Alltoall (counts) and one
+ * \c MPI_Alltoallv (queries) and the answers are returned using another
+ * \c MPI_Alltoallv.
+ *
+ * This header requires MPI and is not included by any other header.
+ */
+class DistributedBitVector {
+  //! Type of the local rank and select support.
+  using RankSelectType = FlatRankSelect<OptimizedFor::DONT_CARE>;
+
+  //! Communicator the bit vector is distributed on.
+  MPI_Comm comm_ = MPI_COMM_NULL;
+  //! Rank of this process.
+  int32_t rank_ = 0;
+  //! Number of processes.
+  int32_t num_processes_ = 0;
+  //! Local part of the bit vector.
+  BitVector local_;
+  //! Rank and select support for the local part.
+  RankSelectType local_rs_;
+  //! Number of ones in the local part.
+  size_t local_ones_ = 0;
+  //! Global offset of the part of each process (plus the global size).
+  std::vector<uint64_t> offsets_;
+  //! Number of ones before the part of each process (plus the number of
+  //! ones in total).
+  std::vector<uint64_t> ones_before_;
+
+  //! Kinds of queries that are routed to other processes.
+  enum class Query : uint8_t { RANK1, SELECT0, SELECT1 };
+
+public:
+  /*!
+   * \brief Constructor. Creates the global view of the local parts (this
+   * is a collective operation).
+   * \param local Local part of the bit vector of this process.
+   * \param comm Communicator the bit vector is distributed on.
+   */
+  DistributedBitVector(BitVector&& local, MPI_Comm const comm)
+      : comm_(comm),
+        local_(std::move(local)),
+        local_rs_(local_) {
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &num_processes_);
+    local_ones_ = local_rs_.rank1(local_.size());
+
+    std::array<uint64_t, 2> const local_counts = {local_.size(), local_ones_};
+    std::array<uint64_t, 2> prefix = {0, 0};
+    MPI_Exscan(local_counts.data(),
+               prefix.data(),
+               2,
+               MPI_UINT64_T,
+               MPI_SUM,
+               comm_);
+    // The result of MPI_Exscan is undefined on the first process.
+    if (rank_ == 0) {
+      prefix = {0, 0};
+    }
+
+    std::vector<uint64_t> all_prefixes(2 * num_processes_);
+    MPI_Allgather(prefix.data(),
+                  2,
+                  MPI_UINT64_T,
+                  all_prefixes.data(),
+                  2,
+                  MPI_UINT64_T,
+                  comm_);
+    offsets_.resize(num_processes_ + 1);
+    ones_before_.resize(num_processes_ + 1);
+    for (int32_t p = 0; p < num_processes_; ++p) {
+      offsets_[p] = all_prefixes[2 * p];
+      ones_before_[p] = all_prefixes[(2 * p) + 1];
+    }
+    // The last process knows the totals.
+    std::array<uint64_t, 2> totals = {prefix[0] + local_counts[0],
+                                      prefix[1] + local_counts[1]};
+    MPI_Bcast(totals.data(), 2, MPI_UINT64_T, num_processes_ - 1, comm_);
+    offsets_[num_processes_] = totals[0];
+    ones_before_[num_processes_] = totals[1];
+  }
+
+  //! Default move constructor.
+  DistributedBitVector(DistributedBitVector&&) = default;
+
+  //! Default move assignment.
+  DistributedBitVector& operator=(DistributedBitVector&&) = default;
+
+  /*!
+   * \brief Global rank queries (collective).
+   * \param positions Global positions in [0, size()].
+   * \return For each position i, the number of ones in [0, i) of the global
+   * bit vector.
+   */
+  [[nodiscard("rank1 computed but not used")]] std::vector<size_t>
+  rank1_batch(std::span<size_t const> const positions) const {
+    return route(positions, Query::RANK1);
+  }
+
+  /*!
+   * \brief Global rank queries for zeros (collective).
+   * \param positions Global positions in [0, size()].
+   * \return For each position i, the number of zeros in [0, i) of the
+   * global bit vector.
+   */
+  [[nodiscard("rank0 computed but not used")]] std::vector<size_t>
+  rank0_batch(std::span<size_t const> const positions) const {
+    std::vector<size_t> result = route(positions, Query::RANK1);
+    for (size_t i = 0; i < positions.size(); ++i) {
+      result[i] = positions[i] - result[i];
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Global select queries (collective).
+   * \param ranks Ranks in [1, ones()].
+   * \return For each rank j, the global position of the j-th one.
+   */
+  [[nodiscard("select1 computed but not used")]] std::vector<size_t>
+  select1_batch(std::span<size_t const> const ranks) const {
+    return route(ranks, Query::SELECT1);
+  }
+
+  /*!
+   * \brief Global select queries for zeros (collective).
+   * \param ranks Ranks in [1, size() - ones()].
+   * \return For each rank j, the global position of the j-th zero.
+   */
+  [[nodiscard("select0 computed but not used")]] std::vector<size_t>
+  select0_batch(std::span<size_t const> const ranks) const {
+    return route(ranks, Query::SELECT0);
+  }
+
+  /*!
+   * \brief Get the global size of the bit vector in bits.
+   * \return Global size of the bit vector in bits.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return offsets_[num_processes_];
+  }
+
+  /*!
+   * \brief Get the global number of ones.
+   * \return Number of ones in the global bit vector.
+   */
+  [[nodiscard("ones computed but not used")]] size_t ones() const noexcept {
+    return ones_before_[num_processes_];
+  }
+
+  /*!
+   * \brief Get the global position of the first bit of the local part.
+   * \return Global position of the first bit of the local part.
+   */
+  [[nodiscard("local offset computed but not used")]] size_t
+  local_offset() const noexcept {
+    return offsets_[rank_];
+  }
+
+  /*!
+   * \brief Access to the local part of the bit vector.
+   * \return The local part of the bit vector.
+   */
+  [[nodiscard("local part not used")]] BitVector const&
+  local() const noexcept {
+    return local_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage on this process.
+   * \return Number of bytes used by this data structure on this process.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) + (local_.space_usage() - sizeof(local_)) +
+           (local_rs_.space_usage() - sizeof(local_rs_)) +
+           ((offsets_.size() + ones_before_.size()) * sizeof(uint64_t));
+  }
+
+private:
+  /*!
+   * \brief Determines the process owning the answer of a query.
+   * \param value Position (rank queries) or rank (select queries).
+   * \param query Kind of the query.
+   * \return Rank of the owning process.
+   */
+  int32_t owner(uint64_t const value, Query const query) const {
+    // Find the last process whose part starts at or before the value. Empty
+    // parts are skipped implicitly, as the following part has the same
+    // start.
+    auto const last_before = [&](auto const start_of) {
+      int32_t left = 0;
+      int32_t right = num_processes_;
+      while (right - left > 1) {
+        int32_t const mid = left + ((right - left) / 2);
+        if (start_of(mid) <= value) {
+          left = mid;
+        } else {
+          right = mid;
+        }
+      }
+      return left;
+    };
+    switch (query) {
+      case Query::RANK1:
+        return last_before([&](int32_t const p) { return offsets_[p]; });
+      case Query::SELECT1:
+        return last_before(
+            [&](int32_t const p) { return ones_before_[p] + 1; });
+      case Query::SELECT0:
+        return last_before([&](int32_t const p) {
+          return offsets_[p] - ones_before_[p] + 1;
+        });
+    }
+    return 0;
+  }
+
+  /*!
+   * \brief Answers a query on the local part.
+   * \param value Position (rank queries) or rank (select queries).
+   * \param query Kind of the query.
+   * \return The global answer.
+   */
+  uint64_t answer(uint64_t const value, Query const query) const {
+    uint64_t const offset = offsets_[rank_];
+    uint64_t const ones_before = ones_before_[rank_];
+    switch (query) {
+      case Query::RANK1: {
+        uint64_t const local_pos = value - offset;
+        return ones_before + ((local_pos >= local_.size()) ?
+                                  local_ones_ :
+                                  local_rs_.rank1(local_pos));
+      }
+      case Query::SELECT1:
+        return offset + local_rs_.select1(value - ones_before);
+      case Query::SELECT0:
+        return offset + local_rs_.select0(value - (offset - ones_before));
+    }
+    return 0;
+  }
+
+  /*!
+   * \brief Sends queries to their owning processes, answers the received
+   * queries, and returns the answers to the sending processes.
+   * \param values Positions (rank queries) or ranks (select queries).
+   * \param query Kind of the queries.
+   * \return Answers in the order of the queries.
+   */
+  std::vector<size_t> route(std::span<size_t const> const values,
+                            Query const query) const {
+    size_t const num_processes = static_cast<size_t>(num_processes_);
+    // Bucket the queries by owner, keeping track of their original order.
+    std::vector<int32_t> owners(values.size());
+    std::vector<int32_t> send_counts(num_processes, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+      PASTA_ASSERT(query != Query::RANK1 || values[i] <= size(),
+                   "Position is out of bounds.");
+      owners[i] = owner(values[i], query);
+      ++send_counts[owners[i]];
+    }
+    std::vector<int32_t> send_displs(num_processes + 1, 0);
+    for (size_t p = 0; p < num_processes; ++p) {
+      send_displs[p + 1] = send_displs[p] + send_counts[p];
+    }
+    std::vector<uint64_t> send_values(values.size());
+    std::vector<size_t> order(values.size());
+    {
+      std::vector<int32_t> fill = send_displs;
+      for (size_t i = 0; i < values.size(); ++i) {
+        size_t const pos = static_cast<size_t>(fill[owners[i]]++);
+        send_values[pos] = values[i];
+        order[pos] = i;
+      }
+    }
+
+    std::vector<int32_t> recv_counts(num_processes);
+    MPI_Alltoall(send_counts.data(),
+                 1,
+                 MPI_INT32_T,
+                 recv_counts.data(),
+                 1,
+                 MPI_INT32_T,
+                 comm_);
+    std::vector<int32_t> recv_displs(num_processes + 1, 0);
+    for (size_t p = 0; p < num_processes; ++p) {
+      recv_displs[p + 1] = recv_displs[p] + recv_counts[p];
+    }
+
+    std::vector<uint64_t> received(recv_displs[num_processes]);
+    MPI_Alltoallv(send_values.data(),
+                  send_counts.data(),
+                  send_displs.data(),
+                  MPI_UINT64_T,
+                  received.data(),
+                  recv_counts.data(),
+                  recv_displs.data(),
+                  MPI_UINT64_T,
+                  comm_);
+    for (auto& value : received) {
+      value = answer(value, query);
+    }
+    // The answers are returned using the same counts in reverse.
+    MPI_Alltoallv(received.data(),
+                  recv_counts.data(),
+                  recv_displs.data(),
+                  MPI_UINT64_T,
+                  send_values.data(),
+                  send_counts.data(),
+                  send_displs.data(),
+                  MPI_UINT64_T,
+                  comm_);
+
+    std::vector<size_t> result(values.size());
+    for (size_t pos = 0; pos < values.size(); ++pos) {
+      result[order[pos]] = send_values[pos];
+    }
+    return result;
+  }
+}; // class DistributedBitVector
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,535 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/block_cache.hpp"
+#include "pasta/bit_vector/support/file_mapping.hpp"
+#include "pasta/bit_vector/support/find_l2_flat_with.hpp"
+#include "pasta/bit_vector/support/flat_rank_select.hpp"
+#include "pasta/bit_vector/support/l12_type.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+#include "pasta/bit_vector/support/select.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_rank_select
+//! \{
+
+/*!
+ * \brief \ref FlatRankSelect for bit vectors stored on disk (see
+ * \ref BitVector::create_file()) that are larger than the available memory.
+ *
+ * The L1- and L2-blocks and the select samples (about 3.3% of the size of
+ * the bit vector) are kept in memory. The 64-bit words of the bit vector are
+ * read from the file through a fixed-size \ref BlockCache, i.e., the memory
+ * usage is bounded and the page cache (with its read-ahead) is bypassed.
+ *
+ * Each query requires at most one block of the file: The L2-block
+ * containing the answer is found using the information in memory, and an
+ * L2-block (512 bits) never spans two blocks of the cache. Queries ending
+ * at the beginning of an L2-block or in an L2-block containing only zeros
+ * or only ones do not require any I/O. The batched queries first compute
+ * the required blocks of multiple queries, then fetch all missing blocks at
+ * once (asynchronously), and finally answer the queries.
+ *
+ * The rank and select information is computed when the file is opened,
+ * using a shared mapping of the file that is read sequentially. Afterwards,
+ * the mapped pages are released.
+ *
+ * \tparam optimized_for See \ref FlatRankSelect.
+ */
+template <OptimizedFor optimized_for = OptimizedFor::DONT_CARE>
+class ExternalFlatRankSelect {
+  //! Type of the rank and select support used during construction.
+  using RankSelectType =
+      FlatRankSelect<optimized_for, FindL2FlatWith::LINEAR_SEARCH, BitVector>;
+
+  //! Number of L2-blocks in one block of the cache.
+  static constexpr size_t L2_PER_BLOCK =
+      BlockCache::BLOCK_BYTES / (FlatRankSelectConfig::L2_WORD_SIZE *
+                                 sizeof(uint64_t));
+  //! Offset of the first L2-block in the file (in L2-blocks).
+  static constexpr size_t L2_FILE_OFFSET =
+      BitVector::FILE_HEADER_BYTES /
+      (FlatRankSelectConfig::L2_WORD_SIZE * sizeof(uint64_t));
+  //! Maximum number of queries whose blocks are fetched at once in the
+  //! batched queries.
+  static constexpr size_t BATCH_SIZE = 256;
+  //! Marker for queries that can be answered without accessing the data.
+  static constexpr size_t NO_DATA = ~size_t{0};
+
+  static_assert(BitVector::FILE_HEADER_BYTES %
+                        (FlatRankSelectConfig::L2_WORD_SIZE *
+                         sizeof(uint64_t)) ==
+                    0,
+                "L2-blocks must not span two blocks of the cache.");
+
+  /*!
+   * \brief Part of a query answered using the information in memory. The
+   * rest of the query is answered by scanning one L2-block.
+   */
+  struct Pending {
+    //! Global index of the L2-block that has to be scanned (or
+    //! \c NO_DATA).
+    size_t l2;
+    //! Partial result (rank or position) before the L2-block.
+    size_t result;
+    //! Number of bits (rank) or rank (select) within the L2-block.
+    size_t remaining;
+  }; // struct Pending
+
+  //! Size of the bit vector in bits.
+  size_t bit_size_ = 0;
+  //! L1- and L2-blocks.
+  std::vector<BigL12Type> l12_;
+  //! Samples of zeros.
+  std::vector<uint32_t> samples0_;
+  //! Samples of ones.
+  std::vector<uint32_t> samples1_;
+  //! Cache of the blocks of the file containing the bit vector.
+  BlockCache cache_;
+
+public:
+  //! Default constructor w/o parameter.
+  ExternalFlatRankSelect() = default;
+
+  //! Default move constructor.
+  ExternalFlatRankSelect(ExternalFlatRankSelect&&) = default;
+
+  //! Default move assignment.
+  ExternalFlatRankSelect& operator=(ExternalFlatRankSelect&&) = default;
+
+  /*!
+   * \brief Opens a bit vector stored in a file (see
+   * \ref BitVector::create_file()) and computes its rank and select
+   * information. The file is only read, i.e., read permission suffices and
+   * the file is not modified.
+   * \param path Path of the file.
+   * \param cache_size Maximum number of bytes used to cache blocks of the
+   * file.
+   * \return The rank and select support or \c std::nullopt if the file does
+   * not exist, cannot be read, or does not contain a bit vector.
+   */
+  [[nodiscard("opened rank and select support not used")]] static std::
+      optional<ExternalFlatRankSelect>
+      open_file(std::string const& path, size_t const cache_size) {
+    ExternalFlatRankSelect result;
+    {
+      auto bv = BitVector::open_file(path, true);
+      if (!bv.has_value()) {
+        return std::nullopt;
+      }
+      bv->advise(AccessPattern::SEQUENTIAL);
+      RankSelectType const rs(*bv);
+      result.bit_size_ = bv->size();
+      result.l12_.assign(rs.l12_.data(), rs.l12_.data() + rs.l12_end_);
+      result.samples0_ = rs.samples0_;
+      result.samples1_ = rs.samples1_;
+      bv->advise(AccessPattern::DONT_NEED);
+    }
+    auto cache = BlockCache::open_file(path, cache_size);
+    if (!cache.has_value()) {
+      return std::nullopt;
+    }
+    result.cache_ = std::move(*cache);
+    return result;
+  }
+
+  /*!
+   * \brief Computes rank of zeros.
+   * \param index Index the rank of zeros is computed for.
+   * \return Number of zeros (rank) before position \c index.
+   */
+  [[nodiscard("rank0 computed but not used")]] size_t rank0(size_t index) {
+    return index - rank1(index);
+  }
+
+  /*!
+   * \brief Computes rank of ones.
+   * \param index Index the rank of ones is computed for.
+   * \return Number of ones (rank) before position \c index.
+   */
+  [[nodiscard("rank1 computed but not used")]] size_t rank1(size_t index) {
+    Pending const pending = prepare_rank1(index);
+    if (pending.l2 == NO_DATA) {
+      return pending.result;
+    }
+    return finish_rank1(l2_words(cache_.block(block_of(pending.l2)),
+                                 pending.l2),
+                        pending);
+  }
+
+  /*!
+   * \brief Get position of specific zero, i.e., select.
+   * \param rank Rank of zero the position is searched for.
+   * \return Position of the rank-th zero.
+   */
+  [[nodiscard("select0 computed but not used")]] size_t select0(size_t rank) {
+    return select<false>(rank);
+  }
+
+  /*!
+   * \brief Get position of specific one, i.e., select.
+   * \param rank Rank of one the position is searched for.
+   * \return Position of the rank-th one.
+   */
+  [[nodiscard("select1 computed but not used")]] size_t select1(size_t rank) {
+    return select<true>(rank);
+  }
+
+  /*!
+   * \brief Computes rank of ones for multiple positions. The blocks of up to
+   * \c BATCH_SIZE queries are fetched at once.
+   * \param positions Positions the rank of ones is computed for.
+   * \param out Span with at least \c positions.size() elements the ranks
+   * are written to.
+   */
+  void rank1_batch(std::span<size_t const> const positions,
+                   std::span<size_t> const out) {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output span is smaller than number of positions.");
+    run_batch(
+        positions,
+        out,
+        [this](size_t const index) { return prepare_rank1(index); },
+        [](uint64_t const* const words, Pending const& pending) {
+          return finish_rank1(words, pending);
+        });
+  }
+
+  /*!
+   * \brief Get positions of multiple zeros. The blocks of up to
+   * \c BATCH_SIZE queries are fetched at once.
+   * \param ranks Ranks of the zeros the positions are searched for.
+   * \param out Span with at least \c ranks.size() elements the positions
+   * are written to.
+   */
+  void select0_batch(std::span<size_t const> const ranks,
+                     std::span<size_t> const out) {
+    select_batch<false>(ranks, out);
+  }
+
+  /*!
+   * \brief Get positions of multiple ones. The blocks of up to
+   * \c BATCH_SIZE queries are fetched at once.
+   * \param ranks Ranks of the ones the positions are searched for.
+   * \param out Span with at least \c ranks.size() elements the positions
+   * are written to.
+   */
+  void select1_batch(std::span<size_t const> const ranks,
+                     std::span<size_t> const out) {
+    select_batch<true>(ranks, out);
+  }
+
+  /*!
+   * \brief Get the size of the bit vector.
+   * \return Size of the bit vector in bits.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return bit_size_;
+  }
+
+  /*!
+   * \brief Access the cache of the blocks of the file, e.g., to obtain the
+   * number of blocks that have been read.
+   * \return The cache of the blocks of the file.
+   */
+  [[nodiscard("cache not used")]] BlockCache const& cache() const noexcept {
+    return cache_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage (in memory).
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) + (l12_.size() * sizeof(BigL12Type)) +
+           ((samples0_.size() + samples1_.size()) * sizeof(uint32_t)) +
+           (cache_.space_usage() - sizeof(cache_));
+  }
+
+private:
+  /*!
+   * \brief Get the block of the file containing an L2-block.
+   * \param l2 Global index of the L2-block.
+   * \return Index of the block.
+   */
+  static size_t block_of(size_t const l2) {
+    return (l2 + L2_FILE_OFFSET) / L2_PER_BLOCK;
+  }
+
+  /*!
+   * \brief Get the words of an L2-block within its block of the file.
+   * \param block Pointer to the block of the file containing the L2-block.
+   * \param l2 Global index of the L2-block.
+   * \return Pointer to the first word of the L2-block.
+   */
+  static uint64_t const* l2_words(uint8_t const* const block,
+                                  size_t const l2) {
+    return reinterpret_cast<uint64_t const*>(block) +
+           (((l2 + L2_FILE_OFFSET) % L2_PER_BLOCK) *
+            FlatRankSelectConfig::L2_WORD_SIZE);
+  }
+
+  /*!
+   * \brief Get the number of ones or zeros before an L2-block.
+   * \tparam one Whether ones (or zeros) are counted.
+   * \param l1_pos Index of the L1-block.
+   * \param l2_pos Index of the L2-block within the L1-block.
+   * \return Number of ones (or zeros) before the L2-block.
+   */
+  template <bool one>
+  [[nodiscard]] size_t count_before(size_t const l1_pos,
+                                    size_t const l2_pos) const {
+    BigL12Type const& l12 = l12_[l1_pos];
+    size_t const counted = l12.l1() + l12[l2_pos];
+    if constexpr (one == optimize_one_or_dont_care(optimized_for)) {
+      return counted;
+    } else {
+      return (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) +
+             (l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) - counted;
+    }
+  }
+
+  /*!
+   * \brief Get the number of ones in an L2-block (see
+   * \ref FlatRank::l2_count()).
+   * \param l1_pos Index of the L1-block.
+   * \param l2_pos Index of the L2-block within the L1-block.
+   * \return Number of ones in the L2-block or 1 for the last L2-block of
+   * the last L1-block, which is never uniform.
+   */
+  [[nodiscard]] size_t l2_ones(size_t const l1_pos,
+                               size_t const l2_pos) const {
+    BigL12Type const& l12 = l12_[l1_pos];
+    size_t counted = 1;
+    if (l2_pos < 7) {
+      counted = l12[l2_pos + 1] - l12[l2_pos];
+    } else if (l1_pos + 1 < l12_.size()) {
+      counted = l12_[l1_pos + 1].l1() - l12.l1() - l12[7];
+    } else {
+      return 1;
+    }
+    if constexpr (optimize_one_or_dont_care(optimized_for)) {
+      return counted;
+    } else {
+      return FlatRankSelectConfig::L2_BIT_SIZE - counted;
+    }
+  }
+
+  /*!
+   * \brief Answers the part of a rank query that does not require the data.
+   * \param index Index the rank of ones is computed for.
+   * \return The partial query.
+   */
+  [[nodiscard]] Pending prepare_rank1(size_t const index) const {
+    size_t const l1_pos = index / FlatRankSelectConfig::L1_BIT_SIZE;
+    size_t const l2_pos = (index % FlatRankSelectConfig::L1_BIT_SIZE) /
+                          FlatRankSelectConfig::L2_BIT_SIZE;
+    size_t const result = count_before<true>(l1_pos, l2_pos);
+    size_t const offset = index % FlatRankSelectConfig::L2_BIT_SIZE;
+    if (offset == 0) {
+      return {NO_DATA, result, 0};
+    }
+    if (l12_[l1_pos].has_uniform_l2()) [[unlikely]] {
+      size_t const ones = l2_ones(l1_pos, l2_pos);
+      if (ones == 0) {
+        return {NO_DATA, result, 0};
+      }
+      if (ones == FlatRankSelectConfig::L2_BIT_SIZE) {
+        return {NO_DATA, result + offset, 0};
+      }
+    }
+    return {index / FlatRankSelectConfig::L2_BIT_SIZE, result, offset};
+  }
+
+  /*!
+   * \brief Answers the rest of a rank query.
+   * \param words The words of the L2-block of the query.
+   * \param pending The partial query.
+   * \return Number of ones before the position of the query.
+   */
+  [[nodiscard]] static size_t finish_rank1(uint64_t const* const words,
+                                           Pending const& pending) {
+    size_t result = pending.result;
+    size_t const full_words = pending.remaining / 64;
+    for (size_t i = 0; i < full_words; ++i) {
+      result += std::popcount(words[i]);
+    }
+    if (size_t const bits = pending.remaining % 64; bits > 0) {
+      result += std::popcount(words[full_words] << (64 - bits));
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Answers the part of a select query that does not require the
+   * data, i.e., finds the L2-block containing the bit.
+   * \tparam one Whether ones (or zeros) are selected.
+   * \param rank Rank of the bit that is selected.
+   * \return The partial query.
+   */
+  template <bool one>
+  [[nodiscard]] Pending prepare_select(size_t rank) const {
+    std::vector<uint32_t> const& samples = one ? samples1_ : samples0_;
+    size_t l1_pos =
+        samples[(rank - 1) / FlatRankSelectConfig::SELECT_SAMPLE_RATE];
+    while (l1_pos + 1 < l12_.size() &&
+           count_before<one>(l1_pos + 1, 0) < rank) {
+      ++l1_pos;
+    }
+    size_t l2_pos = 0;
+    while (l2_pos < 7 && count_before<one>(l1_pos, l2_pos + 1) < rank) {
+      ++l2_pos;
+    }
+    rank -= count_before<one>(l1_pos, l2_pos);
+    size_t const position = (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) +
+                            (l2_pos * FlatRankSelectConfig::L2_BIT_SIZE);
+    if (l12_[l1_pos].has_uniform_l2()) [[unlikely]] {
+      size_t const ones = l2_ones(l1_pos, l2_pos);
+      if (ones == (one ? FlatRankSelectConfig::L2_BIT_SIZE : 0)) {
+        return {NO_DATA, position + rank - 1, 0};
+      }
+    }
+    return {position / FlatRankSelectConfig::L2_BIT_SIZE, position, rank};
+  }
+
+  /*!
+   * \brief Answers the rest of a select query.
+   * \tparam one Whether ones (or zeros) are selected.
+   * \param words The words of the L2-block of the query.
+   * \param pending The partial query.
+   * \return Position of the selected bit.
+   */
+  template <bool one>
+  [[nodiscard]] static size_t finish_select(uint64_t const* const words,
+                                            Pending const& pending) {
+    size_t rank = pending.remaining;
+    for (size_t i = 0; i + 1 < FlatRankSelectConfig::L2_WORD_SIZE; ++i) {
+      uint64_t const word = one ? words[i] : ~words[i];
+      size_t const count = std::popcount(word);
+      if (count >= rank) {
+        return pending.result + (i * 64) + pasta::select(word, rank - 1);
+      }
+      rank -= count;
+    }
+    uint64_t const word =
+        one ? words[FlatRankSelectConfig::L2_WORD_SIZE - 1] :
+              ~words[FlatRankSelectConfig::L2_WORD_SIZE - 1];
+    return pending.result + ((FlatRankSelectConfig::L2_WORD_SIZE - 1) * 64) +
+           pasta::select(word, rank - 1);
+  }
+
+  /*!
+   * \brief Select query for ones or zeros.
+   * \tparam one Whether ones (or zeros) are selected.
+   * \param rank Rank of the bit that is selected.
+   * \return Position of the rank-th one (or zero).
+   */
+  template <bool one>
+  [[nodiscard]] size_t select(size_t const rank) {
+    Pending const pending = prepare_select<one>(rank);
+    if (pending.l2 == NO_DATA) {
+      return pending.result;
+    }
+    return finish_select<one>(
+        l2_words(cache_.block(block_of(pending.l2)), pending.l2),
+        pending);
+  }
+
+  /*!
+   * \brief Batched select queries for ones or zeros.
+   * \tparam one Whether ones (or zeros) are selected.
+   * \param ranks Ranks of the bits that are selected.
+   * \param out Span the positions are written to.
+   */
+  template <bool one>
+  void select_batch(std::span<size_t const> const ranks,
+                    std::span<size_t> const out) {
+    PASTA_ASSERT(out.size() >= ranks.size(),
+                 "Output span is smaller than number of ranks.");
+    run_batch(
+        ranks,
+        out,
+        [this](size_t const rank) { return prepare_select<one>(rank); },
+        [](uint64_t const* const words, Pending const& pending) {
+          return finish_select<one>(words, pending);
+        });
+  }
+
+  /*!
+   * \brief Answers batched queries: For groups of up to \c BATCH_SIZE
+   * queries (but not more than the cache has frames), the parts not
+   * requiring the data are answered first, then all required blocks are
+   * fetched at once, and finally the queries are finished.
+   * \param queries The queries.
+   * \param out Span the results are written to.
+   * \param prepare Answers the part of a query not requiring the data.
+   * \param finish Answers the rest of a query given its L2-block.
+   */
+  template <typename Prepare, typename Finish>
+  void run_batch(std::span<size_t const> const queries,
+                 std::span<size_t> const out,
+                 Prepare prepare,
+                 Finish finish) {
+    size_t const group_size = std::min(BATCH_SIZE, cache_.num_frames());
+    std::vector<Pending> pending(group_size);
+    std::vector<size_t> blocks;
+    blocks.reserve(group_size);
+    for (size_t first = 0; first < queries.size(); first += group_size) {
+      size_t const size = std::min(group_size, queries.size() - first);
+      blocks.clear();
+      for (size_t i = 0; i < size; ++i) {
+        pending[i] = prepare(queries[first + i]);
+        if (pending[i].l2 != NO_DATA) {
+          blocks.push_back(block_of(pending[i].l2));
+        }
+      }
+      cache_.fetch(blocks);
+      for (size_t i = 0; i < size; ++i) {
+        out[first + i] =
+            (pending[i].l2 == NO_DATA) ?
+                pending[i].result :
+                finish(l2_words(cache_.cached_block(block_of(pending[i].l2)),
+                                pending[i].l2),
+                       pending[i]);
+      }
+    }
+  }
+}; // class ExternalFlatRankSelect
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+#include "pasta/bit_vector/wavelet_matrix.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief FM-index \cite FerraginaM2000FMIndex over byte alphabets supporting
+ * count and locate queries.
+ *
+ * The BWT is stored in a \ref WaveletMatrix over the effective alphabet,
+ * i.e., only symbols that occur in the text are considered, which results in
+ * \f$\lceil\lg\sigma\rceil\f$ levels. Every \c sample_rate-th text position is
+ * sampled. The rows of the sampled suffixes are marked in a \ref BitVector
+ * with \ref FlatRank support, which is used to find the sample of a marked
+ * row.
+ *
+ * The text must end with a unique sentinel that is lexicographically smaller
+ * than all other symbols (usually \c '\0'). The BWT and suffix array are
+ * supplied by the user and must include this sentinel.
+ */
+class FmIndex {
+  //! Type of the rank support used to find suffix array samples.
+  using RankType = FlatRank<OptimizedFor::ONE_QUERIES, BitVector>;
+
+  //! Number of patterns whose backward searches are interleaved in
+  //! \c count_batch().
+  static constexpr size_t INTERLEAVED_PATTERNS = 16;
+
+  //! Marker for symbols that do not occur in the text.
+  static constexpr uint16_t NOT_IN_ALPHABET = 256;
+
+  //! Length of the text (including the sentinel).
+  size_t size_ = 0;
+  //! Every \c sample_rate_-th text position is sampled.
+  size_t sample_rate_ = 0;
+  //! Maps each byte to its rank in the effective alphabet.
+  std::array<uint16_t, 256> symbol_map_ = {};
+  //! Number of symbols in the text smaller than each (effective) symbol.
+  std::vector<size_t> c_;
+  //! BWT over the effective alphabet.
+  WaveletMatrix bwt_;
+  //! Bit vector marking rows whose suffix array entry is sampled.
+  BitVector sampled_;
+  //! Rank support for \c sampled_.
+  RankType sampled_rank_;
+  //! Sampled suffix array entries (ordered by row).
+  std::vector<uint64_t> samples_;
+
+public:
+  //! Default constructor w/o parameter.
+  FmIndex() = default;
+
+  /*!
+   * \brief Constructor. Creates the FM-index for an externally computed BWT
+   * and suffix array.
+   * \param bwt Burrows-Wheeler transform of the text (including the
+   * sentinel).
+   * \param sa Suffix array of the text (including the sentinel).
+   * \param sample_rate Every \c sample_rate-th text position is sampled
+   * (must be greater than 0).
+   */
+  FmIndex(std::span<uint8_t const> const bwt,
+          std::span<uint64_t const> const sa,
+          size_t const sample_rate = 32)
+      : size_(bwt.size()),
+        sample_rate_(sample_rate),
+        sampled_(bwt.size(), false) {
+    PASTA_ASSERT(bwt.size() == sa.size(),
+                 "BWT and suffix array must have the same length.");
+    PASTA_ASSERT(sample_rate > 0, "Sample rate must be greater than 0.");
+    std::array<size_t, 256> histogram = {};
+    for (uint8_t const c : bwt) {
+      ++histogram[c];
+    }
+    uint16_t sigma = 0;
+    for (size_t c = 0; c < 256; ++c) {
+      symbol_map_[c] = (histogram[c] > 0) ? sigma++ : NOT_IN_ALPHABET;
+    }
+    c_.resize(sigma + 1, 0);
+    for (size_t c = 0; c < 256; ++c) {
+      if (symbol_map_[c] != NOT_IN_ALPHABET) {
+        c_[symbol_map_[c] + 1] = c_[symbol_map_[c]] + histogram[c];
+      }
+    }
+
+    std::vector<uint8_t> mapped(size_);
+    for (size_t i = 0; i < size_; ++i) {
+      mapped[i] = static_cast<uint8_t>(symbol_map_[bwt[i]]);
+    }
+    bwt_ = WaveletMatrix(mapped);
+
+    auto sampled_data = sampled_.data();
+    size_t num_samples = 0;
+    for (size_t i = 0; i < size_; ++i) {
+      if (sa[i] % sample_rate_ == 0) {
+        sampled_data[i / 64] |= 1ULL << (i % 64);
+        ++num_samples;
+      }
+    }
+    sampled_rank_ = RankType(sampled_);
+    samples_.reserve(num_samples);
+    for (size_t i = 0; i < size_; ++i) {
+      if (sa[i] % sample_rate_ == 0) {
+        samples_.push_back(sa[i]);
+      }
+    }
+  }
+
+  //! Default move constructor.
+  FmIndex(FmIndex&&) = default;
+
+  //! Default move assignment.
+  FmIndex& operator=(FmIndex&&) = default;
+
+  /*!
+   * \brief Backward search for a pattern.
+   * \param pattern The pattern that is searched.
+   * \return Half-open interval [begin, end) of rows of the suffix array
+   * that are prefixed by the pattern.
+   */
+  [[nodiscard("backward search computed but not used")]] std::pair<size_t,
+                                                                   size_t>
+  backward_search(std::string_view const pattern) const {
+    size_t begin = 0;
+    size_t end = size_;
+    for (size_t i = pattern.size(); i > 0 && begin < end; --i) {
+      uint16_t const c = symbol_map_[static_cast<uint8_t>(pattern[i - 1])];
+      if (c == NOT_IN_ALPHABET) {
+        return {0, 0};
+      }
+      begin = c_[c] + bwt_.rank(static_cast<uint8_t>(c), begin);
+      end = c_[c] + bwt_.rank(static_cast<uint8_t>(c), end);
+    }
+    return (begin < end) ? std::pair{begin, end} : std::pair<size_t, size_t>{};
+  }
+
+  /*!
+   * \brief Counts the occurrences of a pattern.
+   * \param pattern The pattern whose occurrences are counted.
+   * \return Number of occurrences of \c pattern in the text.
+   */
+  [[nodiscard("count computed but not used")]] size_t
+  count(std::string_view const pattern) const {
+    auto const [begin, end] = backward_search(pattern);
+    return end - begin;
+  }
+
+  /*!
+   * \brief Counts the occurrences of multiple patterns.
+   *
+   * The backward searches of up to \c INTERLEAVED_PATTERNS patterns are
+   * interleaved: In each round, one symbol of each active pattern is
+   * processed and all rank queries of the round are answered using
+   * \ref WaveletMatrix::rank_batch(). This way, the rank queries of
+   * different patterns are independent and their cache misses overlap.
+   *
+   * \param patterns The patterns whose occurrences are counted.
+   * \param out Span with at least \c patterns.size() elements the number of
+   * occurrences of each pattern is written to.
+   */
+  void count_batch(std::span<std::string_view const> const patterns,
+                   std::span<size_t> const out) const {
+    PASTA_ASSERT(out.size() >= patterns.size(),
+                 "Output span is smaller than number of patterns.");
+    std::array<size_t, INTERLEAVED_PATTERNS> begins;
+    std::array<size_t, INTERLEAVED_PATTERNS> ends;
+    std::array<size_t, INTERLEAVED_PATTERNS> remaining;
+    std::array<size_t, INTERLEAVED_PATTERNS> active;
+    std::array<uint8_t, 2 * INTERLEAVED_PATTERNS> symbols;
+    std::array<size_t, 2 * INTERLEAVED_PATTERNS> positions;
+
+    for (size_t first = 0; first < patterns.size();
+         first += INTERLEAVED_PATTERNS) {
+      size_t const group_size =
+          std::min(INTERLEAVED_PATTERNS, patterns.size() - first);
+      for (size_t p = 0; p < group_size; ++p) {
+        begins[p] = 0;
+        ends[p] = size_;
+        remaining[p] = patterns[first + p].size();
+      }
+
+      size_t num_active = group_size;
+      while (num_active > 0) {
+        // Collect the next symbol of each active pattern.
+        num_active = 0;
+        for (size_t p = 0; p < group_size; ++p) {
+          if (remaining[p] == 0 || begins[p] >= ends[p]) {
+            continue;
+          }
+          uint16_t const c = symbol_map_[static_cast<uint8_t>(
+              patterns[first + p][--remaining[p]])];
+          if (c == NOT_IN_ALPHABET) {
+            ends[p] = begins[p];
+            continue;
+          }
+          symbols[2 * num_active] = static_cast<uint8_t>(c);
+          symbols[(2 * num_active) + 1] = static_cast<uint8_t>(c);
+          positions[2 * num_active] = begins[p];
+          positions[(2 * num_active) + 1] = ends[p];
+          active[num_active++] = p;
+        }
+
+        bwt_.rank_batch(std::span{symbols.data(), 2 * num_active},
+                        std::span{positions.data(), 2 * num_active});
+
+        for (size_t a = 0; a < num_active; ++a) {
+          size_t const p = active[a];
+          size_t const c_value = c_[symbols[2 * a]];
+          begins[p] = c_value + positions[2 * a];
+          ends[p] = c_value + positions[(2 * a) + 1];
+        }
+      }
+
+      for (size_t p = 0; p < group_size; ++p) {
+        out[first + p] = (begins[p] < ends[p]) ? ends[p] - begins[p] : 0;
+      }
+    }
+  }
+
+  /*!
+   * \brief Computes the suffix array entry of a row.
+   *
+   * Uses LF-mapping until a sampled row is found, i.e., requires at most
+   * \c sample_rate - 1 LF-steps.
+   * \param row Row whose suffix array entry is computed.
+   * \return The suffix array entry of row \c row.
+   */
+  [[nodiscard("suffix array entry computed but not used")]] size_t
+  sa(size_t row) const {
+    size_t steps = 0;
+    while (!sampled_[row]) {
+      auto const [c, rank] = bwt_.access_and_rank(row);
+      row = c_[c] + rank;
+      ++steps;
+    }
+    return samples_[sampled_rank_.rank1(row)] + steps;
+  }
+
+  /*!
+   * \brief Computes all occurrences of a pattern.
+   * \param pattern The pattern whose occurrences are computed.
+   * \return All text positions where \c pattern occurs (unsorted).
+   */
+  [[nodiscard("locate computed but not used")]] std::vector<size_t>
+  locate(std::string_view const pattern) const {
+    auto const [begin, end] = backward_search(pattern);
+    std::vector<size_t> result(end - begin);
+    for (size_t row = begin; row < end; ++row) {
+      result[row - begin] = sa(row);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Get the length of the indexed text.
+   * \return Length of the indexed text (including the sentinel).
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) + (c_.size() * sizeof(size_t)) +
+           (bwt_.space_usage() - sizeof(bwt_)) +
+           (sampled_.space_usage() - sizeof(sampled_)) +
+           (sampled_rank_.space_usage() - sizeof(sampled_rank_)) +
+           (samples_.size() * sizeof(uint64_t));
+  }
+}; // class FmIndex
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,348 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank_select.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <pasta/utils/debug_asserts.hpp>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Huffman-shaped wavelet tree \cite MakinenN2005SuccinctSuffixArrays
+ * over byte alphabets supporting access, rank, and select queries.
+ *
+ * The shape of the tree is given by the Huffman code of the symbols, i.e.,
+ * each occurrence of a symbol is represented by one bit per bit of its
+ * code. Therefore, the tree requires \f$n(H_0 + 1)\f$ bits (plus rank and
+ * select support) instead of \f$n\lceil\lg\sigma\rceil\f$ bits, and queries
+ * for frequent symbols visit fewer nodes. The bits of all inner nodes are
+ * stored concatenated (in level order) in one \ref BitVector with a single
+ * \ref FlatRankSelect. Each node stores the position of its first bit and
+ * the number of ones before it, such that one rank query per visited node
+ * is sufficient.
+ */
+class HuffmanWaveletTree {
+  //! Type of the rank and select support for the bits of all nodes.
+  using RankSelectType = FlatRankSelect<OptimizedFor::DONT_CARE>;
+
+  //! Flag marking a child that is a leaf (the lower 8 bits are the symbol).
+  static constexpr uint16_t IS_LEAF = 1U << 8;
+  //! Code length of symbols that do not occur in the sequence.
+  static constexpr uint8_t NOT_IN_ALPHABET = 255;
+  //! Maximum code length, such that the codes fit into 64-bit words.
+  static constexpr size_t MAX_CODE_LENGTH = 64;
+
+  //! Inner node of the wavelet tree.
+  struct Node {
+    //! Position of the first bit of the node.
+    size_t begin;
+    //! Number of ones before the first bit of the node.
+    size_t ones_before;
+    //! Children (index of an inner node or \c IS_LEAF and the symbol).
+    std::array<uint16_t, 2> children;
+  }; // struct Node
+
+  //! Number of symbols in the sequence.
+  size_t size_ = 0;
+  //! The inner nodes in level order (the root is the first node).
+  std::vector<Node> nodes_;
+  //! Huffman code of each symbol (the i-th bit is the i-th decision).
+  std::array<uint64_t, 256> codes_ = {};
+  //! Length of the Huffman code of each symbol.
+  std::array<uint8_t, 256> code_lengths_ = {};
+  //! Bits of all inner nodes.
+  BitVector bv_;
+  //! Rank and select support for \c bv_.
+  RankSelectType rs_;
+
+public:
+  //! Default constructor w/o parameter.
+  HuffmanWaveletTree() = default;
+
+  /*!
+   * \brief Constructor. Creates the Huffman-shaped wavelet tree for a
+   * sequence.
+   * \param text Sequence of symbols the wavelet tree is created for.
+   */
+  HuffmanWaveletTree(std::span<uint8_t const> const text)
+      : size_(text.size()) {
+    code_lengths_.fill(NOT_IN_ALPHABET);
+    std::array<size_t, 256> histogram = {};
+    for (uint8_t const c : text) {
+      ++histogram[c];
+    }
+    build_shape(histogram);
+
+    size_t num_bits = 0;
+    for (size_t c = 0; c < 256; ++c) {
+      if (code_lengths_[c] != NOT_IN_ALPHABET) {
+        num_bits += histogram[c] * code_lengths_[c];
+      }
+    }
+    bv_ = BitVector(num_bits, false);
+    auto data = bv_.data();
+    std::vector<size_t> cursors(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      cursors[i] = nodes_[i].begin;
+    }
+    for (uint8_t const c : text) {
+      uint64_t const code = codes_[c];
+      size_t node = 0;
+      for (size_t d = 0; d < code_lengths_[c]; ++d) {
+        uint64_t const bit = (code >> d) & 1ULL;
+        size_t const pos = cursors[node]++;
+        data[pos / 64] |= bit << (pos % 64);
+        node = nodes_[node].children[bit];
+      }
+    }
+    rs_ = RankSelectType(bv_);
+    for (Node& node : nodes_) {
+      node.ones_before = rs_.rank1(node.begin);
+    }
+  }
+
+  //! Default move constructor.
+  HuffmanWaveletTree(HuffmanWaveletTree&&) = default;
+
+  //! Default move assignment.
+  HuffmanWaveletTree& operator=(HuffmanWaveletTree&&) = default;
+
+  /*!
+   * \brief Access the symbol at a position.
+   * \param index Position of the symbol.
+   * \return The symbol at position \c index.
+   */
+  [[nodiscard("access computed but not used")]] uint8_t
+  operator[](size_t index) const {
+    PASTA_ASSERT(index < size_, "Index out of bounds.");
+    if (nodes_.empty()) {
+      // Only one distinct symbol, which has an empty code.
+      return single_symbol();
+    }
+    size_t node = 0;
+    while (true) {
+      Node const& n = nodes_[node];
+      size_t const pos = n.begin + index;
+      size_t const ones = rs_.rank1(pos) - n.ones_before;
+      bool const bit = bv_[pos];
+      index = bit ? ones : index - ones;
+      uint16_t const child = n.children[bit];
+      if (child & IS_LEAF) {
+        return static_cast<uint8_t>(child);
+      }
+      node = child;
+    }
+  }
+
+  /*!
+   * \brief Computes the number of occurrences of a symbol before a position.
+   * \param symbol Symbol whose occurrences are counted.
+   * \param index Position the occurrences are counted before.
+   * \return Number of occurrences of \c symbol before position \c index.
+   */
+  [[nodiscard("rank computed but not used")]] size_t
+  rank(uint8_t const symbol, size_t index) const {
+    PASTA_ASSERT(index <= size_, "Index out of bounds.");
+    size_t const length = code_lengths_[symbol];
+    if (length == NOT_IN_ALPHABET) {
+      return 0;
+    }
+    uint64_t const code = codes_[symbol];
+    size_t node = 0;
+    for (size_t d = 0; d < length && index > 0; ++d) {
+      Node const& n = nodes_[node];
+      size_t const ones = rs_.rank1(n.begin + index) - n.ones_before;
+      uint64_t const bit = (code >> d) & 1ULL;
+      index = bit ? ones : index - ones;
+      node = n.children[bit];
+    }
+    return index;
+  }
+
+  /*!
+   * \brief Computes the position of an occurrence of a symbol.
+   *
+   * First, the path of the symbol is followed from the root to its leaf.
+   * Then, the position is computed bottom-up using one select query per
+   * node on the path.
+   * \param symbol Symbol whose occurrence is searched.
+   * \param rank Rank of the occurrence (between 1 and the number of
+   * occurrences of \c symbol).
+   * \return Position of the \c rank-th occurrence of \c symbol.
+   */
+  [[nodiscard("select computed but not used")]] size_t
+  select(uint8_t const symbol, size_t const rank) const {
+    size_t const length = code_lengths_[symbol];
+    PASTA_ASSERT(length != NOT_IN_ALPHABET && rank > 0,
+                 "Symbol does not occur often enough.");
+    uint64_t const code = codes_[symbol];
+    std::array<uint16_t, MAX_CODE_LENGTH> path;
+    size_t node = 0;
+    for (size_t d = 0; d < length; ++d) {
+      path[d] = static_cast<uint16_t>(node);
+      node = nodes_[node].children[(code >> d) & 1ULL];
+    }
+    size_t pos = rank - 1;
+    for (size_t d = length; d > 0; --d) {
+      Node const& n = nodes_[path[d - 1]];
+      if ((code >> (d - 1)) & 1ULL) {
+        pos = rs_.select1(n.ones_before + pos + 1) - n.begin;
+      } else {
+        pos = rs_.select0(n.begin - n.ones_before + pos + 1) - n.begin;
+      }
+    }
+    return pos;
+  }
+
+  /*!
+   * \brief Get the length of the Huffman code of a symbol, i.e., the number
+   * of nodes visited by queries for the symbol.
+   * \param symbol The symbol.
+   * \return Length of the code of \c symbol or 0 if \c symbol does not occur
+   * in the sequence.
+   */
+  [[nodiscard("code length computed but not used")]] size_t
+  code_length(uint8_t const symbol) const noexcept {
+    return (code_lengths_[symbol] == NOT_IN_ALPHABET) ? 0 :
+                                                         code_lengths_[symbol];
+  }
+
+  /*!
+   * \brief Get the number of symbols.
+   * \return Number of symbols in the sequence.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) + (nodes_.size() * sizeof(Node)) +
+           (bv_.space_usage() - sizeof(bv_)) +
+           (rs_.space_usage() - sizeof(rs_));
+  }
+
+private:
+  /*!
+   * \brief Get the only symbol of a sequence with one distinct symbol.
+   * \return The symbol with an empty code.
+   */
+  uint8_t single_symbol() const {
+    size_t c = 0;
+    while (code_lengths_[c] != 0) {
+      ++c;
+    }
+    return static_cast<uint8_t>(c);
+  }
+
+  /*!
+   * \brief Computes the Huffman codes and the inner nodes (in level order)
+   * including the positions of their first bits.
+   * \param histogram Number of occurrences of each symbol.
+   */
+  void build_shape(std::array<size_t, 256> const& histogram) {
+    // Nodes are identified by their (temporary) id, where leaves have the
+    // \c IS_LEAF flag set. Ties are broken by the id.
+    using Entry = std::pair<size_t, uint16_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    for (size_t c = 0; c < 256; ++c) {
+      if (histogram[c] > 0) {
+        heap.emplace(histogram[c], static_cast<uint16_t>(IS_LEAF | c));
+      }
+    }
+    if (heap.size() <= 1) {
+      // No inner nodes are required for less than two distinct symbols.
+      if (!heap.empty()) {
+        code_lengths_[heap.top().second & 0xFF] = 0;
+      }
+      return;
+    }
+    std::vector<std::array<uint16_t, 2>> children;
+    std::vector<size_t> sizes;
+    while (heap.size() > 1) {
+      auto const [size0, id0] = heap.top();
+      heap.pop();
+      auto const [size1, id1] = heap.top();
+      heap.pop();
+      children.push_back({id0, id1});
+      sizes.push_back(size0 + size1);
+      heap.emplace(size0 + size1, static_cast<uint16_t>(children.size() - 1));
+    }
+
+    // Renumber the inner nodes in level order starting with the root.
+    std::vector<uint16_t> order = {static_cast<uint16_t>(children.size() - 1)};
+    std::vector<uint16_t> new_id(children.size());
+    std::vector<uint64_t> node_codes = {0};
+    std::vector<uint8_t> node_depths = {0};
+    size_t begin = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+      uint16_t const id = order[i];
+      new_id[id] = static_cast<uint16_t>(i);
+      nodes_.push_back({begin, 0, children[id]});
+      begin += sizes[id];
+      uint8_t const depth = node_depths[i];
+      PASTA_ASSERT(depth < MAX_CODE_LENGTH, "Huffman code is too long.");
+      for (uint64_t bit = 0; bit < 2; ++bit) {
+        uint16_t const child = children[id][bit];
+        uint64_t const code = node_codes[i] | (bit << depth);
+        if (child & IS_LEAF) {
+          codes_[child & 0xFF] = code;
+          code_lengths_[child & 0xFF] = depth + 1;
+        } else {
+          order.push_back(child);
+          node_codes.push_back(code);
+          node_depths.push_back(depth + 1);
+        }
+      }
+    }
+    for (Node& node : nodes_) {
+      for (uint16_t& child : node.children) {
+        if (!(child & IS_LEAF)) {
+          child = new_id[child];
+        }
+      }
+    }
+  }
+}; // class HuffmanWaveletTree
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,555 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief \f$k^2\f$-tree \cite BrisaboaLN2014K2Tree for sparse binary
+ * relations, e.g., adjacency matrices of graphs, supporting neighbor,
+ * reverse neighbor, cell, and range queries.
+ *
+ * The \f$n\times n\f$ matrix is recursively split into \f$k^2\f$ submatrices
+ * of equal size. Each node of the tree is represented by one bit that is set
+ * if its submatrix contains a one, and the \f$k^2\f$ children of each set bit
+ * are stored (level by level) only if the bit is set. The bits of all inner
+ * levels are stored in one \ref BitVector with \ref FlatRank support, which is
+ * used to navigate to the children. The bits of the last level (the cells of
+ * the matrix) are stored in a second \ref BitVector.
+ *
+ * Since \f$k^2\f$ divides 64, the \f$k^2\f$ bits of the children of a node
+ * are always contained in one 64-bit word, i.e., all children of a node are
+ * considered at once and only one rank query per visited node is required.
+ *
+ * \tparam k Arity of the tree in each dimension (2, 4, or 8).
+ */
+template <size_t k = 2>
+class K2Tree {
+  static_assert(k == 2 || k == 4 || k == 8, "k must be 2, 4, or 8.");
+
+  //! Type of the rank support used to navigate the tree.
+  using RankType = FlatRank<OptimizedFor::ONE_QUERIES, BitVector>;
+
+  //! Number of bits required to represent a digit (of one dimension).
+  static constexpr size_t LOG_K = std::bit_width(k) - 1;
+  //! Number of children of each node.
+  static constexpr size_t K2 = k * k;
+  //! Mask for the \c K2 bits of the children of a node.
+  static constexpr uint64_t BLOCK_MASK =
+      (K2 == 64) ? ~0ULL : ((1ULL << K2) - 1);
+
+  //! Number of rows and columns of the matrix.
+  size_t size_ = 0;
+  //! Height of the tree (number of levels including the last level).
+  size_t height_ = 0;
+  //! Number of ones in the matrix.
+  size_t num_edges_ = 0;
+  //! Bits of all but the last level.
+  BitVector tree_;
+  //! Bits of the last level.
+  BitVector leaves_;
+  //! Rank support for \c tree_.
+  RankType tree_rank_;
+
+public:
+  //! Type of the edges (row, column) the tree is built from.
+  using Edge = std::pair<size_t, size_t>;
+
+  //! Default constructor w/o parameter.
+  K2Tree() = default;
+
+  /*!
+   * \brief Constructor. Creates the \f$k^2\f$-tree for a list of edges.
+   *
+   * The edges are sorted in k-ary Morton order. Then, the nodes of each
+   * level are the distinct prefixes of the sorted edges (in level order).
+   * Therefore, all levels are independent and are computed in parallel (if
+   * OpenMP is available), as is the sorting.
+   * \param num_nodes Number of rows and columns of the matrix.
+   * \param edges Positions (row, column) of the ones in the matrix. Each
+   * position must be smaller than \c num_nodes. Duplicates are allowed.
+   */
+  K2Tree(size_t const num_nodes, std::span<Edge const> const edges)
+      : size_(num_nodes),
+        height_(std::max<size_t>(
+            1,
+            (std::bit_width(std::max<size_t>(num_nodes, 1) - 1) + LOG_K - 1) /
+                LOG_K)) {
+    std::vector<Edge> sorted(edges.begin(), edges.end());
+    sort_edges(sorted);
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    num_edges_ = sorted.size();
+
+    std::vector<BitVector> levels(height_);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (size_t l = 0; l < height_; ++l) {
+      levels[l] = build_level(sorted, l);
+    }
+
+    size_t tree_size = 0;
+    for (size_t l = 0; l + 1 < height_; ++l) {
+      tree_size += levels[l].size();
+    }
+    tree_ = BitVector(tree_size, false);
+    auto tree_data = tree_.data();
+    size_t pos = 0;
+    for (size_t l = 0; l + 1 < height_; ++l) {
+      for (size_t block = 0; block < levels[l].size(); block += K2) {
+        tree_data[pos / 64] |= read_block(levels[l], block) << (pos % 64);
+        pos += K2;
+      }
+    }
+    tree_rank_ = RankType(tree_);
+    leaves_ = std::move(levels.back());
+  }
+
+  //! Default move constructor.
+  K2Tree(K2Tree&&) = default;
+
+  //! Default move assignment.
+  K2Tree& operator=(K2Tree&&) = default;
+
+  /*!
+   * \brief Checks whether a cell of the matrix is set.
+   * \param row Row of the cell.
+   * \param col Column of the cell.
+   * \return \c true if there is an edge from \c row to \c col.
+   */
+  [[nodiscard("contains computed but not used")]] bool
+  contains(size_t const row, size_t const col) const {
+    PASTA_ASSERT(row < size_ && col < size_, "Cell out of bounds.");
+    size_t pos = 0;
+    for (size_t l = 0; l < height_; ++l) {
+      size_t const shift = digit_shift(l);
+      size_t const child = (digit(row, shift) * k) + digit(col, shift);
+      if (l + 1 == height_) {
+        return leaves_[pos - tree_.size() + child];
+      }
+      if (!tree_[pos + child]) {
+        return false;
+      }
+      pos = children(pos + child);
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Computes all neighbors of a node, i.e., the columns of all ones
+   * in a row.
+   * \param row The row whose ones are reported.
+   * \return Columns of all ones in row \c row in increasing order.
+   */
+  [[nodiscard("neighbors computed but not used")]] std::vector<size_t>
+  neighbors(size_t const row) const {
+    PASTA_ASSERT(row < size_, "Row out of bounds.");
+    std::vector<size_t> result;
+    report_range(row, row + 1, 0, size_, [&](size_t, size_t const col) {
+      result.push_back(col);
+    });
+    return result;
+  }
+
+  /*!
+   * \brief Computes all reverse neighbors of a node, i.e., the rows of all
+   * ones in a column.
+   * \param col The column whose ones are reported.
+   * \return Rows of all ones in column \c col in increasing order.
+   */
+  [[nodiscard("reverse neighbors computed but not used")]] std::vector<size_t>
+  reverse_neighbors(size_t const col) const {
+    PASTA_ASSERT(col < size_, "Column out of bounds.");
+    std::vector<size_t> result;
+    report_range(0, size_, col, col + 1, [&](size_t const row, size_t) {
+      result.push_back(row);
+    });
+    return result;
+  }
+
+  /*!
+   * \brief Computes all ones in a rectangular range of the matrix.
+   * \param row_begin First row of the range.
+   * \param row_end Row one past the last row of the range.
+   * \param col_begin First column of the range.
+   * \param col_end Column one past the last column of the range.
+   * \return Positions (row, column) of all ones in the range in k-ary
+   * Morton order.
+   */
+  [[nodiscard("range computed but not used")]] std::vector<Edge>
+  range(size_t const row_begin,
+        size_t const row_end,
+        size_t const col_begin,
+        size_t const col_end) const {
+    std::vector<Edge> result;
+    report_range(std::min(row_begin, size_),
+                 std::min(row_end, size_),
+                 std::min(col_begin, size_),
+                 std::min(col_end, size_),
+                 [&](size_t const row, size_t const col) {
+                   result.emplace_back(row, col);
+                 });
+    return result;
+  }
+
+  /*!
+   * \brief Computes the neighbors of multiple nodes at once.
+   *
+   * The queries are answered level by level, i.e., the children of all
+   * visited nodes of all queries on one level are computed before the next
+   * level is considered. Since the rank queries of different nodes on the
+   * same level are independent, their cache misses can overlap.
+   *
+   * \param rows The rows whose ones are reported.
+   * \return For each row, the columns of all ones in increasing order.
+   */
+  [[nodiscard("neighbors computed but not used")]] std::vector<
+      std::vector<size_t>>
+  neighbors_batch(std::span<size_t const> const rows) const {
+    std::vector<std::vector<size_t>> result(rows.size());
+    struct Node {
+      size_t query;
+      size_t col;
+      size_t pos;
+    };
+    std::vector<Node> current;
+    std::vector<Node> next;
+    current.reserve(rows.size());
+    for (size_t q = 0; q < rows.size(); ++q) {
+      PASTA_ASSERT(rows[q] < size_, "Row out of bounds.");
+      current.push_back({q, 0, 0});
+    }
+    for (size_t l = 0; l < height_ && !current.empty(); ++l) {
+      size_t const shift = digit_shift(l);
+      bool const last_level = (l + 1 == height_);
+      next.clear();
+      for (Node const& node : current) {
+        uint64_t const row_mask = ((1ULL << k) - 1)
+                                  << (digit(rows[node.query], shift) * k);
+        uint64_t const block =
+            last_level ? read_block(leaves_, node.pos - tree_.size()) :
+                         read_block(tree_, node.pos);
+        uint64_t bits = block & row_mask;
+        if (last_level) {
+          for (; bits != 0ULL; bits &= bits - 1) {
+            size_t const j = std::countr_zero(bits) % k;
+            result[node.query].push_back(node.col + j);
+          }
+          continue;
+        }
+        size_t const first_child = tree_rank_.rank1(node.pos) * K2;
+        for (; bits != 0ULL; bits &= bits - 1) {
+          size_t const b = std::countr_zero(bits);
+          next.push_back(
+              {node.query,
+               node.col + ((b % k) << shift),
+               first_child +
+                   (std::popcount(block & ((2ULL << b) - 1)) * K2)});
+        }
+      }
+      std::swap(current, next);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Get the number of rows (and columns) of the matrix.
+   * \return Number of nodes of the graph.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of ones in the matrix.
+   * \return Number of (distinct) edges of the graph.
+   */
+  [[nodiscard("number of edges computed but not used")]] size_t
+  num_edges() const noexcept {
+    return num_edges_;
+  }
+
+  /*!
+   * \brief Get the height of the tree.
+   * \return Number of levels of the tree.
+   */
+  [[nodiscard("height computed but not used")]] size_t
+  height() const noexcept {
+    return height_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) + (tree_.space_usage() - sizeof(tree_)) +
+           (leaves_.space_usage() - sizeof(leaves_)) +
+           (tree_rank_.space_usage() - sizeof(tree_rank_));
+  }
+
+private:
+  /*!
+   * \brief Computes the shift of the digits of a level.
+   * \param level Level of the tree.
+   * \return Number of bits of a row (or column) that are below the digit
+   * of level \c level.
+   */
+  size_t digit_shift(size_t const level) const noexcept {
+    return LOG_K * (height_ - level - 1);
+  }
+
+  /*!
+   * \brief Computes a digit of a row or column.
+   * \param value Row or column.
+   * \param shift Shift of the digit (see \c digit_shift()).
+   * \return The digit (between 0 and k - 1).
+   */
+  static size_t digit(size_t const value, size_t const shift) noexcept {
+    return (value >> shift) & (k - 1);
+  }
+
+  /*!
+   * \brief Computes the position of the children of a set bit.
+   * \param pos Position of a set bit in \c tree_.
+   * \return Position of the first child (in \c tree_ followed by
+   * \c leaves_).
+   */
+  size_t children(size_t const pos) const {
+    return tree_rank_.rank1(pos + 1) * K2;
+  }
+
+  /*!
+   * \brief Reads the \c K2 bits of the children of a node.
+   * \param bv Bit vector containing the bits.
+   * \param pos Position of the first child (a multiple of \c K2).
+   * \return Word containing the bits of the children.
+   */
+  static uint64_t read_block(BitVector const& bv, size_t const pos) {
+    return (bv.data(pos / 64) >> (pos % 64)) & BLOCK_MASK;
+  }
+
+  /*!
+   * \brief Reports all ones in a non-empty range of the matrix.
+   * \param row_begin First row of the range.
+   * \param row_end Row one past the last row of the range.
+   * \param col_begin First column of the range.
+   * \param col_end Column one past the last column of the range.
+   * \param report Function that is called with row and column of each one.
+   */
+  template <typename Report>
+  void report_range(size_t const row_begin,
+                    size_t const row_end,
+                    size_t const col_begin,
+                    size_t const col_end,
+                    Report&& report) const {
+    if (row_begin < row_end && col_begin < col_end) {
+      report_range(row_begin,
+                   row_end - 1,
+                   col_begin,
+                   col_end - 1,
+                   0,
+                   0,
+                   0,
+                   0,
+                   report);
+    }
+  }
+
+  /*!
+   * \brief Recursively reports all ones in a range of the matrix within the
+   * submatrix of a node.
+   * \param row_first First row of the range.
+   * \param row_last Last row of the range (inclusive).
+   * \param col_first First column of the range.
+   * \param col_last Last column of the range (inclusive).
+   * \param row First row of the submatrix of the node.
+   * \param col First column of the submatrix of the node.
+   * \param level Level of the children of the node.
+   * \param pos Position of the first child of the node.
+   * \param report Function that is called with row and column of each one.
+   */
+  template <typename Report>
+  void report_range(size_t const row_first,
+                    size_t const row_last,
+                    size_t const col_first,
+                    size_t const col_last,
+                    size_t const row,
+                    size_t const col,
+                    size_t const level,
+                    size_t const pos,
+                    Report& report) const {
+    size_t const shift = digit_shift(level);
+    // Digits of the children intersecting the range.
+    size_t const i_first = (row_first > row) ? (row_first - row) >> shift : 0;
+    size_t const i_last = std::min(k - 1, (row_last - row) >> shift);
+    size_t const j_first = (col_first > col) ? (col_first - col) >> shift : 0;
+    size_t const j_last = std::min(k - 1, (col_last - col) >> shift);
+    uint64_t const col_mask = ((2ULL << j_last) - 1) & ~((1ULL << j_first) - 1);
+    uint64_t mask = 0;
+    for (size_t i = i_first; i <= i_last; ++i) {
+      mask |= col_mask << (i * k);
+    }
+
+    if (level + 1 == height_) {
+      uint64_t bits = read_block(leaves_, pos - tree_.size()) & mask;
+      for (; bits != 0ULL; bits &= bits - 1) {
+        size_t const b = std::countr_zero(bits);
+        report(row + (b / k), col + (b % k));
+      }
+      return;
+    }
+    uint64_t const block = read_block(tree_, pos);
+    uint64_t bits = block & mask;
+    if (bits == 0ULL) {
+      return;
+    }
+    size_t const first_child = tree_rank_.rank1(pos) * K2;
+    for (; bits != 0ULL; bits &= bits - 1) {
+      size_t const b = std::countr_zero(bits);
+      report_range(row_first,
+                   row_last,
+                   col_first,
+                   col_last,
+                   row + ((b / k) << shift),
+                   col + ((b % k) << shift),
+                   level + 1,
+                   first_child +
+                       (std::popcount(block & ((2ULL << b) - 1)) * K2),
+                   report);
+    }
+  }
+
+  /*!
+   * \brief Computes the bits of one level of the tree.
+   * \param sorted Edges sorted in k-ary Morton order without duplicates.
+   * \param level The level that is computed.
+   * \return Bit vector containing \c K2 bits for each node of the level.
+   */
+  BitVector build_level(std::vector<Edge> const& sorted,
+                        size_t const level) const {
+    size_t const shift = digit_shift(level);
+    // Two edges belong to the same node if the digits of all previous levels
+    // are equal. On the first level, all edges belong to the root.
+    auto const same_node = [&](Edge const& a, Edge const& b) {
+      return level == 0 || ((a.first >> (shift + LOG_K)) ==
+                                (b.first >> (shift + LOG_K)) &&
+                            (a.second >> (shift + LOG_K)) ==
+                                (b.second >> (shift + LOG_K)));
+    };
+    size_t num_nodes = (level == 0) ? 1 : 0;
+    for (size_t i = 0; level > 0 && i < sorted.size(); ++i) {
+      num_nodes += (i == 0 || !same_node(sorted[i - 1], sorted[i])) ? 1 : 0;
+    }
+
+    BitVector result(num_nodes * K2, false);
+    auto data = result.data();
+    size_t node = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      if (i > 0 && !same_node(sorted[i - 1], sorted[i])) {
+        ++node;
+      }
+      size_t const pos = (node * K2) + (digit(sorted[i].first, shift) * k) +
+                         digit(sorted[i].second, shift);
+      data[pos / 64] |= 1ULL << (pos % 64);
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Sorts the edges in k-ary Morton order.
+   *
+   * Two edges are compared by the most significant digit (row digit before
+   * column digit) in which they differ. The edges are split into one chunk
+   * per thread, the chunks are sorted independently and merged pairwise
+   * afterwards.
+   * \param edges The edges that are sorted.
+   */
+  static void sort_edges(std::vector<Edge>& edges) {
+    auto const less = [](Edge const& a, Edge const& b) {
+      size_t const row_digits =
+          (std::bit_width(a.first ^ b.first) + LOG_K - 1) / LOG_K;
+      size_t const col_digits =
+          (std::bit_width(a.second ^ b.second) + LOG_K - 1) / LOG_K;
+      return (row_digits >= col_digits) ? a.first < b.first :
+                                          a.second < b.second;
+    };
+#if defined(_OPENMP)
+    size_t const num_chunks = std::max<size_t>(
+        1,
+        std::min<size_t>(static_cast<size_t>(omp_get_max_threads()),
+                         edges.size() / 4096));
+#else
+    size_t const num_chunks = 1;
+#endif
+    std::vector<size_t> bounds(num_chunks + 1);
+    for (size_t chunk = 0; chunk <= num_chunks; ++chunk) {
+      bounds[chunk] = (edges.size() * chunk) / num_chunks;
+    }
+    auto const begin = edges.begin();
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      std::sort(begin + bounds[chunk], begin + bounds[chunk + 1], less);
+    }
+    for (size_t width = 1; width < num_chunks; width *= 2) {
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+      for (size_t chunk = 0; chunk < num_chunks; chunk += 2 * width) {
+        if (chunk + width < num_chunks) {
+          std::inplace_merge(
+              begin + bounds[chunk],
+              begin + bounds[chunk + width],
+              begin + bounds[std::min(chunk + (2 * width), num_chunks)],
+              less);
+        }
+      }
+    }
+  }
+}; // class K2Tree
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
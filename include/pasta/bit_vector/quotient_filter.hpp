@@ -0,0 +1,563 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/support/select.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Rank-and-select quotient filter (RSQF) \cite PandeyBJP2017CQF, a
+ * counting approximate membership filter supporting insertions and
+ * deletions.
+ *
+ * Each key is hashed to a fingerprint of \f$q + r\f$ bits. The upper
+ * \f$q\f$ bits (the quotient) are the home slot of the fingerprint, where
+ * the lower \f$r\f$ bits (the remainder) are stored. All remainders with the
+ * same quotient form a run of consecutive slots, which starts at the home
+ * slot or, if the slot is used by earlier runs, directly after the previous
+ * run. Runs are sorted by quotient and the remainders within each run are
+ * sorted, too. Inserting a key multiple times stores its remainder multiple
+ * times, i.e., the filter counts the keys.
+ *
+ * The slots are grouped into blocks of 64 slots. Each block consists of a
+ * word marking the occupied home slots, a word marking the ends of runs, the
+ * number of slots of the block used by runs of earlier blocks (offset), and
+ * the bit-packed remainders. Blocks are padded to whole cache lines, which
+ * are filled exactly for \f$r \in \{5, 13, 21, \dots\}\f$. The end of a run
+ * is found using one popcount of the occupied word and \ref select() on the
+ * word(s) marking run ends.
+ */
+class QuotientFilter {
+  //! A cache line, which is the unit the blocks are allocated in.
+  struct alignas(64) CacheLine {
+    //! The words of the cache line.
+    std::array<uint64_t, 8> words;
+  }; // struct CacheLine
+
+  //! Number of words of each block before the remainders.
+  static constexpr size_t HEADER_WORDS = 3;
+  //! Index of the word marking occupied home slots.
+  static constexpr size_t OCCUPIEDS = 0;
+  //! Index of the word marking ends of runs.
+  static constexpr size_t RUNENDS = 1;
+  //! Index of the offset of the block.
+  static constexpr size_t OFFSET = 2;
+  //! Number of keys whose blocks are prefetched ahead in \c count_batch().
+  static constexpr size_t PREFETCH_DISTANCE = 16;
+
+  //! Number of bits of the quotient.
+  size_t quotient_bits_ = 0;
+  //! Number of bits of the remainder.
+  size_t remainder_bits_ = 0;
+  //! Number of home slots (\f$2^q\f$).
+  size_t home_slots_ = 0;
+  //! Number of slots including the overflow slots after the home slots.
+  size_t num_slots_ = 0;
+  //! Number of words per block (a multiple of 8).
+  size_t block_words_ = 0;
+  //! Number of stored fingerprints (including duplicates).
+  size_t size_ = 0;
+  //! Memory of all blocks.
+  std::vector<CacheLine> lines_;
+  //! Pointer to the first word of the first block.
+  uint64_t* words_ = nullptr;
+
+public:
+  //! Default constructor w/o parameter.
+  QuotientFilter() = default;
+
+  /*!
+   * \brief Constructor. Creates an empty filter.
+   *
+   * The false positive rate is roughly \f$2^{-r}\f$ times the load factor.
+   * \param quotient_bits Number of bits of the quotient, i.e., the filter
+   * has \f$2^q\f$ home slots.
+   * \param remainder_bits Number of bits of the remainder (between 1 and
+   * 61, with \f$q + r \le 64\f$).
+   */
+  QuotientFilter(size_t const quotient_bits, size_t const remainder_bits = 13)
+      : quotient_bits_(quotient_bits),
+        remainder_bits_(remainder_bits),
+        home_slots_(1ULL << quotient_bits) {
+    PASTA_ASSERT(0 < remainder_bits_ && remainder_bits_ <= 61,
+                 "Remainder must have between 1 and 61 bits.");
+    PASTA_ASSERT(quotient_bits_ + remainder_bits_ <= 64,
+                 "Fingerprints must fit into 64 bits.");
+    // Runs of the last home slots may extend past the home slots.
+    size_t const overflow_slots =
+        64 + (10 * static_cast<size_t>(
+                       std::sqrt(static_cast<double>(home_slots_))));
+    num_slots_ = ((home_slots_ + overflow_slots + 63) / 64) * 64;
+    block_words_ = ((HEADER_WORDS + remainder_bits_ + 7) / 8) * 8;
+    lines_.resize((num_slots_ / 64) * (block_words_ / 8), CacheLine{});
+    words_ = lines_.front().words.data();
+  }
+
+  //! Default move constructor.
+  QuotientFilter(QuotientFilter&&) = default;
+
+  //! Default move assignment.
+  QuotientFilter& operator=(QuotientFilter&&) = default;
+
+  /*!
+   * \brief Inserts a key (again).
+   * \param key The key.
+   * \return \c false if the filter is full, \c true otherwise.
+   */
+  bool insert(uint64_t const key) {
+    return insert_fingerprint(fingerprint(key));
+  }
+
+  /*!
+   * \brief Removes one occurrence of a key.
+   *
+   * Only keys that have been inserted should be removed, as the key may
+   * share its fingerprint with another key.
+   * \param key The key.
+   * \return \c true if a matching fingerprint was removed.
+   */
+  bool remove(uint64_t const key) {
+    return remove_fingerprint(fingerprint(key));
+  }
+
+  /*!
+   * \brief Counts the occurrences of a key.
+   * \param key The key.
+   * \return Number of inserted keys with the same fingerprint as \c key,
+   * i.e., the number of occurrences of \c key or more in case of a false
+   * positive.
+   */
+  [[nodiscard("count computed but not used")]] size_t
+  count(uint64_t const key) const {
+    return count_fingerprint(fingerprint(key));
+  }
+
+  /*!
+   * \brief Checks whether a key may have been inserted.
+   * \param key The key.
+   * \return \c false if \c key has not been inserted, \c true if it has been
+   * inserted or in case of a false positive.
+   */
+  [[nodiscard("contains computed but not used")]] bool
+  contains(uint64_t const key) const {
+    return count(key) > 0;
+  }
+
+  /*!
+   * \brief Counts the occurrences of multiple keys.
+   *
+   * The blocks required for the key \c PREFETCH_DISTANCE keys later are
+   * prefetched, such that the cache misses of different keys overlap.
+   * \param keys The keys.
+   * \param out Span with at least \c keys.size() elements the counts are
+   * written to.
+   */
+  void count_batch(std::span<uint64_t const> const keys,
+                   std::span<size_t> const out) const {
+    PASTA_ASSERT(out.size() >= keys.size(),
+                 "Output span is smaller than number of keys.");
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (i + PREFETCH_DISTANCE < keys.size()) {
+        size_t const quotient =
+            fingerprint(keys[i + PREFETCH_DISTANCE]) >> remainder_bits_;
+        __builtin_prefetch(block(quotient / 64));
+      }
+      out[i] = count(keys[i]);
+    }
+  }
+
+  /*!
+   * \brief Changes the number of home slots by rehashing all fingerprints.
+   *
+   * The number of bits of the fingerprints does not change, i.e., each
+   * additional quotient bit is taken from the remainder and the false
+   * positive rate increases.
+   * \param quotient_bits New number of bits of the quotient (smaller than
+   * \f$q + r\f$).
+   * \return \c false if the fingerprints do not fit into the resized filter
+   * (then, the filter is not changed), \c true otherwise.
+   */
+  bool resize(size_t const quotient_bits) {
+    size_t const fingerprint_bits = quotient_bits_ + remainder_bits_;
+    PASTA_ASSERT(quotient_bits < fingerprint_bits,
+                 "Remainder must have at least one bit.");
+    QuotientFilter result(quotient_bits, fingerprint_bits - quotient_bits);
+    size_t current = 0;
+    for (size_t quotient = next_occupied(0); quotient < home_slots_;
+         quotient = next_occupied(quotient + 1)) {
+      size_t pos = std::max(quotient, current);
+      size_t const end = next_runend(pos);
+      for (; pos <= end; ++pos) {
+        if (!result.insert_fingerprint((quotient << remainder_bits_) |
+                                       remainder(pos))) {
+          return false;
+        }
+      }
+      current = end + 1;
+    }
+    *this = std::move(result);
+    return true;
+  }
+
+  /*!
+   * \brief Get the number of stored keys.
+   * \return Number of inserted (and not removed) keys.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of home slots.
+   * \return Number of home slots, i.e., \f$2^q\f$.
+   */
+  [[nodiscard("capacity computed but not used")]] size_t
+  capacity() const noexcept {
+    return home_slots_;
+  }
+
+  /*!
+   * \brief Get the number of bits of the quotient.
+   * \return Number of bits of the quotient.
+   */
+  [[nodiscard("quotient bits computed but not used")]] size_t
+  quotient_bits() const noexcept {
+    return quotient_bits_;
+  }
+
+  /*!
+   * \brief Get the number of bits of the remainder.
+   * \return Number of bits of the remainder.
+   */
+  [[nodiscard("remainder bits computed but not used")]] size_t
+  remainder_bits() const noexcept {
+    return remainder_bits_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) + (lines_.size() * sizeof(CacheLine));
+  }
+
+private:
+  /*!
+   * \brief Computes the fingerprint of a key.
+   *
+   * The key is hashed using the (bijective) finalizer of SplitMix64.
+   * \param key The key.
+   * \return The lowest \f$q + r\f$ bits of the hash value.
+   */
+  uint64_t fingerprint(uint64_t key) const noexcept {
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+    size_t const bits = quotient_bits_ + remainder_bits_;
+    return (bits == 64) ? key : (key & ((1ULL << bits) - 1));
+  }
+
+  //! Pointer to the first word of a block.
+  uint64_t* block(size_t const index) noexcept {
+    return words_ + (index * block_words_);
+  }
+
+  //! Pointer to the first word of a block.
+  uint64_t const* block(size_t const index) const noexcept {
+    return words_ + (index * block_words_);
+  }
+
+  //! Reads a bit of the occupied or runend words.
+  bool get_bit(size_t const word, size_t const slot) const noexcept {
+    return (block(slot / 64)[word] >> (slot % 64)) & 1ULL;
+  }
+
+  //! Writes a bit of the occupied or runend words.
+  void set_bit(size_t const word,
+               size_t const slot,
+               bool const value) noexcept {
+    uint64_t& w = block(slot / 64)[word];
+    uint64_t const mask = 1ULL << (slot % 64);
+    w = value ? (w | mask) : (w & ~mask);
+  }
+
+  //! Reads the remainder stored in a slot.
+  uint64_t remainder(size_t const slot) const noexcept {
+    uint64_t const* const remainders = block(slot / 64) + HEADER_WORDS;
+    size_t const bit = (slot % 64) * remainder_bits_;
+    size_t const shift = bit % 64;
+    uint64_t value = remainders[bit / 64] >> shift;
+    if (shift + remainder_bits_ > 64) {
+      value |= remainders[(bit / 64) + 1] << (64 - shift);
+    }
+    return value & ((1ULL << remainder_bits_) - 1);
+  }
+
+  //! Writes the remainder stored in a slot.
+  void set_remainder(size_t const slot, uint64_t const value) noexcept {
+    uint64_t* const remainders = block(slot / 64) + HEADER_WORDS;
+    size_t const bit = (slot % 64) * remainder_bits_;
+    size_t const shift = bit % 64;
+    uint64_t const mask = (1ULL << remainder_bits_) - 1;
+    uint64_t& low = remainders[bit / 64];
+    low = (low & ~(mask << shift)) | (value << shift);
+    if (shift + remainder_bits_ > 64) {
+      uint64_t& high = remainders[(bit / 64) + 1];
+      high = (high & ~(mask >> (64 - shift))) | (value >> (64 - shift));
+    }
+  }
+
+  /*!
+   * \brief Computes the end of the runs of all quotients up to a slot.
+   * \param slot The slot.
+   * \return One past the end of the last run whose quotient is at most
+   * \c slot. If this is at most \c slot, the slot is empty.
+   */
+  size_t run_end_after(size_t const slot) const {
+    uint64_t const* const b = block(slot / 64);
+    size_t const rank = occupied_rank(b, slot);
+    size_t const pos = ((slot / 64) * 64) + b[OFFSET];
+    return (rank == 0) ? pos : nth_runend(pos, rank) + 1;
+  }
+
+  /*!
+   * \brief Computes the slots of the run of an occupied quotient.
+   *
+   * The runs of quotients in earlier blocks end before the offset of the
+   * block. Then, the run of the d-th occupied quotient of the block starts
+   * after the (d-1)-th run end after the offset (or at its home slot), which
+   * is found using \ref select(). Only the block of the quotient and the
+   * blocks containing the run are accessed.
+   * \param quotient The (occupied) quotient.
+   * \return Half-open interval [begin, end) of slots of the run.
+   */
+  std::pair<size_t, size_t> run_bounds(size_t const quotient) const {
+    uint64_t const* const b = block(quotient / 64);
+    size_t const rank = occupied_rank(b, quotient);
+    size_t begin = ((quotient / 64) * 64) + b[OFFSET];
+    if (rank > 1) {
+      begin = nth_runend(begin, rank - 1) + 1;
+    }
+    begin = std::max(begin, quotient);
+    return {begin, next_runend(begin) + 1};
+  }
+
+  //! Number of occupied quotients in a block up to a slot (inclusive).
+  static size_t occupied_rank(uint64_t const* const b,
+                              size_t const slot) noexcept {
+    size_t const shift = slot % 64;
+    uint64_t const up_to = (shift == 63) ? ~0ULL : ((2ULL << shift) - 1);
+    return std::popcount(b[OCCUPIEDS] & up_to);
+  }
+
+  //! Computes the \c rank-th run end at or after a slot.
+  size_t nth_runend(size_t const slot, size_t rank) const {
+    size_t word_pos = slot / 64;
+    uint64_t word = block(word_pos)[RUNENDS] & (~0ULL << (slot % 64));
+    while (true) {
+      size_t const ones = std::popcount(word);
+      if (ones >= rank) {
+        return (word_pos * 64) + select(word, rank - 1);
+      }
+      rank -= ones;
+      PASTA_ASSERT(word_pos + 1 < num_slots_ / 64, "Corrupted filter.");
+      word = block(++word_pos)[RUNENDS];
+    }
+  }
+
+  //! Computes the first run end at or after a slot.
+  size_t next_runend(size_t const slot) const {
+    size_t word_pos = slot / 64;
+    uint64_t word = block(word_pos)[RUNENDS] & (~0ULL << (slot % 64));
+    while (word == 0ULL) {
+      word = block(++word_pos)[RUNENDS];
+    }
+    return (word_pos * 64) + std::countr_zero(word);
+  }
+
+  //! Computes the first occupied home slot at or after a slot (or the
+  //! number of home slots if there is none).
+  size_t next_occupied(size_t const slot) const {
+    if (slot >= home_slots_) {
+      return home_slots_;
+    }
+    size_t word_pos = slot / 64;
+    uint64_t word = block(word_pos)[OCCUPIEDS] & (~0ULL << (slot % 64));
+    while (word == 0ULL) {
+      if (++word_pos * 64 >= home_slots_) {
+        return home_slots_;
+      }
+      word = block(word_pos)[OCCUPIEDS];
+    }
+    return (word_pos * 64) + std::countr_zero(word);
+  }
+
+  //! Computes the first empty slot at or after a slot.
+  size_t first_empty(size_t slot) const {
+    while (slot < num_slots_) {
+      size_t const end = run_end_after(slot);
+      if (end <= slot) {
+        return slot;
+      }
+      slot = end;
+    }
+    return num_slots_;
+  }
+
+  //! Inserts a fingerprint, see \c insert().
+  bool insert_fingerprint(uint64_t const fp) {
+    size_t const quotient = fp >> remainder_bits_;
+    uint64_t const rem = fp & ((1ULL << remainder_bits_) - 1);
+    bool const occupied = get_bit(OCCUPIEDS, quotient);
+    size_t const end = run_end_after(quotient);
+    if (!occupied && end <= quotient) {
+      // The home slot is empty.
+      set_remainder(quotient, rem);
+      set_bit(RUNENDS, quotient, true);
+      set_bit(OCCUPIEDS, quotient, true);
+      ++size_;
+      return true;
+    }
+
+    // Keep the remainders of the run sorted. A new run starts directly
+    // after the runs of all smaller quotients.
+    size_t pos = end;
+    if (occupied) {
+      pos = run_bounds(quotient).first;
+      while (pos < end && remainder(pos) <= rem) {
+        ++pos;
+      }
+    }
+    size_t const empty = first_empty(end);
+    if (empty >= num_slots_) {
+      return false;
+    }
+    for (size_t slot = empty; slot > pos; --slot) {
+      set_remainder(slot, remainder(slot - 1));
+      set_bit(RUNENDS, slot, get_bit(RUNENDS, slot - 1));
+    }
+    set_remainder(pos, rem);
+    if (!occupied) {
+      set_bit(RUNENDS, pos, true);
+      set_bit(OCCUPIEDS, quotient, true);
+    } else if (pos == end) {
+      set_bit(RUNENDS, end - 1, false);
+      set_bit(RUNENDS, pos, true);
+    } else {
+      set_bit(RUNENDS, pos, false);
+    }
+    // All runs in [pos, empty) have been shifted by one slot.
+    for (size_t b = (quotient / 64) + 1; b * 64 <= empty; ++b) {
+      ++block(b)[OFFSET];
+    }
+    ++size_;
+    return true;
+  }
+
+  //! Removes a fingerprint, see \c remove().
+  bool remove_fingerprint(uint64_t const fp) {
+    size_t const quotient = fp >> remainder_bits_;
+    uint64_t const rem = fp & ((1ULL << remainder_bits_) - 1);
+    if (!get_bit(OCCUPIEDS, quotient)) {
+      return false;
+    }
+    auto const [begin, end] = run_bounds(quotient);
+    size_t pos = begin;
+    while (pos < end && remainder(pos) < rem) {
+      ++pos;
+    }
+    if (pos == end || remainder(pos) != rem) {
+      return false;
+    }
+
+    for (size_t slot = pos; slot + 1 < end; ++slot) {
+      set_remainder(slot, remainder(slot + 1));
+    }
+    size_t hole = end - 1;
+    set_bit(RUNENDS, hole, false);
+    if (begin + 1 == end) {
+      set_bit(OCCUPIEDS, quotient, false);
+    } else {
+      set_bit(RUNENDS, hole - 1, true);
+    }
+    // Following runs that are not at their home slot move by one slot.
+    for (size_t next = next_occupied(quotient + 1);
+         next < home_slots_ && next <= hole;
+         next = next_occupied(next + 1)) {
+      size_t const next_end = next_runend(hole + 1);
+      for (size_t slot = hole; slot < next_end; ++slot) {
+        set_remainder(slot, remainder(slot + 1));
+      }
+      set_bit(RUNENDS, next_end - 1, true);
+      set_bit(RUNENDS, next_end, false);
+      hole = next_end;
+    }
+    set_remainder(hole, 0);
+    for (size_t b = (quotient / 64) + 1; b * 64 <= hole; ++b) {
+      uint64_t& offset = block(b)[OFFSET];
+      offset = (offset > 0) ? offset - 1 : 0;
+    }
+    --size_;
+    return true;
+  }
+
+  //! Counts the occurrences of a fingerprint, see \c count().
+  size_t count_fingerprint(uint64_t const fp) const {
+    size_t const quotient = fp >> remainder_bits_;
+    uint64_t const rem = fp & ((1ULL << remainder_bits_) - 1);
+    if (!get_bit(OCCUPIEDS, quotient)) {
+      return 0;
+    }
+    auto const [begin, end] = run_bounds(quotient);
+    size_t result = 0;
+    for (size_t pos = begin; pos < end; ++pos) {
+      uint64_t const value = remainder(pos);
+      if (value > rem) {
+        break;
+      }
+      result += (value == rem) ? 1 : 0;
+    }
+    return result;
+  }
+}; // class QuotientFilter
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,461 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector
+//! \{
+
+namespace internal {
+
+//! Cookie of the Roaring format if there are run containers.
+constexpr uint32_t ROARING_SERIAL_COOKIE = 12347;
+//! Cookie of the Roaring format if there are no run containers.
+constexpr uint32_t ROARING_SERIAL_COOKIE_NO_RUNCONTAINER = 12346;
+//! With run containers, offsets are only stored for at least this many
+//! containers.
+constexpr size_t ROARING_NO_OFFSET_THRESHOLD = 4;
+//! Maximum cardinality of array containers.
+constexpr size_t ROARING_MAX_ARRAY_CARDINALITY = 4096;
+//! Number of 64-bit words in a bitmap container (2^16 bits).
+constexpr size_t ROARING_CHUNK_WORDS = 1024;
+
+/*!
+ * \brief Sets all bits in [begin, end) of zero-initialized words.
+ *
+ * Complete words are filled using \c std::fill_n.
+ */
+inline void fill_range(uint64_t* const data,
+                       size_t const begin,
+                       size_t const end) {
+  size_t const first_word = begin / 64;
+  size_t const last_word = (end - 1) / 64;
+  uint64_t const first_mask = ~0ULL << (begin % 64);
+  uint64_t const last_mask = ~0ULL >> (63 - ((end - 1) % 64));
+  if (first_word == last_word) {
+    data[first_word] |= first_mask & last_mask;
+    return;
+  }
+  data[first_word] |= first_mask;
+  std::fill_n(data + first_word + 1, last_word - first_word - 1, ~0ULL);
+  data[last_word] |= last_mask;
+}
+
+//! Bounds-checked reader of a byte buffer.
+class ByteReader {
+  //! The byte buffer.
+  std::span<uint8_t const> bytes_;
+  //! Current position in the buffer.
+  size_t pos_ = 0;
+
+public:
+  //! Constructor. Creates a reader starting at the beginning of the buffer.
+  explicit ByteReader(std::span<uint8_t const> const bytes) : bytes_(bytes) {}
+
+  //! Reads a value, returns \c false if the buffer is too short.
+  template <typename T>
+  bool read(T& value) {
+    if (bytes_.size() - pos_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, bytes_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  //! Returns a view of the next \c n bytes or an empty view if the buffer is
+  //! too short.
+  std::span<uint8_t const> take(size_t const n) {
+    if (bytes_.size() - pos_ < n) {
+      return {};
+    }
+    pos_ += n;
+    return bytes_.subspan(pos_ - n, n);
+  }
+
+  //! Current position in the buffer.
+  size_t position() const {
+    return pos_;
+  }
+
+  //! Move to a position in the buffer.
+  bool seek(size_t const pos) {
+    if (pos > bytes_.size()) {
+      return false;
+    }
+    pos_ = pos;
+    return true;
+  }
+}; // class ByteReader
+
+//! Appends the bytes of a value to a byte buffer.
+template <typename T>
+void append_bytes(std::vector<uint8_t>& out, T const value) {
+  size_t const pos = out.size();
+  out.resize(pos + sizeof(T));
+  std::memcpy(out.data() + pos, &value, sizeof(T));
+}
+
+} // namespace internal
+
+/*!
+ * \brief Decodes a bitmap in the portable Roaring serialization format
+ * \cite LemireKKDOSS2018Roaring into a \ref BitVector.
+ *
+ * The containers are expanded directly into the words of the bit vector:
+ * Bitmap containers (2^16 bits) are copied using \c std::memcpy, array
+ * containers are written one word at a time (as the values are sorted, each
+ * word is accumulated in a register and stored once), and run containers are
+ * written using range fills. Only 32-bit Roaring bitmaps in little-endian
+ * byte order (on a little-endian host) are supported.
+ * \param bytes The serialized bitmap.
+ * \param size Size of the resulting bit vector. If it is zero, the size is
+ * the largest value in the bitmap plus one.
+ * \return The bit vector or \c std::nullopt if the input is malformed or
+ * contains a value larger than or equal to a non-zero \c size.
+ */
+[[nodiscard("decoded bit vector not used")]] inline std::optional<BitVector>
+read_roaring(std::span<uint8_t const> const bytes, size_t size = 0) {
+  using namespace internal;
+  ByteReader reader(bytes);
+  uint32_t cookie = 0;
+  if (!reader.read(cookie)) {
+    return std::nullopt;
+  }
+  size_t num_containers = 0;
+  std::span<uint8_t const> run_flags;
+  bool has_offsets = true;
+  if ((cookie & 0xFFFF) == ROARING_SERIAL_COOKIE) {
+    num_containers = (cookie >> 16) + 1;
+    run_flags = reader.take((num_containers + 7) / 8);
+    if (run_flags.empty()) {
+      return std::nullopt;
+    }
+    has_offsets = (num_containers >= ROARING_NO_OFFSET_THRESHOLD);
+  } else if (cookie == ROARING_SERIAL_COOKIE_NO_RUNCONTAINER) {
+    uint32_t count = 0;
+    if (!reader.read(count)) {
+      return std::nullopt;
+    }
+    num_containers = count;
+  } else {
+    return std::nullopt;
+  }
+  auto const is_run = [&](size_t const i) {
+    return !run_flags.empty() && ((run_flags[i / 8] >> (i % 8)) & 1) != 0;
+  };
+
+  std::vector<uint16_t> keys(num_containers);
+  std::vector<size_t> cardinalities(num_containers);
+  for (size_t i = 0; i < num_containers; ++i) {
+    uint16_t cardinality = 0;
+    if (!reader.read(keys[i]) || !reader.read(cardinality) ||
+        (i > 0 && keys[i] <= keys[i - 1])) {
+      return std::nullopt;
+    }
+    cardinalities[i] = size_t{cardinality} + 1;
+  }
+  std::vector<uint32_t> offsets;
+  if (has_offsets) {
+    offsets.resize(num_containers);
+    for (auto& offset : offsets) {
+      if (!reader.read(offset)) {
+        return std::nullopt;
+      }
+    }
+  }
+
+  // First pass: find the containers and the largest value.
+  std::vector<std::span<uint8_t const>> containers(num_containers);
+  size_t max_value = 0;
+  for (size_t i = 0; i < num_containers; ++i) {
+    if (has_offsets && !reader.seek(offsets[i])) {
+      return std::nullopt;
+    }
+    size_t const chunk_begin = size_t{keys[i]} << 16;
+    size_t last = 0;
+    if (is_run(i)) {
+      uint16_t num_runs = 0;
+      if (!reader.read(num_runs)) {
+        return std::nullopt;
+      }
+      containers[i] = reader.take(size_t{num_runs} * 4);
+      if (num_runs == 0 || containers[i].empty()) {
+        return std::nullopt;
+      }
+      uint16_t start = 0;
+      uint16_t length = 0;
+      std::memcpy(&start, containers[i].data() + containers[i].size() - 4, 2);
+      std::memcpy(&length, containers[i].data() + containers[i].size() - 2, 2);
+      last = size_t{start} + length;
+    } else if (cardinalities[i] <= ROARING_MAX_ARRAY_CARDINALITY) {
+      containers[i] = reader.take(cardinalities[i] * 2);
+      if (containers[i].empty()) {
+        return std::nullopt;
+      }
+      uint16_t value = 0;
+      std::memcpy(&value, containers[i].data() + containers[i].size() - 2, 2);
+      last = value;
+    } else {
+      containers[i] = reader.take(ROARING_CHUNK_WORDS * 8);
+      if (containers[i].empty()) {
+        return std::nullopt;
+      }
+      size_t word = ROARING_CHUNK_WORDS;
+      uint64_t value = 0;
+      do {
+        std::memcpy(&value, containers[i].data() + (--word * 8), 8);
+      } while (value == 0 && word > 0);
+      if (value == 0) {
+        return std::nullopt;
+      }
+      last = (word * 64) + 63 - std::countl_zero(value);
+    }
+    max_value = std::max(max_value, chunk_begin + last);
+  }
+  if (size == 0) {
+    size = (num_containers == 0) ? 0 : max_value + 1;
+  } else if (num_containers > 0 && max_value >= size) {
+    return std::nullopt;
+  }
+
+  // Second pass: expand the containers.
+  BitVector bv(size, false);
+  uint64_t* const data = bv.data().data();
+  for (size_t i = 0; i < num_containers; ++i) {
+    size_t const chunk_begin = size_t{keys[i]} << 16;
+    auto const container = containers[i];
+    if (is_run(i)) {
+      for (size_t r = 0; r < container.size(); r += 4) {
+        uint16_t start = 0;
+        uint16_t length = 0;
+        std::memcpy(&start, container.data() + r, 2);
+        std::memcpy(&length, container.data() + r + 2, 2);
+        size_t const begin = chunk_begin + start;
+        size_t const end = begin + length + 1;
+        if (end > size) {
+          return std::nullopt;
+        }
+        fill_range(data, begin, end);
+      }
+    } else if (cardinalities[i] <= ROARING_MAX_ARRAY_CARDINALITY) {
+      size_t word_pos = chunk_begin / 64;
+      uint64_t word = 0;
+      uint16_t previous = 0;
+      for (size_t v = 0; v < container.size(); v += 2) {
+        uint16_t value = 0;
+        std::memcpy(&value, container.data() + v, 2);
+        size_t const pos = chunk_begin + value;
+        // Values must be strictly increasing (and thus smaller than the
+        // checked last value).
+        if ((v > 0 && pos <= chunk_begin + previous) || pos >= size) {
+          return std::nullopt;
+        }
+        previous = value;
+        if (pos / 64 != word_pos) {
+          data[word_pos] |= word;
+          word_pos = pos / 64;
+          word = 0;
+        }
+        word |= 1ULL << (pos % 64);
+      }
+      data[word_pos] |= word;
+    } else {
+      // All set bits are smaller than size, i.e., only copying the words
+      // that overlap the bit vector is sufficient.
+      size_t const words =
+          std::min(ROARING_CHUNK_WORDS, ((size + 63) / 64) - (chunk_begin / 64));
+      std::memcpy(data + (chunk_begin / 64), container.data(), words * 8);
+    }
+  }
+  return bv;
+}
+
+/*!
+ * \brief Encodes a \ref BitVector in the portable Roaring serialization
+ * format \cite LemireKKDOSS2018Roaring.
+ *
+ * The bit vector is split into chunks of 2^16 bits. For each chunk, the
+ * cardinality and the number of runs are computed using popcounts on the
+ * words. Then, the smallest container type is chosen (as done by
+ * \c runOptimize() in CRoaring): Bitmap containers are copied using
+ * \c std::memcpy, array and run containers are extracted using \c tzcnt.
+ * \param bv The bit vector that is encoded.
+ * \return The serialized bitmap.
+ */
+[[nodiscard("encoded bitmap not used")]] inline std::vector<uint8_t>
+write_roaring(BitVector const& bv) {
+  using namespace internal;
+  enum class Type : uint8_t { ARRAY, BITMAP, RUN };
+  struct Container {
+    uint16_t key;
+    size_t cardinality;
+    size_t runs;
+    Type type;
+  };
+
+  size_t const size = bv.size();
+  PASTA_ASSERT(size <= (1ULL << 32),
+               "Roaring bitmaps contain only 32-bit values.");
+  size_t const used_words = (size + 63) / 64;
+  uint64_t const* const data = bv.data().data();
+  auto const word_at = [&](size_t const w) {
+    return (w + 1 == used_words && size % 64 != 0) ?
+               data[w] & ((1ULL << (size % 64)) - 1) :
+               data[w];
+  };
+
+  std::vector<Container> containers;
+  for (size_t chunk = 0; chunk * ROARING_CHUNK_WORDS < used_words; ++chunk) {
+    size_t const begin = chunk * ROARING_CHUNK_WORDS;
+    size_t const end = std::min(used_words, begin + ROARING_CHUNK_WORDS);
+    size_t cardinality = 0;
+    size_t runs = 0;
+    uint64_t carry = 0;
+    for (size_t w = begin; w < end; ++w) {
+      uint64_t const word = word_at(w);
+      cardinality += std::popcount(word);
+      // Count the first bits of runs, i.e., set bits whose predecessor is
+      // not set.
+      runs += std::popcount(word & ~((word << 1) | carry));
+      carry = word >> 63;
+    }
+    if (cardinality == 0) {
+      continue;
+    }
+    size_t const run_bytes = 2 + (4 * runs);
+    bool const is_array = cardinality <= ROARING_MAX_ARRAY_CARDINALITY;
+    size_t const other_bytes =
+        is_array ? 2 * cardinality : ROARING_CHUNK_WORDS * 8;
+    Type const type = (run_bytes < other_bytes) ? Type::RUN :
+                      is_array                  ? Type::ARRAY :
+                                                  Type::BITMAP;
+    containers.push_back(
+        {static_cast<uint16_t>(chunk), cardinality, runs, type});
+  }
+
+  size_t const num_containers = containers.size();
+  bool const has_runs =
+      std::any_of(containers.begin(), containers.end(), [](auto const& c) {
+        return c.type == Type::RUN;
+      });
+  std::vector<uint8_t> out;
+  bool has_offsets = true;
+  if (has_runs) {
+    append_bytes(out,
+                 static_cast<uint32_t>(ROARING_SERIAL_COOKIE |
+                                       ((num_containers - 1) << 16)));
+    std::vector<uint8_t> run_flags((num_containers + 7) / 8, 0);
+    for (size_t i = 0; i < num_containers; ++i) {
+      if (containers[i].type == Type::RUN) {
+        run_flags[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+      }
+    }
+    out.insert(out.end(), run_flags.begin(), run_flags.end());
+    has_offsets = (num_containers >= ROARING_NO_OFFSET_THRESHOLD);
+  } else {
+    append_bytes(out, ROARING_SERIAL_COOKIE_NO_RUNCONTAINER);
+    append_bytes(out, static_cast<uint32_t>(num_containers));
+  }
+  for (auto const& container : containers) {
+    append_bytes(out, container.key);
+    append_bytes(out, static_cast<uint16_t>(container.cardinality - 1));
+  }
+  size_t const offsets_pos = out.size();
+  if (has_offsets) {
+    out.resize(out.size() + (4 * num_containers));
+  }
+
+  for (size_t i = 0; i < num_containers; ++i) {
+    auto const& container = containers[i];
+    if (has_offsets) {
+      uint32_t const offset = static_cast<uint32_t>(out.size());
+      std::memcpy(out.data() + offsets_pos + (4 * i), &offset, 4);
+    }
+    size_t const begin = size_t{container.key} * ROARING_CHUNK_WORDS;
+    size_t const end = std::min(used_words, begin + ROARING_CHUNK_WORDS);
+    if (container.type == Type::BITMAP) {
+      size_t const pos = out.size();
+      out.resize(pos + (ROARING_CHUNK_WORDS * 8), 0);
+      std::memcpy(out.data() + pos, data + begin, (end - begin) * 8);
+      if (end == used_words) {
+        uint64_t const last_word = word_at(end - 1);
+        std::memcpy(out.data() + pos + ((end - 1 - begin) * 8), &last_word, 8);
+      }
+    } else if (container.type == Type::ARRAY) {
+      for (size_t w = begin; w < end; ++w) {
+        for (uint64_t word = word_at(w); word != 0; word &= word - 1) {
+          append_bytes(out,
+                       static_cast<uint16_t>(((w - begin) * 64) +
+                                             std::countr_zero(word)));
+        }
+      }
+    } else {
+      append_bytes(out, static_cast<uint16_t>(container.runs));
+      // Find runs of ones by alternating between searching the next one and
+      // the next zero.
+      size_t const chunk_bits = (end - begin) * 64;
+      size_t pos = 0;
+      while (pos < chunk_bits) {
+        uint64_t word = word_at(begin + (pos / 64)) >> (pos % 64);
+        if (word == 0) {
+          pos = ((pos / 64) + 1) * 64;
+          continue;
+        }
+        pos += std::countr_zero(word);
+        size_t run_end = pos;
+        while (run_end < chunk_bits) {
+          uint64_t const ones = ~word_at(begin + (run_end / 64)) >>
+                                (run_end % 64);
+          size_t const length = (ones == 0) ? 64 - (run_end % 64) :
+                                              std::countr_zero(ones);
+          run_end += length;
+          if (ones != 0) {
+            break;
+          }
+        }
+        append_bytes(out, static_cast<uint16_t>(pos));
+        append_bytes(out, static_cast<uint16_t>(run_end - pos - 1));
+        pos = run_end;
+      }
+    }
+  }
+  return out;
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector
+//! \{
+
+/*!
+ * \brief Reads a bit vector serialized by sdsl-lite (\c sdsl::bit_vector,
+ * i.e., \c sdsl::int_vector<1>).
+ *
+ * The on-disk layout consists of the number of bits as 64-bit integer
+ * followed by \f$\lceil n/64\rceil\f$ 64-bit words. Within each word, the
+ * bits are stored starting at the least significant bit, which is the same
+ * layout used by \ref BitVector. Thus, all words are read directly into the
+ * storage of the bit vector using one bulk read. Rank and select support
+ * (e.g., \ref FlatRankSelect) has to be built after reading, as the layouts
+ * of the sdsl-lite rank and select structures differ.
+ *
+ * Both sdsl-lite and this function use the native byte order. If the
+ * stream is seekable, the size stored in the stream is checked against the
+ * remaining number of bytes before any memory is allocated.
+ * \param in Stream the bit vector is read from (opened in binary mode).
+ * \return The bit vector or \c std::nullopt if the stream ended
+ * prematurely or the stored size is too large.
+ */
+[[nodiscard("read bit vector not used")]] inline std::optional<BitVector>
+read_sdsl_bit_vector(std::istream& in) {
+  uint64_t size = 0;
+  if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    return std::nullopt;
+  }
+  if (size > std::numeric_limits<uint64_t>::max() - 63) {
+    return std::nullopt;
+  }
+  size_t const words = (size + 63) / 64;
+  if (words > static_cast<size_t>(std::numeric_limits<std::streamsize>::max()) /
+                  sizeof(uint64_t)) {
+    return std::nullopt;
+  }
+  std::streamsize const bytes =
+      static_cast<std::streamsize>(words * sizeof(uint64_t));
+  // Do not trust the size before allocating: a corrupted header would
+  // otherwise result in a huge allocation.
+  std::istream::pos_type const begin = in.tellg();
+  if (begin != std::istream::pos_type(-1)) {
+    in.seekg(0, std::ios::end);
+    std::istream::pos_type const end = in.tellg();
+    in.seekg(begin);
+    if (!in || end - begin < bytes) {
+      return std::nullopt;
+    }
+  }
+
+  BitVector bv(size);
+  auto data = bv.data();
+  if (!in.read(reinterpret_cast<char*>(data.data()), bytes)) {
+    return std::nullopt;
+  }
+  // Clear the bits after the end of the bit vector.
+  std::fill(data.begin() + words, data.end(), 0ULL);
+  if (size % 64 != 0) {
+    data[words - 1] &= (1ULL << (size % 64)) - 1;
+  }
+  return bv;
+}
+
+/*!
+ * \brief Reads a bit vector serialized by sdsl-lite from a file (see
+ * \ref read_sdsl_bit_vector(std::istream&)).
+ * \param path Path of the file.
+ * \return The bit vector or \c std::nullopt if the file could not be read.
+ */
+[[nodiscard("read bit vector not used")]] inline std::optional<BitVector>
+read_sdsl_bit_vector(std::string const& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return std::nullopt;
+  }
+  return read_sdsl_bit_vector(in);
+}
+
+/*!
+ * \brief Writes a bit vector in the layout of sdsl-lite's
+ * \c sdsl::bit_vector, such that it can be loaded using \c sdsl::load().
+ *
+ * Bits after the end of the bit vector are written as zeros.
+ * \param bv The bit vector that is written.
+ * \param out Stream the bit vector is written to (opened in binary mode).
+ * \return \c true if the bit vector was written successfully.
+ */
+inline bool write_sdsl_bit_vector(BitVector const& bv, std::ostream& out) {
+  uint64_t const size = bv.size();
+  out.write(reinterpret_cast<char const*>(&size), sizeof(size));
+  size_t const full_words = size / 64;
+  out.write(reinterpret_cast<char const*>(bv.data().data()),
+            static_cast<std::streamsize>(full_words * sizeof(uint64_t)));
+  if (size % 64 != 0) {
+    uint64_t const last_word =
+        bv.data(full_words) & ((1ULL << (size % 64)) - 1);
+    out.write(reinterpret_cast<char const*>(&last_word), sizeof(last_word));
+  }
+  return static_cast<bool>(out);
+}
+
+/*!
+ * \brief Writes a bit vector in the layout of sdsl-lite's
+ * \c sdsl::bit_vector to a file (see
+ * \ref write_sdsl_bit_vector(BitVector const&, std::ostream&)).
+ * \param bv The bit vector that is written.
+ * \param path Path of the file (overwritten if it exists).
+ * \return \c true if the bit vector was written successfully.
+ */
+inline bool write_sdsl_bit_vector(BitVector const& bv,
+                                  std::string const& path) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  return out && write_sdsl_bit_vector(bv, out) && out.flush();
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,410 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/find_l2_flat_with.hpp"
+#include "pasta/bit_vector/support/flat_rank_select.hpp"
+#include "pasta/bit_vector/support/l12_type.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_rank_select
+//! \{
+
+/*!
+ * \brief \ref BitVector with \ref FlatRankSelect support that is placed in a
+ * POSIX shared memory segment, such that multiple processes can query one
+ * copy of the data.
+ *
+ * One builder process calls \c create(), which computes the rank and select
+ * information and copies the bit vector and all auxiliary arrays into a new
+ * segment. All other processes call \c attach(), which maps the segment
+ * read-only and creates a \ref FlatRankSelect that directly uses the mapped
+ * memory, i.e., nothing is copied or recomputed.
+ *
+ * The segment contains a header with the offsets (relative to the beginning
+ * of the segment) of all arrays, as the segment may be mapped at a different
+ * address in each process. All arrays start at a 64-byte boundary.
+ *
+ * Handoff protocol: The builder creates the segment exclusively (creation
+ * fails if a segment with the same name exists), sets its final size, and
+ * writes all arrays. The magic number in the header is written last (with
+ * release semantics). \c attach() fails if the segment does not exist or
+ * if the magic number is not (yet) set, in which case the caller can retry.
+ * The segment exists until \c remove() is called, even after all processes
+ * have unmapped it.
+ *
+ * \tparam optimized_for See \ref FlatRankSelect.
+ * \tparam find_with See \ref FlatRankSelect.
+ */
+template <OptimizedFor optimized_for = OptimizedFor::DONT_CARE,
+          FindL2FlatWith find_with = FindL2FlatWith::LINEAR_SEARCH>
+class SharedFlatRankSelect {
+  //! Type of the rank and select support used on the mapped memory.
+  using RankSelectType = FlatRankSelect<optimized_for, find_with, BitVector>;
+
+  //! Magic number marking a completely written segment.
+  static constexpr uint64_t MAGIC = 0x70617374615f7273ULL;
+  //! Version of the segment layout.
+  static constexpr uint64_t VERSION = 1;
+
+  /*!
+   * \brief Header at the beginning of the segment. All offsets are in bytes
+   * relative to the beginning of the segment.
+   */
+  struct Header {
+    //! \c MAGIC once the segment is completely written.
+    uint64_t magic;
+    //! Version of the segment layout.
+    uint64_t version;
+    //! Size of the segment in bytes.
+    uint64_t segment_size;
+    //! Size of the bit vector in bits.
+    uint64_t bit_size;
+    //! Offset of the 64-bit words of the bit vector.
+    uint64_t data_offset;
+    //! Number of 64-bit words of the bit vector.
+    uint64_t data_size;
+    //! Offset of the L1- and L2-blocks.
+    uint64_t l12_offset;
+    //! Number of L1- and L2-blocks.
+    uint64_t l12_size;
+    //! Number of L1- and L2-blocks used by queries.
+    uint64_t l12_end;
+    //! Offset of the samples of zeros.
+    uint64_t samples0_offset;
+    //! Number of samples of zeros.
+    uint64_t samples0_size;
+    //! Offset of the samples of ones.
+    uint64_t samples1_offset;
+    //! Number of samples of ones.
+    uint64_t samples1_size;
+  }; // struct Header
+
+  //! Beginning of the mapped segment.
+  void* segment_ = nullptr;
+  //! Size of the mapped segment in bytes.
+  size_t segment_size_ = 0;
+  //! Size of the bit vector in bits.
+  size_t bit_size_ = 0;
+  //! Pointer to the words of the bit vector in the mapped segment.
+  uint64_t const* data_ = nullptr;
+  //! Rank and select support using the mapped segment.
+  RankSelectType rs_;
+
+public:
+  //! Default constructor w/o parameter.
+  SharedFlatRankSelect() = default;
+
+  //! Move constructor. The moved-from object no longer owns the mapping.
+  SharedFlatRankSelect(SharedFlatRankSelect&& other) noexcept
+      : segment_(std::exchange(other.segment_, nullptr)),
+        segment_size_(std::exchange(other.segment_size_, 0)),
+        bit_size_(other.bit_size_),
+        data_(other.data_),
+        rs_(std::move(other.rs_)) {}
+
+  //! Move assignment. The moved-from object no longer owns the mapping.
+  SharedFlatRankSelect& operator=(SharedFlatRankSelect&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      segment_ = std::exchange(other.segment_, nullptr);
+      segment_size_ = std::exchange(other.segment_size_, 0);
+      bit_size_ = other.bit_size_;
+      data_ = other.data_;
+      rs_ = std::move(other.rs_);
+    }
+    return *this;
+  }
+
+  //! Destructor. Unmaps the segment (the segment itself is not removed).
+  ~SharedFlatRankSelect() {
+    unmap();
+  }
+
+  /*!
+   * \brief Creates a new shared memory segment containing a bit vector and
+   * its rank and select support.
+   * \param name Name of the segment (see \c shm_open(), e.g.,
+   * \c "/my_index").
+   * \param bv The bit vector that is placed in the segment.
+   * \return \c true if the segment has been created and written completely.
+   * \c false if the segment already exists or could not be created.
+   */
+  static bool create(std::string const& name, BitVector& bv) {
+    RankSelectType const rs(bv);
+
+    auto const align = [](size_t const offset) {
+      return (offset + 63) / 64 * 64;
+    };
+    Header header = {};
+    header.version = VERSION;
+    header.bit_size = bv.size();
+    header.data_offset = align(sizeof(Header));
+    header.data_size = bv.data().size();
+    header.l12_offset =
+        align(header.data_offset + (header.data_size * sizeof(uint64_t)));
+    header.l12_size = rs.l12_.size();
+    header.l12_end = rs.l12_end_;
+    header.samples0_offset =
+        align(header.l12_offset + (header.l12_size * sizeof(BigL12Type)));
+    header.samples0_size = rs.samples0_.size();
+    header.samples1_offset = align(header.samples0_offset +
+                                   (header.samples0_size * sizeof(uint32_t)));
+    header.samples1_size = rs.samples1_.size();
+    header.segment_size =
+        header.samples1_offset + (header.samples1_size * sizeof(uint32_t));
+
+    int const fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+      return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(header.segment_size)) != 0) {
+      close(fd);
+      shm_unlink(name.c_str());
+      return false;
+    }
+    void* const segment = mmap(nullptr,
+                               header.segment_size,
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED,
+                               fd,
+                               0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+      shm_unlink(name.c_str());
+      return false;
+    }
+
+    auto* const bytes = static_cast<char*>(segment);
+    std::memcpy(bytes + header.data_offset,
+                bv.data().data(),
+                header.data_size * sizeof(uint64_t));
+    std::memcpy(bytes + header.l12_offset,
+                rs.l12_.data(),
+                header.l12_size * sizeof(BigL12Type));
+    std::memcpy(bytes + header.samples0_offset,
+                rs.samples0_.data(),
+                header.samples0_size * sizeof(uint32_t));
+    std::memcpy(bytes + header.samples1_offset,
+                rs.samples1_.data(),
+                header.samples1_size * sizeof(uint32_t));
+    std::memcpy(bytes, &header, sizeof(Header));
+    // Publish the segment.
+    std::atomic_ref<uint64_t>(static_cast<Header*>(segment)->magic)
+        .store(MAGIC, std::memory_order_release);
+    munmap(segment, header.segment_size);
+    return true;
+  }
+
+  /*!
+   * \brief Maps an existing, completely written segment read-only.
+   * \param name Name of the segment.
+   * \return The rank and select support on the mapped segment or
+   * \c std::nullopt if the segment does not exist, is not completely written
+   * (yet), or is not valid.
+   */
+  [[nodiscard("attached segment not used")]] static std::optional<
+      SharedFlatRankSelect>
+  attach(std::string const& name) {
+    int const fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        static_cast<size_t>(info.st_size) < sizeof(Header)) {
+      close(fd);
+      return std::nullopt;
+    }
+    size_t const segment_size = static_cast<size_t>(info.st_size);
+    void* const segment =
+        mmap(nullptr, segment_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+      return std::nullopt;
+    }
+
+    SharedFlatRankSelect result;
+    result.segment_ = segment;
+    result.segment_size_ = segment_size;
+    Header const& header = *static_cast<Header const*>(segment);
+    // The segment is mapped read-only, but atomic_ref requires a non-const
+    // reference. The value is only loaded.
+    uint64_t const magic =
+        std::atomic_ref<uint64_t>(const_cast<uint64_t&>(header.magic))
+            .load(std::memory_order_acquire);
+    if (magic != MAGIC || header.version != VERSION ||
+        header.segment_size != segment_size || !valid_layout(header)) {
+      return std::nullopt;
+    }
+    auto const* const bytes = static_cast<char const*>(segment);
+    result.bit_size_ = header.bit_size;
+    result.data_ =
+        reinterpret_cast<uint64_t const*>(bytes + header.data_offset);
+    result.rs_ = RankSelectType(
+        result.data_,
+        header.data_size,
+        reinterpret_cast<BigL12Type const*>(bytes + header.l12_offset),
+        header.l12_end,
+        reinterpret_cast<uint32_t const*>(bytes + header.samples0_offset),
+        reinterpret_cast<uint32_t const*>(bytes + header.samples1_offset));
+    return result;
+  }
+
+  /*!
+   * \brief Removes a segment. Processes that have attached the segment can
+   * still use it until they unmap it.
+   * \param name Name of the segment.
+   * \return \c true if the segment has been removed.
+   */
+  static bool remove(std::string const& name) {
+    return shm_unlink(name.c_str()) == 0;
+  }
+
+  /*!
+   * \brief Access a bit of the shared bit vector.
+   * \param index Index of the bit.
+   * \return Value of the bit at position \c index.
+   */
+  [[nodiscard("access computed but not used")]] bool
+  operator[](size_t const index) const noexcept {
+    return (data_[index / 64] >> (index % 64)) & 1ULL;
+  }
+
+  /*!
+   * \brief Computes rank of zeros.
+   * \param index Index the rank of zeros is computed for.
+   * \return Number of zeros (rank) before position \c index.
+   */
+  [[nodiscard("rank0 computed but not used")]] size_t
+  rank0(size_t const index) const {
+    return rs_.rank0(index);
+  }
+
+  /*!
+   * \brief Computes rank of ones.
+   * \param index Index the rank of ones is computed for.
+   * \return Number of ones (rank) before position \c index.
+   */
+  [[nodiscard("rank1 computed but not used")]] size_t
+  rank1(size_t const index) const {
+    return rs_.rank1(index);
+  }
+
+  /*!
+   * \brief Get position of specific zero, i.e., select.
+   * \param rank Rank of zero the position is searched for.
+   * \return Position of the rank-th zero.
+   */
+  [[nodiscard("select0 computed but not used")]] size_t
+  select0(size_t const rank) const {
+    return rs_.select0(rank);
+  }
+
+  /*!
+   * \brief Get position of specific one, i.e., select.
+   * \param rank Rank of one the position is searched for.
+   * \return Position of the rank-th one.
+   */
+  [[nodiscard("select1 computed but not used")]] size_t
+  select1(size_t const rank) const {
+    return rs_.select1(rank);
+  }
+
+  /*!
+   * \brief Get the size of the shared bit vector in bits.
+   * \return Size of the shared bit vector in bits.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return bit_size_;
+  }
+
+  /*!
+   * \brief Get the size of the mapped segment.
+   * \return Size of the mapped segment in bytes (shared by all processes).
+   */
+  [[nodiscard("segment size computed but not used")]] size_t
+  segment_size() const noexcept {
+    return segment_size_;
+  }
+
+private:
+  /*!
+   * \brief Check that all arrays described by a header lie within the
+   * segment (after the header), start at a 64-byte boundary, and have sizes
+   * that match the size of the bit vector. Thus, stale or foreign segments
+   * cannot result in reads outside of the segment.
+   * \param header Header of a segment of \c header.segment_size bytes.
+   * \return \c true if the layout is valid.
+   */
+  static bool valid_layout(Header const& header) {
+    auto const valid_array = [&](uint64_t const offset,
+                                 uint64_t const size,
+                                 size_t const element_bytes) {
+      return offset % 64 == 0 && offset >= sizeof(Header) &&
+             offset <= header.segment_size &&
+             size <= (header.segment_size - offset) / element_bytes;
+    };
+    return header.data_size == (header.bit_size / 64) + 1 &&
+           header.l12_end <= header.l12_size &&
+           valid_array(header.data_offset,
+                       header.data_size,
+                       sizeof(uint64_t)) &&
+           valid_array(header.l12_offset,
+                       header.l12_size,
+                       sizeof(BigL12Type)) &&
+           valid_array(header.samples0_offset,
+                       header.samples0_size,
+                       sizeof(uint32_t)) &&
+           valid_array(header.samples1_offset,
+                       header.samples1_size,
+                       sizeof(uint32_t));
+  }
+
+  //! Unmaps the segment if it is mapped.
+  void unmap() noexcept {
+    if (segment_ != nullptr) {
+      munmap(segment_, segment_size_);
+      segment_ = nullptr;
+    }
+  }
+}; // class SharedFlatRankSelect
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,250 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/popcount.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector
+//! \{
+
+/*!
+ * \brief Result of \ref similarity(): popcounts of the intersection, union,
+ * and symmetric difference of two \ref BitVector.
+ */
+struct SimilarityCounts {
+  //! Number of positions set in both bit vectors, i.e., popcount(a & b).
+  size_t intersection = 0;
+  //! Number of positions set in at least one bit vector, i.e.,
+  //! popcount(a | b).
+  size_t union_count = 0;
+  //! Number of positions where the bit vectors differ, i.e.,
+  //! popcount(a ^ b).
+  size_t hamming_distance = 0;
+
+  /*!
+   * \brief Jaccard similarity of the two bit vectors.
+   * \return |a & b| / |a | b| or 1 if both bit vectors contain no ones.
+   */
+  [[nodiscard("jaccard computed but not used")]] double
+  jaccard() const noexcept {
+    return (union_count == 0) ? 1.0 :
+                                static_cast<double>(intersection) /
+                                    static_cast<double>(union_count);
+  }
+}; // struct SimilarityCounts
+
+namespace internal {
+
+/*!
+ * \brief Computes popcount(a & b) and popcount(a ^ b) of multiple 64-bit
+ * words in one pass.
+ *
+ * With AVX-512 VPOPCNTDQ, eight words are counted per instruction. With
+ * AVX2, the popcount of each byte is computed using a 4-bit lookup table
+ * (\c vpshufb) and summed up using \c vpsadbw. Otherwise, \c popcnt is used.
+ * Note that there are no bound checks.
+ *
+ * \tparam Intersection Whether popcount(a & b) is computed. Otherwise, only
+ * popcount(a ^ b) is computed.
+ * \param a Pointer to the words of the first bit vector.
+ * \param b Pointer to the words of the second bit vector.
+ * \param words Number of words that are considered.
+ * \param intersection popcount(a & b) is added to this variable.
+ * \param difference popcount(a ^ b) is added to this variable.
+ */
+template <bool Intersection>
+inline void popcount_and_xor(uint64_t const* const a,
+                             uint64_t const* const b,
+                             size_t const words,
+                             size_t& intersection,
+                             size_t& difference) {
+  size_t i = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+  __m512i and_sum = _mm512_setzero_si512();
+  __m512i xor_sum = _mm512_setzero_si512();
+  for (; i + 8 <= words; i += 8) {
+    __m512i const va = _mm512_loadu_si512(a + i);
+    __m512i const vb = _mm512_loadu_si512(b + i);
+    if constexpr (Intersection) {
+      and_sum = _mm512_add_epi64(
+          and_sum,
+          _mm512_popcnt_epi64(_mm512_and_si512(va, vb)));
+    }
+    xor_sum =
+        _mm512_add_epi64(xor_sum, _mm512_popcnt_epi64(_mm512_xor_si512(va, vb)));
+  }
+  alignas(64) std::array<uint64_t, 8> and_counts;
+  alignas(64) std::array<uint64_t, 8> xor_counts;
+  _mm512_store_si512(and_counts.data(), and_sum);
+  _mm512_store_si512(xor_counts.data(), xor_sum);
+  for (size_t j = 0; j < 8; ++j) {
+    intersection += and_counts[j];
+    difference += xor_counts[j];
+  }
+#elif defined(__AVX2__)
+  __m256i and_sum = _mm256_setzero_si256();
+  __m256i xor_sum = _mm256_setzero_si256();
+  for (; i + 4 <= words; i += 4) {
+    __m256i const va =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+    __m256i const vb =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+    if constexpr (Intersection) {
+      and_sum =
+          _mm256_add_epi64(and_sum, popcount_epi64(_mm256_and_si256(va, vb)));
+    }
+    xor_sum =
+        _mm256_add_epi64(xor_sum, popcount_epi64(_mm256_xor_si256(va, vb)));
+  }
+  auto const horizontal_sum = [](__m256i const v) {
+    return static_cast<size_t>(_mm256_extract_epi64(v, 0)) +
+           static_cast<size_t>(_mm256_extract_epi64(v, 1)) +
+           static_cast<size_t>(_mm256_extract_epi64(v, 2)) +
+           static_cast<size_t>(_mm256_extract_epi64(v, 3));
+  };
+  intersection += horizontal_sum(and_sum);
+  difference += horizontal_sum(xor_sum);
+#endif
+  for (; i < words; ++i) {
+    if constexpr (Intersection) {
+      intersection += std::popcount(a[i] & b[i]);
+    }
+    difference += std::popcount(a[i] ^ b[i]);
+  }
+}
+
+} // namespace internal
+
+/*!
+ * \brief Computes the sizes of intersection, union, and symmetric difference
+ * of two bit vectors of the same size in one pass.
+ *
+ * Only popcount(a & b) and popcount(a ^ b) are computed, as
+ * popcount(a | b) = popcount(a & b) + popcount(a ^ b).
+ * \param a First bit vector.
+ * \param b Second bit vector (same size as \c a).
+ * \return Popcounts of a & b, a | b, and a ^ b.
+ */
+[[nodiscard("similarity computed but not used")]] inline SimilarityCounts
+similarity(BitVector const& a, BitVector const& b) {
+  PASTA_ASSERT(a.size() == b.size(), "Bit vectors must have the same size.");
+  size_t const full_words = a.size() / 64;
+  SimilarityCounts result;
+  internal::popcount_and_xor<true>(a.data().data(),
+                                   b.data().data(),
+                                   full_words,
+                                   result.intersection,
+                                   result.hamming_distance);
+  // Bits after the end of the bit vectors are ignored.
+  if (size_t const rest = a.size() % 64; rest != 0) {
+    uint64_t const mask = (1ULL << rest) - 1;
+    uint64_t const word_a = a.data(full_words) & mask;
+    uint64_t const word_b = b.data(full_words) & mask;
+    result.intersection += std::popcount(word_a & word_b);
+    result.hamming_distance += std::popcount(word_a ^ word_b);
+  }
+  result.union_count = result.intersection + result.hamming_distance;
+  return result;
+}
+
+/*!
+ * \brief Computes the Hamming distance of two bit vectors of the same size.
+ * \param a First bit vector.
+ * \param b Second bit vector (same size as \c a).
+ * \return Number of positions where \c a and \c b differ.
+ */
+[[nodiscard("hamming distance computed but not used")]] inline size_t
+hamming_distance(BitVector const& a, BitVector const& b) {
+  PASTA_ASSERT(a.size() == b.size(), "Bit vectors must have the same size.");
+  size_t const full_words = a.size() / 64;
+  size_t unused = 0;
+  size_t result = 0;
+  internal::popcount_and_xor<false>(a.data().data(),
+                                    b.data().data(),
+                                    full_words,
+                                    unused,
+                                    result);
+  if (size_t const rest = a.size() % 64; rest != 0) {
+    uint64_t const mask = (1ULL << rest) - 1;
+    result += std::popcount((a.data(full_words) ^ b.data(full_words)) & mask);
+  }
+  return result;
+}
+
+/*!
+ * \brief Checks whether the Hamming distance of two bit vectors of the same
+ * size is at most a threshold.
+ *
+ * The bit vectors are compared in blocks of 4096 bits and the comparison
+ * stops as soon as the threshold is exceeded. Thus, dissimilar bit vectors
+ * are usually rejected without reading them completely.
+ * \param a First bit vector.
+ * \param b Second bit vector (same size as \c a).
+ * \param threshold Maximum Hamming distance.
+ * \return \c true if \c a and \c b differ in at most \c threshold positions.
+ */
+[[nodiscard("hamming distance check computed but not used")]] inline bool
+hamming_distance_at_most(BitVector const& a,
+                         BitVector const& b,
+                         size_t const threshold) {
+  PASTA_ASSERT(a.size() == b.size(), "Bit vectors must have the same size.");
+  constexpr size_t BLOCK_WORDS = 64;
+  size_t const full_words = a.size() / 64;
+  uint64_t const* const data_a = a.data().data();
+  uint64_t const* const data_b = b.data().data();
+  size_t unused = 0;
+  size_t distance = 0;
+  for (size_t i = 0; i < full_words; i += BLOCK_WORDS) {
+    internal::popcount_and_xor<false>(data_a + i,
+                                      data_b + i,
+                                      std::min(BLOCK_WORDS, full_words - i),
+                                      unused,
+                                      distance);
+    if (distance > threshold) {
+      return false;
+    }
+  }
+  if (size_t const rest = a.size() % 64; rest != 0) {
+    uint64_t const mask = (1ULL << rest) - 1;
+    distance +=
+        std::popcount((data_a[full_words] ^ data_b[full_words]) & mask);
+  }
+  return distance <= threshold;
+}
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
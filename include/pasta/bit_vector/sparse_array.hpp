@@ -0,0 +1,348 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Sparse array that stores values only for present positions.
+ *
+ * Presence of a value is marked in a \ref BitVector. The values are stored
+ * densely in the order of their positions, such that the value at position
+ * \c i (if present) is stored at position \c rank1(i) of the dense array.
+ * Thus, accessing a value requires one rank query (using \ref FlatRank) and
+ * one additional load.
+ *
+ * \tparam T Type of the stored values.
+ */
+template <typename T>
+class SparseArray {
+  //! Type of the rank support used to index the dense value array.
+  using RankType = FlatRank<OptimizedFor::ONE_QUERIES, BitVector>;
+
+  //! Number of independent rank queries computed before the values are
+  //! loaded in \c get_batch().
+  static constexpr size_t BATCH_SIZE = 16;
+
+  //! Number of positions (present or not) of the array.
+  size_t size_ = 0;
+  //! Bit vector marking all present positions.
+  BitVector present_;
+  //! Rank support for \c present_.
+  RankType rank_;
+  //! Values of all present positions, sorted by position.
+  std::vector<T> values_;
+
+public:
+  /*!
+   * \brief Iterator over all present entries of the \c SparseArray in
+   * increasing order of their position.
+   *
+   * Dereferencing the iterator returns a pair consisting of the position and
+   * a reference to the value stored at that position.
+   */
+  class Iterator {
+  public:
+    //! Iterator category.
+    using iterator_category = std::forward_iterator_tag;
+    //! Difference type.
+    using difference_type = std::ptrdiff_t;
+    //! Value type (position and value of the entry).
+    using value_type = std::pair<size_t, T const&>;
+
+    //! Default constructor required by \c std::forward_iterator.
+    Iterator() = default;
+
+    /*!
+     * \brief Constructor. Creates an iterator pointing at the first present
+     * entry with a position greater or equal to \c word_pos * 64.
+     * \param array \c SparseArray the iterator iterates over.
+     * \param word_pos Index of the 64-bit word the iteration starts at.
+     * \param value_pos Index of the first value that is returned.
+     */
+    Iterator(SparseArray const* array,
+             size_t const word_pos,
+             size_t const value_pos) noexcept
+        : array_(array),
+          word_pos_(word_pos),
+          value_pos_(value_pos) {
+      if (value_pos_ < array_->values_.size()) {
+        word_ = array_->present_.data(word_pos_);
+        advance_to_set_bit();
+      }
+    }
+
+    //! Returns the position and the value of the current entry.
+    value_type operator*() const noexcept {
+      return {(word_pos_ * 64) + std::countr_zero(word_),
+              array_->values_[value_pos_]};
+    }
+
+    //! Prefix increment.
+    Iterator& operator++() noexcept {
+      word_ &= word_ - 1;
+      if (++value_pos_ < array_->values_.size()) {
+        advance_to_set_bit();
+      }
+      return *this;
+    }
+
+    //! Postfix increment.
+    Iterator operator++(int32_t) noexcept {
+      auto tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    //! Iterator comparison equality.
+    friend bool operator==(Iterator const& a, Iterator const& b) noexcept {
+      return a.value_pos_ == b.value_pos_;
+    }
+
+    //! Iterator comparison inequality.
+    friend bool operator!=(Iterator const& a, Iterator const& b) noexcept {
+      return a.value_pos_ != b.value_pos_;
+    }
+
+  private:
+    //! Skip empty 64-bit words until \c word_ contains a set bit.
+    void advance_to_set_bit() noexcept {
+      while (word_ == 0ULL) {
+        word_ = array_->present_.data(++word_pos_);
+      }
+    }
+
+    //! \c SparseArray the iterator iterates over.
+    SparseArray const* array_ = nullptr;
+    //! Index of the current 64-bit word of the presence bit vector.
+    size_t word_pos_ = 0;
+    //! Remaining (not yet reported) set bits of the current word.
+    uint64_t word_ = 0ULL;
+    //! Index of the current value in the dense value array.
+    size_t value_pos_ = 0;
+  }; // class SparseArray::Iterator
+
+  //! Default constructor w/o parameter.
+  SparseArray() = default;
+
+  /*!
+   * \brief Constructor. Creates a sparse array of size \c size containing
+   * the given entries.
+   *
+   * The entries are sorted by position (if not already sorted). Then, the
+   * presence bits and values are written in parallel (if OpenMP is
+   * available), where each thread is responsible for a range of entries that
+   * does not share a 64-bit word with the ranges of other threads.
+   *
+   * \param size Number of positions of the array.
+   * \param entries (Position, value)-pairs of all present entries. Each
+   * position must occur at most once and be smaller than \c size.
+   */
+  SparseArray(size_t const size,
+              std::span<std::pair<size_t, T> const> const entries)
+      : size_(size),
+        present_(size, false),
+        values_(entries.size()) {
+    auto const by_position = [](auto const& a, auto const& b) {
+      return a.first < b.first;
+    };
+    if (std::is_sorted(entries.begin(), entries.end(), by_position)) {
+      init(entries);
+    } else {
+      std::vector<std::pair<size_t, T>> sorted(entries.begin(), entries.end());
+      std::sort(sorted.begin(), sorted.end(), by_position);
+      init(std::span<std::pair<size_t, T> const>(sorted));
+    }
+    rank_ = RankType(present_);
+  }
+
+  //! Default move constructor.
+  SparseArray(SparseArray&&) = default;
+
+  //! Default move assignment.
+  SparseArray& operator=(SparseArray&&) = default;
+
+  /*!
+   * \brief Check if a value is stored at a position.
+   * \param index Position that is checked.
+   * \return \c true if a value is stored at position \c index and \c false
+   * otherwise.
+   */
+  [[nodiscard("contains computed but not used")]] bool
+  contains(size_t const index) const noexcept {
+    return present_[index];
+  }
+
+  /*!
+   * \brief Get the value stored at a position.
+   *
+   * Requires one rank query and one additional load if the value is present.
+   * \param index Position the value is requested for.
+   * \return The value stored at position \c index or a default constructed
+   * \c T, if no value is stored at that position.
+   */
+  [[nodiscard("get computed but not used")]] T get(size_t const index) const {
+    if (!present_[index]) {
+      return T{};
+    }
+    return values_[rank_.rank1(index)];
+  }
+
+  /*!
+   * \brief Get the values stored at multiple positions.
+   *
+   * The rank queries for \c BATCH_SIZE positions are computed before any of
+   * the values is loaded. The rank queries of a batch are independent, which
+   * allows the CPU to overlap their cache misses. Afterwards, the values are
+   * prefetched and loaded.
+   *
+   * \param positions Positions the values are requested for.
+   * \param out Span with at least \c positions.size() elements the values are
+   * written to. Non-present positions are set to a default constructed \c T.
+   */
+  void get_batch(std::span<size_t const> const positions,
+                 std::span<T> const out) const {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output span is smaller than number of queried positions.");
+    std::array<size_t, BATCH_SIZE> ranks;
+    for (size_t begin = 0; begin < positions.size(); begin += BATCH_SIZE) {
+      size_t const end = std::min(begin + BATCH_SIZE, positions.size());
+      for (size_t i = begin; i < end; ++i) {
+        ranks[i - begin] = rank_.rank1(positions[i]);
+        __builtin_prefetch(values_.data() + ranks[i - begin]);
+      }
+      for (size_t i = begin; i < end; ++i) {
+        out[i] = present_[positions[i]] ? values_[ranks[i - begin]] : T{};
+      }
+    }
+  }
+
+  /*!
+   * \brief Get iterator pointing at the first present entry.
+   * \return Iterator pointing at the first present entry.
+   */
+  Iterator begin() const noexcept {
+    return Iterator(this, 0, 0);
+  }
+
+  /*!
+   * \brief Get iterator representing the end of the present entries.
+   * \return Iterator representing the end of the present entries.
+   */
+  Iterator end() const noexcept {
+    return Iterator(this, 0, values_.size());
+  }
+
+  /*!
+   * \brief Get the number of positions of the sparse array.
+   * \return Number of positions (present or not) of the sparse array.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of present entries.
+   * \return Number of positions that store a value.
+   */
+  [[nodiscard("count computed but not used")]] size_t count() const noexcept {
+    return values_.size();
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return (present_.space_usage() - sizeof(present_)) +
+           (rank_.space_usage() - sizeof(rank_)) +
+           (values_.size() * sizeof(T)) + sizeof(*this);
+  }
+
+private:
+  /*!
+   * \brief Writes presence bits and values of entries sorted by position.
+   * \param entries Entries sorted by their position.
+   */
+  void init(std::span<std::pair<size_t, T> const> const entries) {
+    size_t const num_entries = entries.size();
+#if defined(_OPENMP)
+    size_t const num_chunks = static_cast<size_t>(omp_get_max_threads());
+#else
+    size_t const num_chunks = 1;
+#endif
+    // Chunk borders are moved to the right such that no two chunks write the
+    // same 64-bit word of the bit vector.
+    std::vector<size_t> borders(num_chunks + 1, num_entries);
+    borders[0] = 0;
+    for (size_t i = 1; i < num_chunks; ++i) {
+      size_t border = std::max(borders[i - 1], (num_entries * i) / num_chunks);
+      while (border > 0 && border < num_entries &&
+             (entries[border].first / 64) == (entries[border - 1].first / 64)) {
+        ++border;
+      }
+      borders[i] = border;
+    }
+
+    auto present_data = present_.data();
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      for (size_t i = borders[chunk]; i < borders[chunk + 1]; ++i) {
+        size_t const position = entries[i].first;
+        PASTA_ASSERT(position < size_, "Position of entry is out of bounds.");
+        PASTA_ASSERT(i == 0 || entries[i - 1].first < position,
+                     "Positions of entries must be unique.");
+        present_data[position / 64] |= (1ULL << (position % 64));
+        values_[i] = entries[i].second;
+      }
+    }
+  }
+}; // class SparseArray
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
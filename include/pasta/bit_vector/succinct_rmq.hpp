@@ -0,0 +1,679 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank_select.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Succinct range minimum queries \cite FerradaN2017RMQ using
+ * \f$2n + o(n)\f$ bits.
+ *
+ * The shape of the Cartesian tree of the array is encoded as balanced
+ * parentheses: Scanning the array from left to right, all previous elements
+ * that are larger than the current one are closed and the current element is
+ * opened. Then, the minimum of a range corresponds to the rightmost minimum
+ * excess (number of open minus number of closing parentheses) between the
+ * opening parentheses of the first and last element of the range. The
+ * parentheses are stored in a \ref BitVector with \ref FlatRankSelect
+ * support, which is used to find the opening parentheses of the elements.
+ * The minimum excess of each block of 512 bits and of its four sub-blocks
+ * of 128 bits is stored (relative to the excess before the (sub-)block) in
+ * 6 bytes, and a tree with fan-out 8 over the block minima is used to find
+ * the rightmost minimum of a range of blocks. Within a block, only partial
+ * sub-blocks are scanned byte-wise using lookup tables. The original array
+ * is not required to answer queries.
+ */
+class SuccinctRmq {
+  //! Type of the rank and select support used to find opening parentheses.
+  using RankSelectType = FlatRankSelect<OptimizedFor::ONE_QUERIES>;
+
+  //! Number of bits of the parentheses sequence per block.
+  static constexpr size_t BLOCK_BITS = 512;
+  //! Number of bits of the parentheses sequence per sub-block.
+  static constexpr size_t SUB_BLOCK_BITS = 128;
+  //! Fan-out of the tree over the block minima.
+  static constexpr size_t FAN_OUT = 8;
+  //! Number of queries whose opening parentheses are selected (and
+  //! prefetched) before the first of them is answered in \c rmq_batch().
+  static constexpr size_t INTERLEAVED_QUERIES = 16;
+  //! Minimum number of queries for which \c rmq_batch() runs in parallel.
+  static constexpr size_t PARALLEL_QUERIES = 1 << 14;
+
+  //! Excess information about all bytes.
+  struct ByteExcess {
+    //! Excess of the byte.
+    int8_t excess;
+    //! Minimum excess of all non-empty prefixes of the byte.
+    int8_t min;
+    //! Rightmost position of the minimum excess.
+    uint8_t min_pos;
+  }; // struct ByteExcess
+
+  //! Excess information about the first \c length bits of all bytes (for
+  //! each \c length in [1, 8]), where a set bit is an opening and an unset
+  //! bit a closing parenthesis.
+  static constexpr std::array<std::array<ByteExcess, 256>, 9> BYTE_EXCESS =
+      []() {
+        std::array<std::array<ByteExcess, 256>, 9> result = {};
+        for (size_t length = 1; length <= 8; ++length) {
+          for (size_t byte = 0; byte < 256; ++byte) {
+            int8_t excess = 0;
+            int8_t min = 8;
+            uint8_t min_pos = 0;
+            for (uint8_t bit = 0; bit < length; ++bit) {
+              excess += ((byte >> bit) & 1) ? 1 : -1;
+              if (excess <= min) {
+                min = excess;
+                min_pos = bit;
+              }
+            }
+            result[length][byte] = {excess, min, min_pos};
+          }
+        }
+        return result;
+      }();
+
+  //! Minimum excess of a block and its sub-blocks.
+  struct BlockMinima {
+    //! Minimum excess of the block relative to the excess before the block.
+    int16_t block;
+    //! Minimum excess of each sub-block relative to the excess before the
+    //! sub-block.
+    std::array<int8_t, BLOCK_BITS / SUB_BLOCK_BITS> sub_blocks;
+  }; // struct BlockMinima
+
+  //! Number of elements in the array.
+  size_t size_ = 0;
+  //! Balanced parentheses of the Cartesian tree.
+  BitVector bp_;
+  //! Rank and select support for \c bp_.
+  RankSelectType rank_select_;
+  //! Minima of each block, such that a scan of a block accesses only one
+  //! of them.
+  std::vector<BlockMinima> minima_;
+  //! Levels of the tree over the block minima, level \c h contains the
+  //! minimum (absolute) excess of \f$8^{h+1}\f$ consecutive blocks.
+  std::vector<std::vector<int64_t>> levels_;
+
+public:
+  //! Default constructor w/o parameter.
+  SuccinctRmq() = default;
+
+  /*!
+   * \brief Constructor. Creates the range minimum query support for an
+   * array.
+   *
+   * The array is split into one chunk per thread (if OpenMP is available).
+   * First, the stack of the left-to-right scan of each chunk is computed in
+   * parallel. Then, the stack before each chunk is represented as list of
+   * prefixes of the stacks of the previous chunks, which is computed
+   * sequentially (requiring time quadratic in the number of chunks). The
+   * opening parenthesis of the \f$k\f$-th element is at position
+   * \f$2k + 1 - d_k\f$, where \f$d_k\f$ is the size of the stack after
+   * pushing the element, which is the size of the stack in its chunk plus
+   * the number of elements of the stack before its chunk that are not
+   * larger than all elements of the chunk up to \f$k\f$. Therefore, all
+   * chunks can write their parentheses in parallel. Finally, the block
+   * minima and the tree are computed in parallel.
+   * \tparam T Type of the elements, which must be totally ordered.
+   * \param values The array. It is not required to answer queries.
+   */
+  template <typename T>
+  SuccinctRmq(std::span<T const> const values)
+      : size_(values.size()),
+        bp_(2 * values.size(), false) {
+    build_parentheses(values);
+    rank_select_ = RankSelectType(bp_);
+    build_block_minima();
+  }
+
+  //! Default move constructor.
+  SuccinctRmq(SuccinctRmq&&) = default;
+
+  //! Default move assignment.
+  SuccinctRmq& operator=(SuccinctRmq&&) = default;
+
+  /*!
+   * \brief Computes the position of the minimum of a range.
+   * \param begin First position of the range.
+   * \param end Last position of the range (inclusive).
+   * \return Position of the (leftmost) minimum of the array in
+   * [begin, end].
+   */
+  [[nodiscard("rmq computed but not used")]] size_t
+  rmq(size_t const begin, size_t const end) const {
+    PASTA_ASSERT(begin <= end && end < size_, "Invalid range.");
+    if (begin == end) {
+      return begin;
+    }
+    return rmq(begin,
+               end,
+               rank_select_.select1(begin + 1),
+               rank_select_.select1(end + 1));
+  }
+
+  /*!
+   * \brief Computes the positions of the minima of multiple ranges.
+   *
+   * The opening parentheses of the bounds of \c INTERLEAVED_QUERIES queries
+   * are selected and the words containing them (and their block minima) are
+   * prefetched before the first of the queries is answered, such that the
+   * cache misses of different queries overlap. Large batches are answered
+   * in parallel (if OpenMP is available).
+   * \param ranges The ranges [begin, end] (inclusive).
+   * \param out Span with at least \c ranges.size() elements the position of
+   * the (leftmost) minimum of each range is written to.
+   */
+  void rmq_batch(std::span<std::pair<size_t, size_t> const> const ranges,
+                 std::span<size_t> const out) const {
+    PASTA_ASSERT(out.size() >= ranges.size(),
+                 "Output span is smaller than number of ranges.");
+    uint64_t const* const data = bp_.data().data();
+    size_t const num_groups =
+        (ranges.size() + INTERLEAVED_QUERIES - 1) / INTERLEAVED_QUERIES;
+#if defined(_OPENMP)
+#  pragma omp parallel for if (ranges.size() >= PARALLEL_QUERIES)
+#endif
+    for (size_t group = 0; group < num_groups; ++group) {
+      size_t const first = group * INTERLEAVED_QUERIES;
+      size_t const count =
+          std::min(INTERLEAVED_QUERIES, ranges.size() - first);
+      std::array<size_t, INTERLEAVED_QUERIES> opens;
+      std::array<size_t, INTERLEAVED_QUERIES> closes;
+      for (size_t q = 0; q < count; ++q) {
+        auto const [begin, end] = ranges[first + q];
+        PASTA_ASSERT(begin <= end && end < size_, "Invalid range.");
+        if (begin < end) {
+          opens[q] = rank_select_.select1(begin + 1);
+          closes[q] = rank_select_.select1(end + 1);
+          __builtin_prefetch(data + (opens[q] / 64));
+          __builtin_prefetch(data + (closes[q] / 64));
+          __builtin_prefetch(minima_.data() + (opens[q] / BLOCK_BITS));
+          __builtin_prefetch(minima_.data() + (closes[q] / BLOCK_BITS));
+        }
+      }
+      for (size_t q = 0; q < count; ++q) {
+        auto const [begin, end] = ranges[first + q];
+        out[first + q] =
+            (begin < end) ? rmq(begin, end, opens[q], closes[q]) : begin;
+      }
+    }
+  }
+
+  /*!
+   * \brief Get the number of elements of the array.
+   * \return Number of elements of the array.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t result = sizeof(*this) + (bp_.space_usage() - sizeof(bp_)) +
+                    (rank_select_.space_usage() - sizeof(rank_select_)) +
+                    (minima_.size() * sizeof(BlockMinima));
+    for (auto const& level : levels_) {
+      result += level.size() * sizeof(int64_t);
+    }
+    return result;
+  }
+
+private:
+  /*!
+   * \brief Computes the position of the minimum of a range, given the
+   * opening parentheses of the bounds of the range.
+   *
+   * If the rightmost minimum excess between the opening parentheses is
+   * smaller than the excess after the first one, it is followed by the
+   * opening parenthesis of the minimum. Otherwise, the first element of the
+   * range is the minimum. The excess at the borders of the range is known
+   * from the ranks of the parentheses, and the excess at the minimum yields
+   * the number of opening parentheses before it, such that no further rank
+   * queries are required.
+   * \param begin First position of the range.
+   * \param end Last position of the range (inclusive).
+   * \param open Position of the opening parenthesis of \c begin.
+   * \param close Position of the opening parenthesis of \c end.
+   * \return Position of the (leftmost) minimum of the range.
+   */
+  size_t rmq(size_t const begin,
+             size_t const end,
+             size_t const open,
+             size_t const close) const {
+    uint64_t const* const data = bp_.data().data();
+    int64_t const before = (2 * static_cast<int64_t>(begin)) -
+                           static_cast<int64_t>(open);
+    size_t const first_block = open / BLOCK_BITS;
+    size_t const last_block = close / BLOCK_BITS;
+    std::pair<int64_t, size_t> best;
+    if (first_block == last_block) {
+      best = scan(open, close, before);
+    } else {
+      best = scan(open, ((first_block + 1) * BLOCK_BITS) - 1, before);
+      if (first_block + 1 < last_block) {
+        auto const [min, block] = min_blocks(first_block + 1, last_block - 1);
+        if (min <= best.first) {
+          size_t const block_begin = block * BLOCK_BITS;
+          best = scan(block_begin,
+                      block_begin + BLOCK_BITS - 1,
+                      min - minima_[block].block);
+        }
+      }
+      // Excess before the last block, computed from the excess after
+      // \c close and the parentheses of the block up to \c close.
+      size_t const last_begin = last_block * BLOCK_BITS;
+      int64_t ones = std::popcount(data[close / 64] &
+                                   (~0ULL >> (63 - (close % 64))));
+      for (size_t word = last_begin / 64; word < close / 64; ++word) {
+        ones += std::popcount(data[word]);
+      }
+      int64_t const last_before =
+          (2 * static_cast<int64_t>(end + 1 - ones)) -
+          static_cast<int64_t>(last_begin);
+      auto const right = scan(last_begin, close, last_before);
+      best = (right.first <= best.first) ? right : best;
+    }
+    auto const [min, pos] = best;
+    return (min > before) ? begin : static_cast<size_t>((min + pos + 1) / 2);
+  }
+
+  /*!
+   * \brief Computes the rightmost minimum excess in a range of the
+   * parentheses by scanning it.
+   *
+   * Sub-blocks that are completely contained in the range are skipped using
+   * their minima and the popcount of their words. Only the (partial)
+   * sub-blocks at the borders of the range and the sub-block containing the
+   * minimum are scanned byte-wise.
+   * \param pos First position of the range.
+   * \param last Last position of the range (inclusive).
+   * \param excess Excess before \c pos.
+   * \return Minimum excess and its rightmost position.
+   */
+  std::pair<int64_t, size_t>
+  scan(size_t pos, size_t const last, int64_t excess) const {
+    uint64_t const* const data = bp_.data().data();
+    std::pair<int64_t, size_t> best = {std::numeric_limits<int64_t>::max(),
+                                       pos};
+    if (pos % SUB_BLOCK_BITS != 0) {
+      size_t const head_last = std::min(last, pos | (SUB_BLOCK_BITS - 1));
+      best = scan_bytes(pos, head_last, excess);
+      pos = head_last + 1;
+    }
+    // Rightmost sub-block containing the minimum, if it has not been
+    // scanned yet.
+    bool min_in_sub_block = false;
+    size_t min_sub_block = 0;
+    int64_t min_sub_block_excess = 0;
+    for (; pos + SUB_BLOCK_BITS <= last + 1; pos += SUB_BLOCK_BITS) {
+      size_t const sub_block = pos / SUB_BLOCK_BITS;
+      int64_t const min =
+          excess + minima_[pos / BLOCK_BITS]
+                       .sub_blocks[sub_block % (BLOCK_BITS / SUB_BLOCK_BITS)];
+      bool const is_min = (min <= best.first);
+      best.first = is_min ? min : best.first;
+      min_in_sub_block |= is_min;
+      min_sub_block = is_min ? sub_block : min_sub_block;
+      min_sub_block_excess = is_min ? excess : min_sub_block_excess;
+      int64_t const ones = std::popcount(data[pos / 64]) +
+                           std::popcount(data[(pos / 64) + 1]);
+      excess += (2 * ones) - static_cast<int64_t>(SUB_BLOCK_BITS);
+    }
+    if (pos <= last) {
+      auto const tail = scan_bytes(pos, last, excess);
+      if (tail.first <= best.first) {
+        return tail;
+      }
+    }
+    if (min_in_sub_block) {
+      size_t const begin = min_sub_block * SUB_BLOCK_BITS;
+      best = scan_bytes(begin,
+                        begin + SUB_BLOCK_BITS - 1,
+                        min_sub_block_excess);
+    }
+    return best;
+  }
+
+  /*!
+   * \brief Computes the rightmost minimum excess in a range of the
+   * parentheses by scanning it byte-wise.
+   * \param pos First position of the range.
+   * \param last Last position of the range (inclusive).
+   * \param excess Excess before \c pos, which is updated to the excess
+   * after \c last.
+   * \return Minimum excess and its rightmost position.
+   */
+  std::pair<int64_t, size_t>
+  scan_bytes(size_t pos, size_t const last, int64_t& excess) const {
+    uint64_t const* const data = bp_.data().data();
+    int64_t min = std::numeric_limits<int64_t>::max();
+    size_t min_pos = pos;
+    // The minimum is updated without branches, as whether a byte contains
+    // a new minimum is hard to predict.
+    auto const scan_prefix = [&](size_t const length) {
+      ByteExcess const byte =
+          BYTE_EXCESS[length][(data[pos / 64] >> (pos % 64)) & 0xFF];
+      int64_t const byte_min = excess + byte.min;
+      bool const is_min = (byte_min <= min);
+      min = is_min ? byte_min : min;
+      min_pos = is_min ? pos + byte.min_pos : min_pos;
+      excess += byte.excess;
+      pos += length;
+    };
+    if (pos % 8 != 0) {
+      scan_prefix(std::min(8 - (pos % 8), last + 1 - pos));
+    }
+    while (pos + 8 <= last + 1) {
+      scan_prefix(8);
+    }
+    if (pos <= last) {
+      scan_prefix(last + 1 - pos);
+    }
+    return {min, min_pos};
+  }
+
+  /*!
+   * \brief Computes the rightmost minimum excess of a range of blocks.
+   * \param first First block of the range.
+   * \param last Last block of the range (inclusive).
+   * \return Minimum excess and the rightmost block containing it.
+   */
+  std::pair<int64_t, size_t> min_blocks(size_t const first,
+                                        size_t const last) const {
+    auto const [min, level, pos] = min_entries(0, first, last);
+    return {min, descend(level, pos, min)};
+  }
+
+  /*!
+   * \brief Computes the rightmost minimum of a range of entries of a level
+   * of the tree (level 0 are the blocks).
+   *
+   * Entries at the borders of the range are scanned and all entries
+   * completely covered by entries of the next level are handled there.
+   * \param level The level.
+   * \param first First entry of the range.
+   * \param last Last entry of the range (inclusive).
+   * \return The minimum and the level and position of its rightmost entry.
+   */
+  std::tuple<int64_t, size_t, size_t>
+  min_entries(size_t const level, size_t const first, size_t const last) const {
+    std::tuple<int64_t, size_t, size_t> best = {
+        std::numeric_limits<int64_t>::max(),
+        level,
+        first};
+    auto const scan_entries = [&](size_t const from, size_t const to) {
+      for (size_t e = from; e < to; ++e) {
+        if (int64_t const value = entry(level, e); value <= std::get<0>(best)) {
+          best = {value, level, e};
+        }
+      }
+    };
+    size_t const first_full = (first + FAN_OUT - 1) / FAN_OUT;
+    size_t const end_full = (last + 1) / FAN_OUT;
+    if (level == levels_.size() || first_full >= end_full) {
+      scan_entries(first, last + 1);
+      return best;
+    }
+    scan_entries(first, first_full * FAN_OUT);
+    auto const middle = min_entries(level + 1, first_full, end_full - 1);
+    if (std::get<0>(middle) <= std::get<0>(best)) {
+      best = middle;
+    }
+    scan_entries(end_full * FAN_OUT, last + 1);
+    return best;
+  }
+
+  /*!
+   * \brief Finds the rightmost block below an entry of the tree that
+   * contains the minimum of the entry.
+   * \param level Level of the entry.
+   * \param pos Position of the entry.
+   * \param min Minimum of the entry.
+   * \return The rightmost block containing the minimum.
+   */
+  size_t descend(size_t level, size_t pos, int64_t const min) const {
+    while (level > 0) {
+      --level;
+      size_t const level_size =
+          (level == 0) ? minima_.size() : levels_[level - 1].size();
+      size_t child = std::min((pos + 1) * FAN_OUT, level_size);
+      while (entry(level, --child) != min) {
+      }
+      pos = child;
+    }
+    return pos;
+  }
+
+  /*!
+   * \brief Get an entry of the tree over the block minima.
+   * \param level The level (0 are the blocks).
+   * \param pos Position of the entry.
+   * \return The minimum (absolute) excess of the entry.
+   */
+  int64_t entry(size_t const level, size_t const pos) const {
+    if (level == 0) {
+      return excess_before(pos * BLOCK_BITS) + minima_[pos].block;
+    }
+    return levels_[level - 1][pos];
+  }
+
+  /*!
+   * \brief Computes the excess before a position.
+   * \param pos The position.
+   * \return Number of opening minus number of closing parentheses before
+   * \c pos.
+   */
+  int64_t excess_before(size_t const pos) const {
+    return (2 * static_cast<int64_t>(rank_select_.rank1(pos))) -
+           static_cast<int64_t>(pos);
+  }
+
+  //! Computes the balanced parentheses of the Cartesian tree in parallel.
+  template <typename T>
+  void build_parentheses(std::span<T const> const values) {
+    if (size_ == 0) {
+      return;
+    }
+#if defined(_OPENMP)
+    size_t const num_chunks = std::max<size_t>(
+        1,
+        std::min<size_t>(static_cast<size_t>(omp_get_max_threads()),
+                         size_ / 4096));
+#else
+    size_t const num_chunks = 1;
+#endif
+    auto const chunk_begin = [&](size_t const chunk) {
+      return (size_ * chunk) / num_chunks;
+    };
+
+    // Stack (of values) after the left-to-right scan of each chunk.
+    std::vector<std::vector<T>> stacks(num_chunks);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      auto& stack = stacks[chunk];
+      for (size_t k = chunk_begin(chunk); k < chunk_begin(chunk + 1); ++k) {
+        while (!stack.empty() && stack.back() > values[k]) {
+          stack.pop_back();
+        }
+        stack.push_back(values[k]);
+      }
+    }
+
+    // Stack before each chunk as list of (chunk, length) of prefixes of the
+    // stacks of previous chunks. The bottom of each stack is the minimum of
+    // its chunk, which removes all larger elements from the stack.
+    std::vector<std::vector<std::pair<size_t, size_t>>> prefixes(num_chunks);
+    for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+      auto& prefix = prefixes[chunk];
+      prefix = prefixes[chunk - 1];
+      T const chunk_min = stacks[chunk - 1].front();
+      while (!prefix.empty()) {
+        auto& [prev, length] = prefix.back();
+        auto const prev_begin = stacks[prev].begin();
+        length = std::upper_bound(prev_begin, prev_begin + length, chunk_min) -
+                 prev_begin;
+        if (length > 0) {
+          break;
+        }
+        prefix.pop_back();
+      }
+      prefix.emplace_back(chunk - 1, stacks[chunk - 1].size());
+    }
+
+    uint64_t* const data = bp_.data().data();
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static, 1)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      auto const& prefix = prefixes[chunk];
+      // Number of elements of the stack before the chunk not larger than
+      // a value.
+      auto const count_not_larger = [&](T const& value) {
+        size_t result = 0;
+        for (auto const& [prev, length] : prefix) {
+          auto const prev_begin = stacks[prev].begin();
+          if (prev_begin[length - 1] > value) {
+            return result + (std::upper_bound(prev_begin,
+                                              prev_begin + length,
+                                              value) -
+                             prev_begin);
+          }
+          result += length;
+        }
+        return result;
+      };
+
+      std::vector<T> stack;
+      size_t below = 0;
+      size_t word_pos = 0;
+      uint64_t word = 0;
+      auto const flush = [&]() {
+        // The first and last word of a chunk may be shared with other chunks.
+#if defined(_OPENMP)
+#  pragma omp atomic
+#endif
+        data[word_pos] |= word;
+      };
+      for (size_t k = chunk_begin(chunk); k < chunk_begin(chunk + 1); ++k) {
+        while (!stack.empty() && stack.back() > values[k]) {
+          stack.pop_back();
+        }
+        if (stack.empty()) {
+          below = count_not_larger(values[k]);
+        }
+        stack.push_back(values[k]);
+        size_t const pos = (2 * k) + 1 - (below + stack.size());
+        if (pos / 64 != word_pos) {
+          flush();
+          word_pos = pos / 64;
+          word = 0;
+        }
+        word |= 1ULL << (pos % 64);
+      }
+      flush();
+    }
+  }
+
+  //! Computes the block minima and the tree over them in parallel.
+  void build_block_minima() {
+    size_t const num_bits = 2 * size_;
+    size_t const num_blocks = (num_bits + BLOCK_BITS - 1) / BLOCK_BITS;
+    minima_.resize(num_blocks);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static)
+#endif
+    for (size_t block = 0; block < num_blocks; ++block) {
+      size_t const begin = block * BLOCK_BITS;
+      size_t const last = std::min(begin + BLOCK_BITS, num_bits) - 1;
+      auto& minima = minima_[block];
+      minima.sub_blocks.fill(0);
+      for (size_t sub_block = 0; begin + (sub_block * SUB_BLOCK_BITS) <= last;
+           ++sub_block) {
+        size_t const sub_begin = begin + (sub_block * SUB_BLOCK_BITS);
+        int64_t excess = 0;
+        minima.sub_blocks[sub_block] = static_cast<int8_t>(
+            scan_bytes(sub_begin,
+                       std::min(sub_begin + SUB_BLOCK_BITS - 1, last),
+                       excess)
+                .first);
+      }
+      minima.block = static_cast<int16_t>(scan(begin, last, 0).first);
+    }
+
+    levels_.clear();
+    size_t level_size = num_blocks;
+    while (level_size > FAN_OUT) {
+      size_t const level = levels_.size();
+      level_size = (level_size + FAN_OUT - 1) / FAN_OUT;
+      auto& entries = levels_.emplace_back(level_size);
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(static)
+#endif
+      for (size_t pos = 0; pos < level_size; ++pos) {
+        size_t const below_size =
+            (level == 0) ? num_blocks : levels_[level - 1].size();
+        int64_t min = std::numeric_limits<int64_t>::max();
+        for (size_t child = pos * FAN_OUT;
+             child < std::min((pos + 1) * FAN_OUT, below_size);
+             ++child) {
+          min = std::min(min, entry(level, child));
+        }
+        entries[pos] = min;
+      }
+    }
+  }
+}; // class SuccinctRmq
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
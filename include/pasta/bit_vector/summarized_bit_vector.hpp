@@ -0,0 +1,355 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <tlx/container/simple_vector.hpp>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector
+//! \{
+
+/*!
+ * \brief \ref BitVector with a hierarchical summary for fast
+ * \c find_next_one() and \c find_next_zero() queries on mutable bit vectors.
+ *
+ * The summary consists of two 64-ary trees of bit arrays. In the first tree,
+ * the lowest level contains one bit per 64-bit word of the bit vector that
+ * is set if the word is not empty (contains a one). In the second tree, the
+ * lowest level contains one bit per 64-bit word that is set if the word is
+ * not full (contains a zero). Each higher level contains one bit per 64-bit
+ * word of the level below that is set if the word is not zero. The summary
+ * is updated on every write, which requires one additional access per level
+ * only if the state (empty/full) of a word changes.
+ *
+ * A find query requires \f$O(\log_{64} n)\f$ time and touches at most two
+ * words per level.
+ */
+class SummarizedBitVector {
+  template <typename T>
+  using Array = tlx::SimpleVector<T, tlx::SimpleVectorMode::NoInitNoDestroy>;
+
+  //! The bit vector.
+  BitVector bv_;
+  //! Summary levels marking words containing a one.
+  std::vector<Array<uint64_t>> non_empty_;
+  //! Summary levels marking words containing a zero.
+  std::vector<Array<uint64_t>> non_full_;
+
+public:
+  /*!
+   * \brief Utility class used for the access operator of the
+   * \c SummarizedBitVector.
+   *
+   * Like \ref BitAccess, but writes also update the summary.
+   */
+  class SummarizedBitAccess {
+    //! Forward declaration.
+    friend class SummarizedBitVector;
+
+    //! Bit vector the bit is contained in.
+    SummarizedBitVector* const bv_;
+    //! Position of the bit.
+    size_t const position_;
+
+    /*!
+     * \brief Constructor setting bit vector and position of the bit.
+     * \param bv Bit vector the bit is contained in.
+     * \param position Position of the bit.
+     */
+    SummarizedBitAccess(SummarizedBitVector* const bv,
+                        size_t const position) noexcept
+        : bv_(bv),
+          position_(position) {}
+
+  public:
+    //! Deleted constructor.
+    SummarizedBitAccess() = delete;
+    //! Avoiding implicit copy assignment.
+    SummarizedBitAccess& operator=(SummarizedBitAccess const&) = delete;
+
+    /*!
+     * \brief User-defined conversion function to bool.
+     *
+     * Used for read access to a single bit.
+     */
+    operator bool() const noexcept {
+      return bv_->bv_[position_];
+    }
+
+    /*!
+     * \brief Assignment operator to set a bit and update the summary.
+     * \param value Value the bit should be written to.
+     * \return This after the bit has been written.
+     */
+    SummarizedBitAccess& operator=(bool const value) noexcept {
+      bv_->set(position_, value);
+      return *this;
+    }
+  }; // class SummarizedBitAccess
+
+  //! Default empty constructor.
+  SummarizedBitVector() = default;
+
+  /*!
+   * \brief Constructor. Creates a bit vector that holds a specific, fixed
+   * number of bits set to a default value.
+   * \param size Number of bits the bit vector contains.
+   * \param init_value Value all bits initially are set to.
+   */
+  SummarizedBitVector(size_t const size, bool const init_value = false)
+      : bv_(size, init_value) {
+    // Bits after the end of the bit vector are always zero.
+    auto data = bv_.data();
+    if (size % 64 != 0) {
+      data[size / 64] &= (1ULL << (size % 64)) - 1;
+    } else {
+      data[size / 64] = 0ULL;
+    }
+    build_summary();
+  }
+
+  /*!
+   * \brief Constructor. Creates the summary for an existing bit vector.
+   * \param bv Bit vector that is moved into this data structure.
+   */
+  SummarizedBitVector(BitVector&& bv) : bv_(std::move(bv)) {
+    auto data = bv_.data();
+    size_t const size = bv_.size();
+    if (size % 64 != 0) {
+      data[size / 64] &= (1ULL << (size % 64)) - 1;
+    } else {
+      data[size / 64] = 0ULL;
+    }
+    build_summary();
+  }
+
+  //! Default move constructor.
+  SummarizedBitVector(SummarizedBitVector&&) = default;
+
+  //! Default move assignment.
+  SummarizedBitVector& operator=(SummarizedBitVector&&) = default;
+
+  /*!
+   * \brief Access operator to read/write to a bit of the bit vector.
+   * \param index Index of the bit to be read/write to in the bit vector.
+   * \return \c SummarizedBitAccess that allows to access to a single bit.
+   */
+  SummarizedBitAccess operator[](size_t const index) noexcept {
+    return SummarizedBitAccess(this, index);
+  }
+
+  /*!
+   * \brief Access operator to read a bit of the bit vector.
+   * \param index Index of the bit to be read.
+   * \return Value of the bit at position \c index.
+   */
+  bool operator[](size_t const index) const noexcept {
+    return bv_[index];
+  }
+
+  /*!
+   * \brief Set a bit and update the summary.
+   * \param index Position of the bit.
+   * \param value Value the bit is set to.
+   */
+  void set(size_t const index, bool const value) noexcept {
+    size_t const word_pos = index / 64;
+    uint64_t const mask = 1ULL << (index % 64);
+    uint64_t const old_word = bv_.data(word_pos);
+    write_word(word_pos, value ? (old_word | mask) : (old_word & ~mask));
+  }
+
+  /*!
+   * \brief Overwrite a complete 64-bit word and update the summary.
+   *
+   * Bits after the end of the bit vector must be zero.
+   * \param word_pos Index of the 64-bit word.
+   * \param word New value of the 64-bit word.
+   */
+  void write_word(size_t const word_pos, uint64_t const word) noexcept {
+    uint64_t& data = bv_.data()[word_pos];
+    uint64_t const old_word = data;
+    data = word;
+    if ((old_word == 0ULL) != (word == 0ULL)) {
+      propagate(non_empty_, word_pos, word != 0ULL);
+    }
+    if ((old_word == ~0ULL) != (word == ~0ULL)) {
+      propagate(non_full_, word_pos, word != ~0ULL);
+    }
+  }
+
+  /*!
+   * \brief Find the first set bit at or after a position.
+   * \param index Position the search starts at (inclusive).
+   * \return Position of the first set bit at or after \c index or \c size()
+   * if there is none.
+   */
+  [[nodiscard("find_next_one computed but not used")]] size_t
+  find_next_one(size_t const index) const noexcept {
+    return find_next<true>(index);
+  }
+
+  /*!
+   * \brief Find the first unset bit at or after a position.
+   * \param index Position the search starts at (inclusive).
+   * \return Position of the first unset bit at or after \c index or
+   * \c size() if there is none.
+   */
+  [[nodiscard("find_next_zero computed but not used")]] size_t
+  find_next_zero(size_t const index) const noexcept {
+    return find_next<false>(index);
+  }
+
+  /*!
+   * \brief Read-only access to the underlying \ref BitVector, e.g., to build
+   * rank and select support.
+   * \return The underlying \ref BitVector.
+   */
+  BitVector const& bit_vector() const noexcept {
+    return bv_;
+  }
+
+  /*!
+   * \brief Get the size of the bit vector in bits.
+   * \return Size of the bit vector in bits.
+   */
+  size_t size() const noexcept {
+    return bv_.size();
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t result = bv_.space_usage() - sizeof(bv_) + sizeof(*this);
+    for (size_t l = 0; l < non_empty_.size(); ++l) {
+      result += (non_empty_[l].size() + non_full_[l].size()) *
+                sizeof(uint64_t);
+    }
+    return result;
+  }
+
+private:
+  //! Builds all summary levels from scratch.
+  void build_summary() {
+    non_empty_.clear();
+    non_full_.clear();
+    auto const data = bv_.data();
+    size_t bits = data.size();
+    do {
+      size_t const words = (bits + 63) / 64;
+      Array<uint64_t>& empty_level = non_empty_.emplace_back(words);
+      Array<uint64_t>& full_level = non_full_.emplace_back(words);
+      std::fill_n(empty_level.data(), words, 0ULL);
+      std::fill_n(full_level.data(), words, 0ULL);
+      bool const lowest = (non_empty_.size() == 1);
+      for (size_t i = 0; i < bits; ++i) {
+        uint64_t const below_empty =
+            lowest ? data[i] : non_empty_[non_empty_.size() - 2][i];
+        uint64_t const below_full =
+            lowest ? ~data[i] : non_full_[non_full_.size() - 2][i];
+        empty_level[i / 64] |= uint64_t{below_empty != 0ULL} << (i % 64);
+        full_level[i / 64] |= uint64_t{below_full != 0ULL} << (i % 64);
+      }
+      bits = words;
+    } while (bits > 1);
+  }
+
+  /*!
+   * \brief Update the summary after the state of a word changed.
+   * \param levels The summary that is updated.
+   * \param pos Position of the bit in the lowest summary level.
+   * \param bit New value of the bit.
+   */
+  static void propagate(std::vector<Array<uint64_t>>& levels,
+                        size_t pos,
+                        bool bit) noexcept {
+    for (auto& level : levels) {
+      uint64_t const mask = 1ULL << (pos % 64);
+      pos /= 64;
+      uint64_t const old_word = level[pos];
+      uint64_t const new_word = bit ? (old_word | mask) : (old_word & ~mask);
+      level[pos] = new_word;
+      if ((old_word == 0ULL) == (new_word == 0ULL)) {
+        return;
+      }
+      bit = (new_word != 0ULL);
+    }
+  }
+
+  /*!
+   * \brief Find the first bit with a specific value at or after a position.
+   *
+   * First, we go up in the summary until a word containing a set bit after
+   * the current position is found. Then, we go down again following the
+   * first set bit.
+   * \tparam value Value of the bit that is searched.
+   * \param index Position the search starts at (inclusive).
+   * \return Position of the first bit equal to \c value at or after
+   * \c index or \c size() if there is none.
+   */
+  template <bool value>
+  size_t find_next(size_t const index) const noexcept {
+    size_t const size = bv_.size();
+    if (index >= size) {
+      return size;
+    }
+    auto const& levels = value ? non_empty_ : non_full_;
+    auto const word_at = [&](size_t const level, size_t const pos) {
+      if (level == 0) {
+        return value ? bv_.data(pos) : ~bv_.data(pos);
+      }
+      return levels[level - 1][pos];
+    };
+
+    size_t level = 0;
+    size_t pos = index;
+    uint64_t word = word_at(0, pos / 64) & (~0ULL << (pos % 64));
+    while (word == 0ULL) {
+      pos = (pos / 64) + 1;
+      if (++level > levels.size() || pos / 64 >= levels[level - 1].size()) {
+        return size;
+      }
+      word = word_at(level, pos / 64) & (~0ULL << (pos % 64));
+    }
+    pos = ((pos / 64) * 64) + std::countr_zero(word);
+    while (level > 0) {
+      pos = (pos * 64) + std::countr_zero(word_at(--level, pos));
+    }
+    return std::min(pos, size);
+  }
+}; // class SummarizedBitVector
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
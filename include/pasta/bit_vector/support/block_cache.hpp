@@ -0,0 +1,535 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#  include <linux/aio_abi.h>
+#  include <sys/syscall.h>
+#endif
+
+namespace pasta {
+
+/*! \file */
+
+/*!
+ * \brief Fixed-size user-space cache of the blocks of a (read-only) file.
+ *
+ * The file is split into blocks of \c BLOCK_BYTES bytes. The cache holds a
+ * fixed number of blocks (frames), i.e., its memory usage is bounded, and
+ * evicts blocks using the CLOCK strategy (an approximation of LRU). Blocks
+ * are read with \c O_DIRECT (if supported by the file system), such that the
+ * page cache is bypassed: There is no read-ahead and no memory is used
+ * twice.
+ *
+ * Multiple blocks can be fetched at once using \c fetch(). On Linux, all
+ * missing blocks are then read asynchronously using the kernel's native AIO
+ * interface, i.e., the reads overlap. All blocks of a batch are pinned until
+ * the next batch (or single block access), i.e., they are not evicted while
+ * the batch is processed. Therefore, a batch must not contain more distinct
+ * blocks than the cache has frames.
+ *
+ * Read errors are reported using \c std::system_error. Batches containing
+ * more distinct blocks than frames are reported using \c std::length_error.
+ */
+class BlockCache {
+public:
+  //! Size of a block in bytes (a multiple of the logical block size of
+  //! common devices, as required by \c O_DIRECT).
+  static constexpr size_t BLOCK_BYTES = 4096;
+
+private:
+  //! Marker for frames that do not contain a block.
+  static constexpr size_t EMPTY = ~size_t{0};
+
+  //! Deleter for the (aligned) memory of the frames.
+  struct FreeDeleter {
+    //! Frees the memory.
+    void operator()(uint8_t* const ptr) const noexcept {
+      std::free(ptr);
+    }
+  }; // struct FreeDeleter
+
+  //! File descriptor of the cached file.
+  int fd_ = -1;
+  //! Whether the file is read with \c O_DIRECT.
+  bool direct_ = false;
+  //! Number of frames.
+  size_t num_frames_ = 0;
+  //! Memory of all frames (aligned to \c BLOCK_BYTES).
+  std::unique_ptr<uint8_t, FreeDeleter> frames_;
+  //! Block contained in each frame (or \c EMPTY).
+  std::vector<size_t> frame_block_;
+  //! CLOCK reference bit of each frame.
+  std::vector<uint8_t> referenced_;
+  //! Batch in which each frame has been accessed last (pinned if equal to
+  //! the current batch).
+  std::vector<uint64_t> frame_batch_;
+  //! Maps blocks to the frames containing them.
+  std::unordered_map<size_t, size_t> block_frame_;
+  //! Position of the CLOCK hand.
+  size_t hand_ = 0;
+  //! Number of the current batch.
+  uint64_t batch_ = 0;
+  //! Number of block accesses that have been answered from the cache.
+  size_t hits_ = 0;
+  //! Number of blocks that have been read from the file.
+  size_t misses_ = 0;
+#if defined(__linux__)
+  //! Context of the kernel's native AIO interface (0 if not available).
+  aio_context_t aio_context_ = 0;
+#endif
+
+public:
+  //! Default constructor. No file is cached.
+  BlockCache() = default;
+
+  //! Move constructor. \c other does not cache a file afterwards.
+  BlockCache(BlockCache&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  //! Move assignment. \c other does not cache a file afterwards.
+  BlockCache& operator=(BlockCache&& other) noexcept {
+    if (this != &other) {
+      release();
+      fd_ = std::exchange(other.fd_, -1);
+      direct_ = other.direct_;
+      num_frames_ = std::exchange(other.num_frames_, 0);
+      frames_ = std::move(other.frames_);
+      frame_block_ = std::move(other.frame_block_);
+      referenced_ = std::move(other.referenced_);
+      frame_batch_ = std::move(other.frame_batch_);
+      block_frame_ = std::move(other.block_frame_);
+      hand_ = other.hand_;
+      batch_ = other.batch_;
+      hits_ = other.hits_;
+      misses_ = other.misses_;
+#if defined(__linux__)
+      aio_context_ = std::exchange(other.aio_context_, 0);
+#endif
+    }
+    return *this;
+  }
+
+  //! Deleted copy constructor, the file descriptor is owned exclusively.
+  BlockCache(BlockCache const&) = delete;
+  //! Deleted copy assignment, the file descriptor is owned exclusively.
+  BlockCache& operator=(BlockCache const&) = delete;
+
+  //! Destructor. Closes the file.
+  ~BlockCache() {
+    release();
+  }
+
+  /*!
+   * \brief Opens a file for cached reading.
+   * \param path Path of the file.
+   * \param capacity Maximum number of bytes used for cached blocks (at least
+   * one block is cached).
+   * \return The cache or \c std::nullopt if the file cannot be opened.
+   */
+  [[nodiscard("opened cache not used")]] static std::optional<BlockCache>
+  open_file(std::string const& path, size_t const capacity) {
+    BlockCache result;
+#if defined(O_DIRECT)
+    result.fd_ = open(path.c_str(), O_RDONLY | O_DIRECT);
+    result.direct_ = (result.fd_ >= 0);
+#endif
+    if (result.fd_ < 0) {
+      result.fd_ = open(path.c_str(), O_RDONLY);
+    }
+    if (result.fd_ < 0) {
+      return std::nullopt;
+    }
+    result.num_frames_ = std::max<size_t>(1, capacity / BLOCK_BYTES);
+    result.frames_.reset(static_cast<uint8_t*>(
+        std::aligned_alloc(BLOCK_BYTES, result.num_frames_ * BLOCK_BYTES)));
+    if (!result.frames_) {
+      return std::nullopt;
+    }
+    result.frame_block_.assign(result.num_frames_, EMPTY);
+    result.referenced_.assign(result.num_frames_, 0);
+    result.frame_batch_.assign(result.num_frames_, 0);
+    result.block_frame_.reserve(result.num_frames_);
+#if defined(__linux__)
+    if (syscall(SYS_io_setup, result.num_frames_, &result.aio_context_) !=
+        0) {
+      result.aio_context_ = 0;
+    }
+#endif
+    return result;
+  }
+
+  /*!
+   * \brief Access a single block. The block is read from the file if it is
+   * not cached. The previous batch is not pinned anymore.
+   * \param block Index of the block.
+   * \return Pointer to the \c BLOCK_BYTES bytes of the block (bytes after the
+   * end of the file are zero). Valid until the next access.
+   */
+  [[nodiscard("block not used")]] uint8_t const* block(size_t const block) {
+    ++batch_;
+    return frame_data(lookup(block));
+  }
+
+  /*!
+   * \brief Fetch multiple blocks as one batch. All missing blocks are read
+   * at once (asynchronously, if possible). Afterwards, all blocks of the
+   * batch are pinned and can be accessed using \c cached_block().
+   * \param blocks Indices of the blocks (duplicates are allowed). There must
+   * not be more distinct blocks than frames (see \c num_frames()), otherwise
+   * \c std::length_error is thrown.
+   */
+  void fetch(std::span<size_t const> const blocks) {
+    ++batch_;
+    std::vector<std::pair<size_t, size_t>> missing;
+    try {
+      for (size_t const block : blocks) {
+        if (auto it = block_frame_.find(block); it != block_frame_.end()) {
+          if (frame_batch_[it->second] != batch_) {
+            ++hits_;
+          }
+          pin(it->second);
+          continue;
+        }
+        size_t const frame = evict();
+        frame_block_[frame] = block;
+        block_frame_[block] = frame;
+        pin(frame);
+        missing.emplace_back(block, frame);
+      }
+    } catch (...) {
+      // The frames assigned so far have not been read.
+      for (auto const& [block, frame] : missing) {
+        block_frame_.erase(block);
+        frame_block_[frame] = EMPTY;
+      }
+      throw;
+    }
+    read_blocks(missing);
+  }
+
+  /*!
+   * \brief Access a block of the current batch (see \c fetch()).
+   * \param block Index of the block, which must be part of the current
+   * batch.
+   * \return Pointer to the \c BLOCK_BYTES bytes of the block.
+   */
+  [[nodiscard("block not used")]] uint8_t const*
+  cached_block(size_t const block) const {
+    return frame_data(block_frame_.find(block)->second);
+  }
+
+  /*!
+   * \brief Get the number of frames, i.e., the maximum number of cached
+   * blocks.
+   * \return Number of frames.
+   */
+  [[nodiscard("num_frames computed but not used")]] size_t
+  num_frames() const noexcept {
+    return num_frames_;
+  }
+
+  /*!
+   * \brief Check whether blocks are read with \c O_DIRECT.
+   * \return \c true if the page cache is bypassed.
+   */
+  [[nodiscard("direct_io computed but not used")]] bool
+  direct_io() const noexcept {
+    return direct_;
+  }
+
+  /*!
+   * \brief Get the number of block accesses answered from the cache.
+   * \return Number of cache hits.
+   */
+  [[nodiscard("hits computed but not used")]] size_t hits() const noexcept {
+    return hits_;
+  }
+
+  /*!
+   * \brief Get the number of blocks read from the file.
+   * \return Number of cache misses.
+   */
+  [[nodiscard("misses computed but not used")]] size_t
+  misses() const noexcept {
+    return misses_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    return sizeof(*this) +
+           (num_frames_ * (BLOCK_BYTES + sizeof(size_t) + sizeof(uint8_t) +
+                           sizeof(uint64_t))) +
+           (block_frame_.bucket_count() * sizeof(void*)) +
+           (block_frame_.size() * 2 * sizeof(size_t));
+  }
+
+private:
+  /*!
+   * \brief Get the memory of a frame.
+   * \param frame Index of the frame.
+   * \return Pointer to the first byte of the frame.
+   */
+  uint8_t* frame_data(size_t const frame) const {
+    return frames_.get() + (frame * BLOCK_BYTES);
+  }
+
+  /*!
+   * \brief Mark a frame as accessed in the current batch.
+   * \param frame Index of the frame.
+   */
+  void pin(size_t const frame) {
+    referenced_[frame] = 1;
+    frame_batch_[frame] = batch_;
+  }
+
+  /*!
+   * \brief Find the frame containing a block and read the block if it is
+   * not cached.
+   * \param block Index of the block.
+   * \return Index of the frame containing the block.
+   */
+  size_t lookup(size_t const block) {
+    if (auto it = block_frame_.find(block); it != block_frame_.end()) {
+      ++hits_;
+      pin(it->second);
+      return it->second;
+    }
+    size_t const frame = evict();
+    frame_block_[frame] = block;
+    block_frame_[block] = frame;
+    pin(frame);
+    std::pair<size_t, size_t> const missing = {block, frame};
+    read_blocks(std::span{&missing, 1});
+    return frame;
+  }
+
+  /*!
+   * \brief Select a frame using the CLOCK strategy and evict its block.
+   * Frames without a block are used first. Pinned frames are skipped.
+   * \return Index of the (now empty) frame.
+   */
+  size_t evict() {
+    // Number of pinned frames the hand has passed since the last frame that
+    // is not pinned. If all frames are pinned, no frame can be evicted.
+    size_t pinned = 0;
+    while (true) {
+      size_t const frame = hand_;
+      hand_ = (hand_ + 1 == num_frames_) ? 0 : hand_ + 1;
+      if (frame_block_[frame] == EMPTY) {
+        return frame;
+      }
+      if (frame_batch_[frame] == batch_) {
+        if (++pinned == num_frames_) {
+          throw std::length_error(
+              "Batch contains more distinct blocks than the cache has frames");
+        }
+        continue;
+      }
+      pinned = 0;
+      if (referenced_[frame] != 0) {
+        referenced_[frame] = 0;
+        continue;
+      }
+      block_frame_.erase(frame_block_[frame]);
+      frame_block_[frame] = EMPTY;
+      return frame;
+    }
+  }
+
+  /*!
+   * \brief Read blocks into their frames. Bytes after the end of the file
+   * are set to zero. If a read fails, all frames are emptied.
+   * \param missing Pairs of block and frame index.
+   */
+  void read_blocks(std::span<std::pair<size_t, size_t> const> const missing) {
+    misses_ += missing.size();
+    try {
+#if defined(__linux__)
+      if (aio_context_ != 0 && missing.size() > 1) {
+        read_blocks_async(missing);
+        return;
+      }
+#endif
+      for (auto const& [block, frame] : missing) {
+        ssize_t const result = pread(fd_,
+                                     frame_data(frame),
+                                     BLOCK_BYTES,
+                                     static_cast<off_t>(block * BLOCK_BYTES));
+        finish_read(frame, result);
+      }
+    } catch (...) {
+      // The frames do not contain valid blocks.
+      for (auto const& [block, frame] : missing) {
+        block_frame_.erase(block);
+        frame_block_[frame] = EMPTY;
+      }
+      throw;
+    }
+  }
+
+#if defined(__linux__)
+  /*!
+   * \brief Read blocks into their frames using the kernel's native AIO
+   * interface. All reads are submitted at once.
+   *
+   * If an error occurs, the function waits for all submitted reads before
+   * rethrowing the first error. Thus, no read is in flight when the frames
+   * are reused, and no stale completion is consumed by a later batch.
+   * \param missing Pairs of block and frame index.
+   */
+  void read_blocks_async(
+      std::span<std::pair<size_t, size_t> const> const missing) {
+    std::vector<iocb> requests(missing.size());
+    std::vector<iocb*> request_ptrs(missing.size());
+    for (size_t i = 0; i < missing.size(); ++i) {
+      auto const [block, frame] = missing[i];
+      std::memset(&requests[i], 0, sizeof(iocb));
+      requests[i].aio_data = frame;
+      requests[i].aio_fildes = static_cast<uint32_t>(fd_);
+      requests[i].aio_lio_opcode = IOCB_CMD_PREAD;
+      requests[i].aio_buf = reinterpret_cast<uint64_t>(frame_data(frame));
+      requests[i].aio_nbytes = BLOCK_BYTES;
+      requests[i].aio_offset = static_cast<int64_t>(block * BLOCK_BYTES);
+      request_ptrs[i] = &requests[i];
+    }
+    std::exception_ptr error;
+    size_t submitted = 0;
+    while (submitted < missing.size()) {
+      long const result = syscall(SYS_io_submit,
+                                  aio_context_,
+                                  missing.size() - submitted,
+                                  request_ptrs.data() + submitted);
+      if (result <= 0) {
+        error = std::make_exception_ptr(
+            std::system_error(errno,
+                              std::generic_category(),
+                              "Submitting block reads failed"));
+        break;
+      }
+      submitted += static_cast<size_t>(result);
+    }
+    std::vector<io_event> events(submitted);
+    size_t completed = 0;
+    while (completed < submitted) {
+      long const result = syscall(SYS_io_getevents,
+                                  aio_context_,
+                                  1,
+                                  submitted - completed,
+                                  events.data(),
+                                  nullptr);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (!error) {
+          error = std::make_exception_ptr(
+              std::system_error(errno,
+                                std::generic_category(),
+                                "Waiting for block reads failed"));
+        }
+        // The remaining reads cannot be waited for. Destroying the context
+        // cancels them or blocks until they are completed. Afterwards,
+        // blocks are read synchronously.
+        syscall(SYS_io_destroy, aio_context_);
+        aio_context_ = 0;
+        break;
+      }
+      for (long e = 0; e < result; ++e) {
+        try {
+          finish_read(static_cast<size_t>(events[e].data),
+                      static_cast<ssize_t>(events[e].res),
+                      static_cast<int>(-events[e].res));
+        } catch (...) {
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+      completed += static_cast<size_t>(result);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+#endif
+
+  /*!
+   * \brief Check the result of a read and set the bytes after the end of the
+   * file to zero.
+   * \param frame Index of the frame the block has been read into.
+   * \param result Number of bytes read or negative value on error.
+   * \param error Error number used if \c result is negative.
+   */
+  void finish_read(size_t const frame,
+                   ssize_t const result,
+                   int const error = errno) {
+    if (result < 0) {
+      throw std::system_error(error,
+                              std::generic_category(),
+                              "Reading block failed");
+    }
+    std::memset(frame_data(frame) + result,
+                0,
+                BLOCK_BYTES - static_cast<size_t>(result));
+  }
+
+  //! Closes the file and destroys the AIO context.
+  void release() {
+#if defined(__linux__)
+    if (aio_context_ != 0) {
+      syscall(SYS_io_destroy, aio_context_);
+      aio_context_ = 0;
+    }
+#endif
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+}; // class BlockCache
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,384 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+#include "pasta/bit_vector/support/popcount.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <tlx/container/simple_vector.hpp>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace pasta {
+
+/*!
+ * \ingroup pasta_bit_vector_configuration
+ * \brief Static configuration for \c CompactRank and
+ * \c CompactRankSelect
+ */
+struct CompactRankSelectConfig {
+  //! Bits covered by an L2-block.
+  static constexpr size_t L2_BIT_SIZE = 512;
+  //! Bits covered by an L1-block.
+  static constexpr size_t L1_BIT_SIZE = 4 * L2_BIT_SIZE;
+
+  //! Number of 64-bit words covered by an L2-block.
+  static constexpr size_t L2_WORD_SIZE = L2_BIT_SIZE / (sizeof(uint64_t) * 8);
+  //! Number of 64-bit words covered by an L1-block.
+  static constexpr size_t L1_WORD_SIZE = L1_BIT_SIZE / (sizeof(uint64_t) * 8);
+
+  //! Maximum number of bits of a bit vector (exclusive).
+  static constexpr size_t MAX_BIT_SIZE = 1ULL << 32;
+
+  //! Sample rate of positions for faster select queries.
+  static constexpr size_t SELECT_SAMPLE_RATE = 8192;
+}; // struct CompactRankSelectConfig
+
+//! \addtogroup pasta_bit_vector_rank
+//! \{
+
+/*!
+ * \brief %Rank support for \ref BitVector with less than 2^32 bits using
+ * 32-bit counters and 32-bit query interfaces.
+ *
+ * Each L1-block covers 2048 bits and is represented by a single 64-bit word.
+ * The lower 32 bits contain the number of ones before the L1-block. The upper
+ * 32 bits contain the number of ones in the first one (10 bits), two (11
+ * bits), and three (11 bits) L2-blocks of the L1-block. L2-blocks cover 512
+ * bits. Therefore, a rank query requires one access to the L1/L2-information
+ * and popcounts of at most eight 64-bit words, which all are contained in one
+ * cache line. The space overhead is the same as for \ref FlatRank (3.125%),
+ * but the L2-blocks are stored at word granularity and all values fit into
+ * 32 bits, which allows for vectorized batched queries, see
+ * \c rank1_batch().
+ *
+ * \tparam OptimizedFor Compile time option to optimize data structure for
+ * either 0, 1, or no specific type of query.
+ * \tparam VectorType Type of the vector the rank data structure is constructed
+ * for, e.g., plain \c BitVector or a compressed bit vector.
+ */
+template <OptimizedFor optimized_for = OptimizedFor::DONT_CARE,
+          typename VectorType = BitVector>
+class CompactRank {
+protected:
+  //! Size of the bit vector the rank support is constructed for.
+  size_t data_size_ = 0;
+  //! Pointer to the data of the bit vector.
+  VectorType::RawDataConstAccess data_ = nullptr;
+
+  //! Array containing the information about the L1- and L2-blocks.
+  tlx::SimpleVector<uint64_t, tlx::SimpleVectorMode::NoInitNoDestroy> l12_;
+
+  //! Number of bits the L2-entries are shifted in an L1/L2-word.
+  static constexpr std::array<uint64_t, 4> L2_SHIFT = {0, 32, 42, 53};
+  //! Mask for the L2-entries in an L1/L2-word (after shifting).
+  static constexpr std::array<uint64_t, 4> L2_MASK = {0, 0x3FF, 0x7FF, 0x7FF};
+
+public:
+  //! Default constructor w/o parameter.
+  CompactRank() = default;
+
+  /*!
+   * \brief Constructor. Creates the auxiliary information for efficient rank
+   * queries.
+   * \param bv Vector of type \c VectorType the rank structure is created for.
+   * Must contain less than 2^32 bits.
+   */
+  CompactRank(VectorType& bv)
+      : data_size_(bv.data().size()),
+        data_(bv.data().data()),
+        l12_((data_size_ / CompactRankSelectConfig::L1_WORD_SIZE) + 1) {
+    PASTA_ASSERT(bv.size() < CompactRankSelectConfig::MAX_BIT_SIZE,
+                 "CompactRank requires less than 2^32 bits.");
+    init();
+  }
+
+  //! Default move constructor.
+  CompactRank(CompactRank&&) = default;
+
+  //! Default move assignment.
+  CompactRank& operator=(CompactRank&&) = default;
+
+  //! Default virtual destructor.
+  virtual ~CompactRank() = default;
+
+  /*!
+   * \brief Computes rank of zeros.
+   * \param index Index the rank of zeros is computed for.
+   * \return Number of zeros (rank) before position \c index.
+   */
+  [[nodiscard("rank0 computed but not used")]] uint32_t
+  rank0(uint32_t const index) const {
+    if constexpr (optimize_one_or_dont_care(optimized_for)) {
+      return index - stored_rank(index);
+    } else {
+      return stored_rank(index);
+    }
+  }
+
+  /*!
+   * \brief Computes rank of ones.
+   * \param index Index the rank of ones is computed for.
+   * \return Number of ones (rank) before position \c index.
+   */
+  [[nodiscard("rank1 computed but not used")]] uint32_t
+  rank1(uint32_t const index) const {
+    if constexpr (optimize_one_or_dont_care(optimized_for)) {
+      return stored_rank(index);
+    } else {
+      return index - stored_rank(index);
+    }
+  }
+
+  /*!
+   * \brief Computes multiple rank queries of ones at once.
+   *
+   * If AVX-512 (with \c VPOPCNTDQ) is available, eight queries are answered
+   * at once using gathers for the L1/L2-words and the words of the bit
+   * vector. Otherwise, the queries are answered one after another, which
+   * still allows the CPU to overlap their cache misses.
+   *
+   * \param positions Indices the rank of ones is computed for.
+   * \param out Span with at least \c positions.size() elements the results
+   * are written to.
+   */
+  void rank1_batch(std::span<uint32_t const> const positions,
+                   std::span<uint32_t> const out) const {
+    PASTA_ASSERT(out.size() >= positions.size(),
+                 "Output span is smaller than number of queried positions.");
+    size_t q = 0;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+    for (; q + 8 <= positions.size(); q += 8) {
+      __m256i const pos = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const*>(positions.data() + q));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data() + q),
+                          _mm512_maskz_cvtepi64_epi32(0xFF, rank1_x8(pos)));
+    }
+#endif
+    for (; q < positions.size(); ++q) {
+      out[q] = rank1(positions[q]);
+    }
+  }
+
+  /*!
+   * \brief Computes multiple rank queries of zeros at once. See
+   * \c rank1_batch().
+   * \param positions Indices the rank of zeros is computed for.
+   * \param out Span with at least \c positions.size() elements the results
+   * are written to.
+   */
+  void rank0_batch(std::span<uint32_t const> const positions,
+                   std::span<uint32_t> const out) const {
+    rank1_batch(positions, out);
+    for (size_t q = 0; q < positions.size(); ++q) {
+      out[q] = positions[q] - out[q];
+    }
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] virtual size_t
+  space_usage() const {
+    return l12_.size() * sizeof(uint64_t) + sizeof(*this);
+  }
+
+protected:
+  /*!
+   * \brief Get the number of bits of the type the data structure is
+   * optimized for before an L2-block.
+   * \param l12 The L1/L2-word of the L1-block.
+   * \param l2_pos Index of the L2-block within the L1-block.
+   * \return Number of ones (or zeros if optimized for zero queries) before
+   * the L2-block.
+   */
+  [[nodiscard]] static uint64_t l2_rank(uint64_t const l12,
+                                        size_t const l2_pos) {
+    return (l12 & 0xFFFFFFFFULL) +
+           ((l12 >> L2_SHIFT[l2_pos]) & L2_MASK[l2_pos]);
+  }
+
+  /*!
+   * \brief Computes rank of the type of bits the data structure is optimized
+   * for.
+   * \param index Index the rank is computed for.
+   * \return Number of ones (or zeros if optimized for zero queries) before
+   * position \c index.
+   */
+  [[nodiscard]] uint32_t stored_rank(size_t index) const {
+    size_t const l1_pos = index / CompactRankSelectConfig::L1_BIT_SIZE;
+    size_t const l2_pos = (index % CompactRankSelectConfig::L1_BIT_SIZE) /
+                          CompactRankSelectConfig::L2_BIT_SIZE;
+    uint64_t result = l2_rank(l12_[l1_pos], l2_pos);
+
+    size_t offset = (index / CompactRankSelectConfig::L2_BIT_SIZE) *
+                    CompactRankSelectConfig::L2_WORD_SIZE;
+    size_t const full_words =
+        (index % CompactRankSelectConfig::L2_BIT_SIZE) / 64;
+    for (size_t i = 0; i < full_words; ++i) {
+      if constexpr (optimize_one_or_dont_care(optimized_for)) {
+        result += std::popcount(data_[offset++]);
+      } else {
+        result += std::popcount(~data_[offset++]);
+      }
+    }
+    if (index %= 64; index > 0) [[likely]] {
+      if constexpr (optimize_one_or_dont_care(optimized_for)) {
+        result += std::popcount(data_[offset] << (64 - index));
+      } else {
+        result += std::popcount((~data_[offset]) << (64 - index));
+      }
+    }
+    return static_cast<uint32_t>(result);
+  }
+
+private:
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+  /*!
+   * \brief Computes rank of ones for eight positions at once.
+   * \param pos Eight 32-bit indices the rank of ones is computed for.
+   * \return Eight 64-bit ranks.
+   */
+  [[nodiscard]] __m512i rank1_x8(__m256i const pos) const {
+    // The index computations are done on 32-bit lanes before widening. The
+    // zero-masking variants are equivalent to the plain intrinsics but avoid
+    // false maybe-uninitialized warnings of some GCC versions.
+    auto const widen = [](__m256i const values) {
+      return _mm512_maskz_cvtepu32_epi64(0xFF, values);
+    };
+    __m512i const pos64 = widen(pos);
+    __m512i const l12 = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(),
+                                                    0xFF,
+                                                    _mm256_srli_epi32(pos, 11),
+                                                    l12_.data(),
+                                                    8);
+    __m512i const l2_pos = widen(
+        _mm256_and_si256(_mm256_srli_epi32(pos, 9), _mm256_set1_epi32(3)));
+    __m512i const shift = _mm512_maskz_permutexvar_epi64(
+        0xFF,
+        l2_pos,
+        _mm512_setr_epi64(0, 32, 42, 53, 0, 0, 0, 0));
+    __m512i const mask = _mm512_maskz_permutexvar_epi64(
+        0xFF,
+        l2_pos,
+        _mm512_setr_epi64(0, 0x3FF, 0x7FF, 0x7FF, 0, 0, 0, 0));
+    __m512i const stored = _mm512_add_epi64(
+        _mm512_and_si512(l12, _mm512_set1_epi64(0xFFFFFFFFLL)),
+        _mm512_and_si512(_mm512_maskz_srlv_epi64(0xFF, l12, shift), mask));
+
+    // Count the ones in the L2-block before each position. Only words before
+    // the positions are loaded, i.e., there are no out of bounds accesses.
+    __m512i const first_word =
+        widen(_mm256_slli_epi32(_mm256_srli_epi32(pos, 9), 3));
+    __m512i const full_words = widen(
+        _mm256_and_si256(_mm256_srli_epi32(pos, 6), _mm256_set1_epi32(7)));
+    __m512i const remainder = _mm512_and_si512(pos64, _mm512_set1_epi64(63));
+    __mmask8 const has_remainder =
+        _mm512_test_epi64_mask(remainder, remainder);
+    __m512i const partial_mask = _mm512_sub_epi64(
+        _mm512_maskz_sllv_epi64(0xFF, _mm512_set1_epi64(1), remainder),
+        _mm512_set1_epi64(1));
+    __m512i ones = _mm512_setzero_si512();
+    for (int64_t w = 0; w < 8; ++w) {
+      __m512i const word = _mm512_set1_epi64(w);
+      __mmask8 const full = _mm512_cmplt_epi64_mask(word, full_words);
+      __mmask8 const partial =
+          _mm512_cmpeq_epi64_mask(word, full_words) & has_remainder;
+      if ((full | partial) == 0) {
+        break;
+      }
+      __m512i const words =
+          _mm512_mask_i64gather_epi64(_mm512_setzero_si512(),
+                                      full | partial,
+                                      _mm512_add_epi64(first_word, word),
+                                      data_,
+                                      8);
+      __m512i const bits =
+          _mm512_mask_and_epi64(words, partial, words, partial_mask);
+      ones = _mm512_add_epi64(ones, _mm512_popcnt_epi64(bits));
+    }
+    if constexpr (optimize_one_or_dont_care(optimized_for)) {
+      return _mm512_add_epi64(stored, ones);
+    } else {
+      // stored + (number of bits before pos in its L2-block) - ones are the
+      // zeros before pos.
+      __m512i const in_block =
+          _mm512_and_si512(pos64, _mm512_set1_epi64(511));
+      return _mm512_sub_epi64(
+          pos64,
+          _mm512_sub_epi64(_mm512_add_epi64(stored, in_block), ones));
+    }
+  }
+#endif
+
+  //! Function used for initializing data structure to reduce LOCs of
+  //! constructor.
+  void init() {
+    auto const count = [&](size_t const begin, size_t const end) {
+      uint64_t result = 0;
+      for (size_t i = begin; i < end && i < data_size_; ++i) {
+        if constexpr (optimize_one_or_dont_care(optimized_for)) {
+          result += popcount<1>(data_ + i);
+        } else {
+          result += popcount_zeros<1>(data_ + i);
+        }
+      }
+      return result;
+    };
+
+    uint64_t l1_entry = 0;
+    for (size_t l1_pos = 0; l1_pos < l12_.size(); ++l1_pos) {
+      size_t const word_pos = l1_pos * CompactRankSelectConfig::L1_WORD_SIZE;
+      uint64_t l2_entry = 0;
+      // The L1-entry of the block starting at 2^32 may overflow, but this
+      // block can never be queried.
+      uint64_t l12 = l1_entry & 0xFFFFFFFFULL;
+      for (size_t l2_pos = 1; l2_pos < 4; ++l2_pos) {
+        l2_entry +=
+            count(word_pos +
+                      ((l2_pos - 1) * CompactRankSelectConfig::L2_WORD_SIZE),
+                  word_pos + (l2_pos * CompactRankSelectConfig::L2_WORD_SIZE));
+        l12 |= l2_entry << L2_SHIFT[l2_pos];
+      }
+      l12_[l1_pos] = l12;
+      l1_entry +=
+          l2_entry +
+          count(word_pos + (3 * CompactRankSelectConfig::L2_WORD_SIZE),
+                word_pos + CompactRankSelectConfig::L1_WORD_SIZE);
+    }
+  }
+}; // class CompactRank
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
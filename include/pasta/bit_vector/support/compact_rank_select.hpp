@@ -0,0 +1,246 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/compact_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+#include "pasta/bit_vector/support/popcount.hpp"
+#include "pasta/bit_vector/support/select.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_rank_select
+//! \{
+
+/*!
+ * \brief Select support for \ref BitVector with less than 2^32 bits using
+ * 32-bit counters, samples, and query interfaces.
+ *
+ * Extends \ref CompactRank by samples containing the L1-block of every
+ * \c SELECT_SAMPLE_RATE-th one and zero. A select query binary searches the
+ * L1-blocks between two consecutive samples, then finds the L2-block using
+ * three comparisons, and finally scans at most eight 64-bit words.
+ *
+ * \tparam OptimizedFor Compile time option to optimize data structure for
+ * either 0, 1, or no specific type of query.
+ * \tparam VectorType Type of the vector the rank and select data structure is
+ * constructed for, e.g., plain \c BitVector or a compressed bit vector.
+ */
+template <OptimizedFor optimized_for = OptimizedFor::DONT_CARE,
+          typename VectorType = BitVector>
+class CompactRankSelect final : public CompactRank<optimized_for, VectorType> {
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
+  using CompactRank<optimized_for, VectorType>::data_;
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
+  using CompactRank<optimized_for, VectorType>::l12_;
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
+  using CompactRank<optimized_for, VectorType>::L2_SHIFT;
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
+  using CompactRank<optimized_for, VectorType>::L2_MASK;
+
+  //! L1-block of every \c SELECT_SAMPLE_RATE-th zero (and a sentinel).
+  std::vector<uint32_t> samples0_;
+  //! L1-block of every \c SELECT_SAMPLE_RATE-th one (and a sentinel).
+  std::vector<uint32_t> samples1_;
+
+public:
+  //! Default constructor w/o parameter.
+  CompactRankSelect() = default;
+
+  /*!
+   * \brief Constructor. Creates the auxiliary information for efficient rank
+   * and select queries.
+   * \param bv Vector of type \c VectorType the rank and select structure is
+   * created for. Must contain less than 2^32 bits.
+   */
+  CompactRankSelect(VectorType& bv)
+      : CompactRank<optimized_for, VectorType>(bv) {
+    init<false>(samples0_);
+    init<true>(samples1_);
+  }
+
+  //! Default move constructor.
+  CompactRankSelect(CompactRankSelect&&) = default;
+
+  //! Default move assignment.
+  CompactRankSelect& operator=(CompactRankSelect&&) = default;
+
+  /*!
+   * \brief Get position of specific zero, i.e., select.
+   * \param rank Rank of zero the position is searched for.
+   * \return Position of the rank-th zero.
+   */
+  [[nodiscard("select0 computed but not used")]] uint32_t
+  select0(uint32_t const rank) const {
+    return select<false>(rank);
+  }
+
+  /*!
+   * \brief Get position of specific one, i.e., select.
+   * \param rank Rank of one the position is searched for.
+   * \return Position of the rank-th one.
+   */
+  [[nodiscard("select1 computed but not used")]] uint32_t
+  select1(uint32_t const rank) const {
+    return select<true>(rank);
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const override {
+    return (l12_.size() * sizeof(uint64_t)) +
+           ((samples0_.size() + samples1_.size()) * sizeof(uint32_t)) +
+           sizeof(*this);
+  }
+
+private:
+  //! \c true if the L1/L2-information counts ones.
+  static constexpr bool STORES_ONES = optimize_one_or_dont_care(optimized_for);
+
+  /*!
+   * \brief Number of bits with a specific value before an L1-block.
+   * \tparam value Value of the bits that are counted.
+   * \param l1_pos Index of the L1-block.
+   * \return Number of bits equal to \c value before the L1-block.
+   */
+  template <bool value>
+  [[nodiscard]] uint64_t l1_rank(size_t const l1_pos) const {
+    uint64_t const stored = l12_[l1_pos] & 0xFFFFFFFFULL;
+    if constexpr (value == STORES_ONES) {
+      return stored;
+    } else {
+      return (l1_pos * CompactRankSelectConfig::L1_BIT_SIZE) - stored;
+    }
+  }
+
+  /*!
+   * \brief Number of bits with a specific value in the first L2-blocks of an
+   * L1-block.
+   * \tparam value Value of the bits that are counted.
+   * \param l12 L1/L2-word of the L1-block.
+   * \param l2_pos Number of L2-blocks that are considered.
+   * \return Number of bits equal to \c value in the first \c l2_pos L2-blocks.
+   */
+  template <bool value>
+  [[nodiscard]] static uint64_t l2_rank(uint64_t const l12,
+                                        size_t const l2_pos) {
+    uint64_t const stored = (l12 >> L2_SHIFT[l2_pos]) & L2_MASK[l2_pos];
+    if constexpr (value == STORES_ONES) {
+      return stored;
+    } else {
+      return (l2_pos * CompactRankSelectConfig::L2_BIT_SIZE) - stored;
+    }
+  }
+
+  /*!
+   * \brief Index of the last L1-block that can contain a result. Blocks
+   * starting at or after 2^32 are never considered.
+   * \return Index of the last L1-block that can contain a result.
+   */
+  [[nodiscard]] size_t last_l1_block() const {
+    return std::min<size_t>(l12_.size() - 1,
+                            (CompactRankSelectConfig::MAX_BIT_SIZE - 1) /
+                                CompactRankSelectConfig::L1_BIT_SIZE);
+  }
+
+  /*!
+   * \brief Get position of a specific bit.
+   * \tparam value Value of the bit that is searched.
+   * \param rank Rank of the bit the position is searched for.
+   * \return Position of the rank-th bit equal to \c value.
+   */
+  template <bool value>
+  [[nodiscard]] uint32_t select(uint64_t rank) const {
+    std::vector<uint32_t> const& samples = value ? samples1_ : samples0_;
+    size_t const sample_pos =
+        (rank - 1) / CompactRankSelectConfig::SELECT_SAMPLE_RATE;
+    size_t l1_pos = samples[sample_pos];
+    size_t l1_last = samples[sample_pos + 1];
+    while (l1_pos < l1_last) {
+      size_t const mid = (l1_pos + l1_last + 1) / 2;
+      if (l1_rank<value>(mid) < rank) {
+        l1_pos = mid;
+      } else {
+        l1_last = mid - 1;
+      }
+    }
+    rank -= l1_rank<value>(l1_pos);
+
+    uint64_t const l12 = l12_[l1_pos];
+    size_t l2_pos = 0;
+    for (size_t i = 1; i < 4; ++i) {
+      l2_pos += (l2_rank<value>(l12, i) < rank);
+    }
+    rank -= l2_rank<value>(l12, l2_pos);
+
+    size_t word_pos = (l1_pos * CompactRankSelectConfig::L1_WORD_SIZE) +
+                      (l2_pos * CompactRankSelectConfig::L2_WORD_SIZE);
+    uint64_t word = value ? data_[word_pos] : ~data_[word_pos];
+    for (uint64_t ones = std::popcount(word); ones < rank;
+         ones = std::popcount(word)) {
+      rank -= ones;
+      word = value ? data_[++word_pos] : ~data_[++word_pos];
+    }
+    return static_cast<uint32_t>((word_pos * 64) +
+                                 pasta::select(word, rank - 1));
+  }
+
+  /*!
+   * \brief Computes the samples for select queries.
+   * \tparam value Value of the bits that are sampled.
+   * \param samples Vector the samples are written to.
+   */
+  template <bool value>
+  void init(std::vector<uint32_t>& samples) {
+    size_t const last = last_l1_block();
+    uint64_t const max_rank =
+        l1_rank<value>(last) + CompactRankSelectConfig::L1_BIT_SIZE;
+    size_t l1_pos = 0;
+    for (uint64_t rank = 1; rank <= max_rank;
+         rank += CompactRankSelectConfig::SELECT_SAMPLE_RATE) {
+      while (l1_pos < last && l1_rank<value>(l1_pos + 1) < rank) {
+        ++l1_pos;
+      }
+      samples.push_back(static_cast<uint32_t>(l1_pos));
+    }
+    samples.push_back(static_cast<uint32_t>(last));
+  }
+}; // class CompactRankSelect
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
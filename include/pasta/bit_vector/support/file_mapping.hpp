@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace pasta {
+
+/*! \file */
+
+/*!
+ * \ingroup pasta_bit_vector_configuration
+ * \brief Hints about the expected access pattern of memory backed by a file
+ * (see \c madvise()).
+ */
+enum class AccessPattern {
+  //! No special treatment.
+  NORMAL,
+  //! Pages are accessed in sequential order, i.e., read ahead aggressively
+  //! and free pages soon after they have been accessed.
+  SEQUENTIAL,
+  //! Pages are accessed in random order, i.e., do not read ahead.
+  RANDOM,
+  //! Pages will be accessed soon, i.e., read them ahead now.
+  WILL_NEED,
+  //! Pages will not be accessed soon, i.e., they can be freed (modified
+  //! pages are still written to the file).
+  DONT_NEED
+}; // enum class AccessPattern
+
+/*!
+ * \brief Shared memory mapping of a file that owns the file descriptor and
+ * the mapping.
+ *
+ * Changes to the mapped memory are written to the file by the operating
+ * system eventually, or explicitly using \c sync(). The mapping can be
+ * grown and shrunk, which changes the size of the file and may move the
+ * mapping to a different address. Files can also be mapped read-only, in
+ * which case the mapped memory must not be written and cannot be resized.
+ */
+class FileMapping {
+  //! File descriptor of the mapped file or -1 if nothing is mapped.
+  int fd_ = -1;
+  //! Beginning of the mapping.
+  void* address_ = nullptr;
+  //! Size of the mapping (and the file) in bytes.
+  size_t size_ = 0;
+  //! Whether the file is opened and mapped for writing.
+  bool writable_ = false;
+
+public:
+  //! Default constructor. Nothing is mapped.
+  FileMapping() = default;
+
+  //! Move constructor. \c other does not map anything afterwards.
+  FileMapping(FileMapping&& other) noexcept
+      : fd_(std::exchange(other.fd_, -1)),
+        address_(std::exchange(other.address_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        writable_(std::exchange(other.writable_, false)) {}
+
+  //! Move assignment. \c other does not map anything afterwards.
+  FileMapping& operator=(FileMapping&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      fd_ = std::exchange(other.fd_, -1);
+      address_ = std::exchange(other.address_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      writable_ = std::exchange(other.writable_, false);
+    }
+    return *this;
+  }
+
+  //! Deleted copy constructor, the mapping is owned exclusively.
+  FileMapping(FileMapping const&) = delete;
+  //! Deleted copy assignment, the mapping is owned exclusively.
+  FileMapping& operator=(FileMapping const&) = delete;
+
+  //! Destructor. Unmaps the file (without explicit synchronization).
+  ~FileMapping() {
+    unmap();
+  }
+
+  /*!
+   * \brief Creates a new file of a specific size and maps it.
+   * \param path Path of the file.
+   * \param size Size of the file in bytes (must be greater than 0). The
+   * file is filled with zeros.
+   * \return The mapping or \c std::nullopt if the file already exists or
+   * could not be created or mapped.
+   */
+  [[nodiscard("created mapping not used")]] static std::optional<FileMapping>
+  create(std::string const& path, size_t const size) {
+    int const fd = open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      close(fd);
+      unlink(path.c_str());
+      return std::nullopt;
+    }
+    auto result = map(fd, size, true);
+    if (!result.has_value()) {
+      unlink(path.c_str());
+    }
+    return result;
+  }
+
+  /*!
+   * \brief Maps an existing file (completely).
+   * \param path Path of the file.
+   * \param writable If \c false, the file is opened and mapped read-only,
+   * i.e., no write permission is required and the file is never modified.
+   * \return The mapping or \c std::nullopt if the file does not exist, is
+   * empty, or could not be opened or mapped.
+   */
+  [[nodiscard("opened mapping not used")]] static std::optional<FileMapping>
+  open_existing(std::string const& path, bool const writable = true) {
+    int const fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+      close(fd);
+      return std::nullopt;
+    }
+    return map(fd, static_cast<size_t>(info.st_size), writable);
+  }
+
+  /*!
+   * \brief Check whether a file is mapped.
+   * \return \c true if a file is mapped.
+   */
+  [[nodiscard("is_mapped computed but not used")]] bool
+  is_mapped() const noexcept {
+    return address_ != nullptr;
+  }
+
+  /*!
+   * \brief Check whether the mapped memory can be written.
+   * \return \c true if the file is opened and mapped for writing.
+   */
+  [[nodiscard("is_writable computed but not used")]] bool
+  is_writable() const noexcept {
+    return writable_;
+  }
+
+  /*!
+   * \brief Get the beginning of the mapping.
+   * \return Pointer to the first mapped byte (\c nullptr if nothing is
+   * mapped).
+   */
+  [[nodiscard("data computed but not used")]] void* data() const noexcept {
+    return address_;
+  }
+
+  /*!
+   * \brief Get the size of the mapping.
+   * \return Size of the mapping (and the file) in bytes.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Changes the size of the file and the mapping. New bytes are
+   * zero. The mapping may move to a different address.
+   * \param size New size in bytes (must be greater than 0).
+   * \return \c true if the file and the mapping have been resized. If
+   * \c false is returned (always for read-only mappings), the mapping is
+   * unchanged.
+   */
+  bool resize(size_t const size) {
+    if (size == size_) {
+      return true;
+    }
+    if (!writable_) {
+      return false;
+    }
+    // Grow the file before growing the mapping (and shrink it after
+    // shrinking the mapping), such that every mapped page is backed.
+    if (size > size_ && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      return false;
+    }
+#if defined(__linux__)
+    void* const address = mremap(address_, size_, size, MREMAP_MAYMOVE);
+#else
+    void* const address =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (address != MAP_FAILED) {
+      munmap(address_, size_);
+    }
+#endif
+    if (address == MAP_FAILED) {
+      if (size > size_) {
+        [[maybe_unused]] int const ret =
+            ftruncate(fd_, static_cast<off_t>(size_));
+      }
+      return false;
+    }
+    address_ = address;
+    if (size < size_ && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      size_ = size;
+      return false;
+    }
+    size_ = size;
+    return true;
+  }
+
+  /*!
+   * \brief Writes modified pages of a range of the mapping to the file.
+   * \param begin Offset (in bytes) of the first byte of the range.
+   * \param end Offset (in bytes) after the last byte of the range.
+   * \param async If \c true, the writes are only scheduled and the function
+   * returns immediately. Otherwise, it returns after the data is written.
+   * \return \c true on success.
+   */
+  bool sync(size_t const begin, size_t const end, bool const async = false) {
+    if (begin >= end) {
+      return true;
+    }
+    auto const [first, last] = page_range(begin, end);
+    return msync(static_cast<char*>(address_) + first,
+                 last - first,
+                 async ? MS_ASYNC : MS_SYNC) == 0;
+  }
+
+  /*!
+   * \brief Gives the operating system a hint about the expected access
+   * pattern of a range of the mapping (see \c madvise()).
+   * \param pattern Expected access pattern.
+   * \param begin Offset (in bytes) of the first byte of the range.
+   * \param end Offset (in bytes) after the last byte of the range.
+   * \return \c true on success.
+   */
+  bool advise(AccessPattern const pattern,
+              size_t const begin,
+              size_t const end) {
+    if (begin >= end) {
+      return true;
+    }
+    int advice = MADV_NORMAL;
+    switch (pattern) {
+      case AccessPattern::NORMAL:
+        advice = MADV_NORMAL;
+        break;
+      case AccessPattern::SEQUENTIAL:
+        advice = MADV_SEQUENTIAL;
+        break;
+      case AccessPattern::RANDOM:
+        advice = MADV_RANDOM;
+        break;
+      case AccessPattern::WILL_NEED:
+        advice = MADV_WILLNEED;
+        break;
+      case AccessPattern::DONT_NEED:
+        advice = MADV_DONTNEED;
+        break;
+    }
+    auto const [first, last] = page_range(begin, end);
+    return madvise(static_cast<char*>(address_) + first,
+                   last - first,
+                   advice) == 0;
+  }
+
+private:
+  /*!
+   * \brief Maps an opened file. The file descriptor is closed if the file
+   * cannot be mapped.
+   * \param fd File descriptor of the file (opened for reading and, if
+   * \c writable, for writing).
+   * \param size Size of the file in bytes.
+   * \param writable Whether the mapped memory can be written.
+   * \return The mapping or \c std::nullopt if the file could not be mapped.
+   */
+  static std::optional<FileMapping>
+  map(int const fd, size_t const size, bool const writable) {
+    int const protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* const address = mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+      close(fd);
+      return std::nullopt;
+    }
+    FileMapping result;
+    result.fd_ = fd;
+    result.address_ = address;
+    result.size_ = size;
+    result.writable_ = writable;
+    return result;
+  }
+
+  /*!
+   * \brief Extends a range of the mapping to whole pages (\c msync() and
+   * \c madvise() require page-aligned addresses).
+   * \param begin Offset (in bytes) of the first byte of the range.
+   * \param end Offset (in bytes) after the last byte of the range.
+   * \return Offsets of the first page of the range and after the last page
+   * of the range (clamped to the size of the mapping).
+   */
+  std::pair<size_t, size_t> page_range(size_t const begin,
+                                       size_t const end) const {
+    size_t const page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t const first = (begin / page_size) * page_size;
+    size_t const last = std::min(
+        ((end + page_size - 1) / page_size) * page_size,
+        ((size_ + page_size - 1) / page_size) * page_size);
+    return {first, last};
+  }
+
+  //! Unmaps the file and closes the file descriptor.
+  void unmap() {
+    if (address_ != nullptr) {
+      munmap(address_, size_);
+      address_ = nullptr;
+      size_ = 0;
+      writable_ = false;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+}; // class FileMapping
+
+} // namespace pasta
+
+/******************************************************************************/
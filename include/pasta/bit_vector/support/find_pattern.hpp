@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace pasta {
+
+/*! \file */
+
+/*!
+ * \brief Find all offsets in a 64-bit word where a short bit pattern starts.
+ *
+ * The two words \c lo and \c hi are considered as one 128-bit word (with
+ * \c lo containing the less significant bits). For each of the 64 offsets in
+ * \c lo, the \c length bits starting at the offset are compared with the
+ * pattern. With AVX-512 (AVX2), eight (four) adjacent offsets are compared at
+ * once using variable shifts. Otherwise, bit-parallel Shift-And is used,
+ * i.e., the candidate offsets are filtered one pattern bit at a time, which
+ * stops as soon as no candidate remains.
+ *
+ * \param lo Word containing the offsets where the pattern may start.
+ * \param hi Word following \c lo.
+ * \param pattern The pattern (least significant bit first). Bits at position
+ * \c length and above must be zero.
+ * \param length Length of the pattern in bits (between 1 and 64).
+ * \return Word where the i-th bit is set iff the pattern starts at offset i.
+ */
+[[nodiscard]] inline uint64_t match_pattern(uint64_t const lo,
+                                            uint64_t const hi,
+                                            uint64_t const pattern,
+                                            size_t const length) {
+  uint64_t const mask = (length == 64) ? ~0ULL : ((1ULL << length) - 1);
+#if defined(__AVX512F__)
+  __m512i const lo_v = _mm512_set1_epi64(static_cast<int64_t>(lo));
+  __m512i const hi_v = _mm512_set1_epi64(static_cast<int64_t>(hi));
+  __m512i const pattern_v = _mm512_set1_epi64(static_cast<int64_t>(pattern));
+  __m512i const mask_v = _mm512_set1_epi64(static_cast<int64_t>(mask));
+  __m512i const eight = _mm512_set1_epi64(8);
+  __m512i offsets = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+  // Shifting by 64 or more results in zero, i.e., hi is ignored at offset 0.
+  __m512i hi_shifts = _mm512_setr_epi64(64, 63, 62, 61, 60, 59, 58, 57);
+  uint64_t result = 0;
+  // The zero-masking shifts are equivalent to the plain shifts but avoid
+  // false maybe-uninitialized warnings of some GCC versions.
+  for (size_t i = 0; i < 64; i += 8) {
+    __m512i const windows =
+        _mm512_or_si512(_mm512_maskz_srlv_epi64(0xFF, lo_v, offsets),
+                        _mm512_maskz_sllv_epi64(0xFF, hi_v, hi_shifts));
+    __mmask8 const matches = _mm512_cmpeq_epi64_mask(
+        _mm512_and_si512(windows, mask_v),
+        pattern_v);
+    result |= static_cast<uint64_t>(matches) << i;
+    offsets = _mm512_add_epi64(offsets, eight);
+    hi_shifts = _mm512_sub_epi64(hi_shifts, eight);
+  }
+  return result;
+#elif defined(__AVX2__)
+  __m256i const lo_v = _mm256_set1_epi64x(static_cast<int64_t>(lo));
+  __m256i const hi_v = _mm256_set1_epi64x(static_cast<int64_t>(hi));
+  __m256i const pattern_v = _mm256_set1_epi64x(static_cast<int64_t>(pattern));
+  __m256i const mask_v = _mm256_set1_epi64x(static_cast<int64_t>(mask));
+  __m256i const four = _mm256_set1_epi64x(4);
+  __m256i offsets = _mm256_setr_epi64x(0, 1, 2, 3);
+  // Shifting by 64 or more results in zero, i.e., hi is ignored at offset 0.
+  __m256i hi_shifts = _mm256_setr_epi64x(64, 63, 62, 61);
+  uint64_t result = 0;
+  for (size_t i = 0; i < 64; i += 4) {
+    __m256i const windows =
+        _mm256_or_si256(_mm256_srlv_epi64(lo_v, offsets),
+                        _mm256_sllv_epi64(hi_v, hi_shifts));
+    __m256i const matches =
+        _mm256_cmpeq_epi64(_mm256_and_si256(windows, mask_v), pattern_v);
+    result |= static_cast<uint64_t>(
+                  _mm256_movemask_pd(_mm256_castsi256_pd(matches)))
+              << i;
+    offsets = _mm256_add_epi64(offsets, four);
+    hi_shifts = _mm256_sub_epi64(hi_shifts, four);
+  }
+  return result;
+#else
+  (void)mask;
+  uint64_t candidates = ~0ULL;
+  for (size_t j = 0; j < length && candidates != 0ULL; ++j) {
+    // The i-th bit of shifted is bit i + j of the 128-bit word.
+    uint64_t const shifted = (j == 0) ? lo : (lo >> j) | (hi << (64 - j));
+    candidates &= ((pattern >> j) & 1ULL) ? shifted : ~shifted;
+  }
+  return candidates;
+#endif
+}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace pasta {
+
+/*! \file */
+
+/*!
+ * \brief Find the first 64-bit word that is not equal to \c Skip.
+ *
+ * Runs of words equal to \c Skip are skipped 512 bits at a time, using one
+ * AVX-512 compare or two AVX2 compares (if available). Note that there are no
+ * bound checks.
+ *
+ * \tparam Skip Value of the words that are skipped, i.e., \c 0 to find the
+ * first word containing a one and \c ~0 to find the first word containing a
+ * zero.
+ * \param data Pointer to the 64-bit words.
+ * \param begin Index of the first word that is considered.
+ * \param end Index one past the last word that is considered.
+ * \return Index of the first word in [begin, end) that is not equal to
+ * \c Skip or \c end if there is no such word.
+ */
+template <uint64_t Skip>
+[[nodiscard]] inline size_t find_next_word_not(uint64_t const* const data,
+                                               size_t begin,
+                                               size_t const end) {
+#if defined(__AVX512F__)
+  __m512i const skip = _mm512_set1_epi64(static_cast<int64_t>(Skip));
+  for (; begin + 8 <= end; begin += 8) {
+    __m512i const words = _mm512_loadu_si512(data + begin);
+    if (__mmask8 const mask = _mm512_cmpneq_epi64_mask(words, skip);
+        mask != 0) {
+      return begin + std::countr_zero(static_cast<uint32_t>(mask));
+    }
+  }
+#elif defined(__AVX2__)
+  __m256i const skip = _mm256_set1_epi64x(static_cast<int64_t>(Skip));
+  for (; begin + 8 <= end; begin += 8) {
+    __m256i const lo = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(data + begin));
+    __m256i const hi = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(data + begin + 4));
+    uint32_t const equal =
+        static_cast<uint32_t>(_mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(lo, skip)))) |
+        (static_cast<uint32_t>(_mm256_movemask_pd(
+             _mm256_castsi256_pd(_mm256_cmpeq_epi64(hi, skip))))
+         << 4);
+    if (equal != 0b11111111) {
+      return begin + std::countr_one(equal);
+    }
+  }
+#endif
+  for (; begin < end; ++begin) {
+    if (data[begin] != Skip) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+/*!
+ * \brief Find the last 64-bit word that is not equal to \c Skip.
+ *
+ * Backward version of \ref find_next_word_not().
+ *
+ * \tparam Skip Value of the words that are skipped, i.e., \c 0 to find the
+ * last word containing a one and \c ~0 to find the last word containing a
+ * zero.
+ * \param data Pointer to the 64-bit words.
+ * \param begin Index of the first word that is considered.
+ * \param end Index one past the last word that is considered.
+ * \return Index of the last word in [begin, end) that is not equal to
+ * \c Skip or \c end if there is no such word.
+ */
+template <uint64_t Skip>
+[[nodiscard]] inline size_t find_prev_word_not(uint64_t const* const data,
+                                               size_t const begin,
+                                               size_t const end) {
+  size_t pos = end;
+#if defined(__AVX512F__)
+  __m512i const skip = _mm512_set1_epi64(static_cast<int64_t>(Skip));
+  for (; pos >= begin + 8; pos -= 8) {
+    __m512i const words = _mm512_loadu_si512(data + pos - 8);
+    if (__mmask8 const mask = _mm512_cmpneq_epi64_mask(words, skip);
+        mask != 0) {
+      return pos - 1 - std::countl_zero(static_cast<uint8_t>(mask));
+    }
+  }
+#elif defined(__AVX2__)
+  __m256i const skip = _mm256_set1_epi64x(static_cast<int64_t>(Skip));
+  for (; pos >= begin + 8; pos -= 8) {
+    __m256i const lo = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(data + pos - 8));
+    __m256i const hi = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(data + pos - 4));
+    uint32_t const equal =
+        static_cast<uint32_t>(_mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(lo, skip)))) |
+        (static_cast<uint32_t>(_mm256_movemask_pd(
+             _mm256_castsi256_pd(_mm256_cmpeq_epi64(hi, skip))))
+         << 4);
+    if (equal != 0b11111111) {
+      return pos - 1 - std::countl_one(static_cast<uint8_t>(equal));
+    }
+  }
+#endif
+  while (pos > begin) {
+    if (data[--pos] != Skip) {
+      return pos;
+    }
+  }
+  return end;
+}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -26,9 +26,17 @@
 #include "pasta/bit_vector/support/optimized_for.hpp"
 #include "pasta/bit_vector/support/popcount.hpp"
 
+#include <array>
+#include <bit>
 #include <numeric>
 #include <pasta/utils/debug_asserts.hpp>
+#include <span>
 #include <tlx/container/simple_vector.hpp>
+#include <utility>
+#include <vector>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
 
 namespace pasta {
 
@@ -70,7 +78,9 @@ struct FlatRankSelectConfig {
  * twice as many L2-blocks in a single L1-block. This allows us to store more
  * information---most importantly the number of ones w.r.t. the beginning of
  * the L1-block---in the L2-blocks. For the L1/2-block layout see
- * \ref BigL12Type.
+ * \ref BigL12Type. L1-blocks containing L2-blocks with only zeros or only
+ * ones are marked, such that queries in these L2-blocks are answered without
+ * accessing the bit vector.
  *
  * \tparam OptimizedFor Compile time option to optimize data structure for
  * either 0, 1, or no specific type of query.
@@ -92,6 +102,9 @@ protected:
 
   //! Array containing the information about the L1- and L2-blocks.
   tlx::SimpleVector<BigL12Type, tlx::SimpleVectorMode::NoInitNoDestroy> l12_;
+  //! Pointer to the L1- and L2-blocks used by queries. Either points to
+  //! \c l12_ or to external memory (see \ref SharedFlatRankSelect).
+  BigL12Type const* l12_data_ = nullptr;
   //! Number of actual existing BigL12-blocks (important for scanning)
   size_t l12_end_ = 0;
 
@@ -107,10 +120,31 @@ public:
   FlatRank(VectorType& bv)
       : data_size_(bv.data().size()),
         data_(bv.data().data()),
-        l12_((data_size_ / FlatRankSelectConfig::L1_WORD_SIZE) + 1) {
+        l12_((data_size_ / FlatRankSelectConfig::L1_WORD_SIZE) + 1),
+        l12_data_(l12_.data()) {
     init();
   }
 
+protected:
+  /*!
+   * \brief Constructor. Uses rank information that has been computed before
+   * and is stored in external memory, e.g., a shared memory segment. Nothing
+   * is copied and the memory must outlive this object.
+   * \param data Pointer to the data of the bit vector.
+   * \param data_size Number of 64-bit words of the bit vector.
+   * \param l12 Pointer to the L1- and L2-blocks.
+   * \param l12_end Number of L1- and L2-blocks.
+   */
+  FlatRank(VectorType::RawDataConstAccess data,
+           size_t const data_size,
+           BigL12Type const* const l12,
+           size_t const l12_end)
+      : data_size_(data_size),
+        data_(data),
+        l12_data_(l12),
+        l12_end_(l12_end) {}
+
+public:
   /*!
    * \brief Computes rank of zeros.
    * \param index Index the rank of zeros is computed for.
@@ -132,7 +166,8 @@ public:
     size_t const l1_pos = index / FlatRankSelectConfig::L1_BIT_SIZE;
     size_t const l2_pos = ((index % FlatRankSelectConfig::L1_BIT_SIZE) /
                            FlatRankSelectConfig::L2_BIT_SIZE);
-    size_t result = l12_[l1_pos].l1() + l12_[l1_pos][l2_pos];
+    BigL12Type const& l12 = l12_data_[l1_pos];
+    size_t result = l12.l1() + l12[l2_pos];
 
     // It is faster to not have a specialized rank0 function when
     // optimized for zero queries, because there is no popcount for
@@ -149,6 +184,15 @@ public:
     PASTA_ASSERT(index < 512,
                  "Trying to access bits that should be "
                  "covered in an L1-block");
+    // Uniform L2-blocks do not require any popcounts.
+    if (l12.has_uniform_l2()) [[unlikely]] {
+      if (l2_all_zeros(l1_pos, l2_pos)) {
+        return result;
+      }
+      if (l2_all_ones(l1_pos, l2_pos)) {
+        return result + index;
+      }
+    }
     for (size_t i = 0; i < index / 64; ++i) {
       result += std::popcount(data_[offset++]);
     }
@@ -159,6 +203,85 @@ public:
     return result;
   }
 
+  /*!
+   * \brief Update the rank information after bits in the bit vector have been
+   * modified.
+   *
+   * Only the L1-blocks marked in the dirty-region bitmap of the bit vector
+   * (see \ref BitVector::track_dirty_regions()) are recomputed, which is done
+   * in parallel (if OpenMP is available). Afterwards, the L1-values of all
+   * following L1-blocks are shifted by the changed counts in a single
+   * sequential pass that stops as soon as there are no more changes to
+   * propagate. The marks are not cleared, since the bit vector might be used
+   * by multiple rank and select structures (see
+   * \ref BitVector::clear_dirty_regions()).
+   *
+   * \param bv The bit vector this rank structure has been constructed for.
+   * Its size must not have changed since then.
+   */
+  void refresh(VectorType const& bv) {
+    static_assert(FlatRankSelectConfig::L1_BIT_SIZE ==
+                      BitVector::DIRTY_REGION_BITS,
+                  "Dirty regions must match L1-blocks.");
+    PASTA_ASSERT(bv.data().data() == data_ && bv.data().size() == data_size_,
+                 "Refresh requires the bit vector the rank structure has "
+                 "been constructed for.");
+    PASTA_ASSERT(l12_data_ == l12_.data(),
+                 "Rank information in external memory cannot be refreshed.");
+    PASTA_ASSERT(bv.tracks_dirty_regions(),
+                 "Modified regions of the bit vector are not tracked.");
+
+    std::span<uint64_t const> const dirty = bv.dirty_regions();
+    std::vector<size_t> dirty_l1;
+    for (size_t w = 0; w < dirty.size(); ++w) {
+      for (uint64_t word = dirty[w]; word != 0; word &= word - 1) {
+        size_t const l1_pos = (w * 64) + std::countr_zero(word);
+        if (l1_pos < l12_end_) {
+          dirty_l1.push_back(l1_pos);
+        }
+      }
+    }
+    if (dirty_l1.empty()) {
+      return;
+    }
+
+    // Recompute the dirty L1-blocks (with L1-value 0) and the difference of
+    // the number of counted bits compared to the current information.
+    std::vector<std::pair<BigL12Type, int64_t>> updates(dirty_l1.size());
+#if defined(_OPENMP)
+#  pragma omp parallel for if (dirty_l1.size() >= 64)
+#endif
+    for (size_t i = 0; i < dirty_l1.size(); ++i) {
+      size_t const l1_pos = dirty_l1[i];
+      auto const [l12, count] = compute_l12(l1_pos, 0);
+      int64_t delta = 0;
+      if (l1_pos + 1 < l12_end_) {
+        delta = static_cast<int64_t>(count) -
+                static_cast<int64_t>(l12_[l1_pos + 1].l1() -
+                                     l12_[l1_pos].l1());
+      }
+      updates[i] = {l12, delta};
+    }
+
+    // Prefix sum over the differences to fix the L1-values.
+    int64_t shift = 0;
+    size_t next_dirty = 0;
+    for (size_t l1_pos = dirty_l1.front(); l1_pos < l12_end_; ++l1_pos) {
+      uint64_t const l1_entry = l12_[l1_pos].l1() + shift;
+      if (next_dirty < dirty_l1.size() && dirty_l1[next_dirty] == l1_pos) {
+        l12_[l1_pos] = updates[next_dirty].first;
+        shift += updates[next_dirty++].second;
+      } else if (shift == 0) {
+        if (next_dirty == dirty_l1.size()) {
+          break;
+        }
+        l1_pos = dirty_l1[next_dirty] - 1;
+        continue;
+      }
+      l12_[l1_pos].set_l1(l1_entry);
+    }
+  }
+
   /*!
    * \brief Estimate for the space usage.
    * \return Number of bytes used by this data structure.
@@ -168,17 +291,101 @@ public:
     return l12_.size() * sizeof(BigL12Type) + sizeof(*this);
   }
 
+protected:
+  /*!
+   * \brief Get the number of bits the L2-entries count (ones or zeros) in an
+   * L2-block.
+   * \param l1_pos Index of the L1-block.
+   * \param l2_pos Index of the L2-block within the L1-block.
+   * \return Number of counted bits in the L2-block. For the last L2-block of
+   * the last L1-block, 1 is returned, i.e., it is never considered uniform.
+   */
+  [[nodiscard]] uint64_t l2_count(size_t const l1_pos,
+                                  size_t const l2_pos) const {
+    BigL12Type const& l12 = l12_data_[l1_pos];
+    if (l2_pos < 7) {
+      return l12[l2_pos + 1] - l12[l2_pos];
+    }
+    if (l1_pos + 1 < l12_end_) {
+      return l12_data_[l1_pos + 1].l1() - l12.l1() - l12[7];
+    }
+    return 1;
+  }
+
+  /*!
+   * \brief Check whether an L2-block contains only zeros.
+   * \param l1_pos Index of the L1-block.
+   * \param l2_pos Index of the L2-block within the L1-block.
+   * \return \c true if the L2-block contains only zeros.
+   */
+  [[nodiscard]] bool l2_all_zeros(size_t const l1_pos,
+                                  size_t const l2_pos) const {
+    if constexpr (optimize_one_or_dont_care(optimized_for)) {
+      return l2_count(l1_pos, l2_pos) == 0;
+    } else {
+      return l2_count(l1_pos, l2_pos) == FlatRankSelectConfig::L2_BIT_SIZE;
+    }
+  }
+
+  /*!
+   * \brief Check whether an L2-block contains only ones.
+   * \param l1_pos Index of the L1-block.
+   * \param l2_pos Index of the L2-block within the L1-block.
+   * \return \c true if the L2-block contains only ones.
+   */
+  [[nodiscard]] bool l2_all_ones(size_t const l1_pos,
+                                 size_t const l2_pos) const {
+    if constexpr (optimize_one_or_dont_care(optimized_for)) {
+      return l2_count(l1_pos, l2_pos) == FlatRankSelectConfig::L2_BIT_SIZE;
+    } else {
+      return l2_count(l1_pos, l2_pos) == 0;
+    }
+  }
+
 private:
-  //! Function used for initializing data structure to reduce LOCs of
-  //! constructor.
-  void init() {
-    uint64_t const* data = data_;
-    uint64_t const* const data_end = data_ + data_size_;
+  /*!
+   * \brief Check whether one of the first seven L2-blocks of an L1-block is
+   * uniform.
+   * \param l2_entries Prefix sums of the counted bits in the first seven
+   * L2-blocks.
+   * \return \c true if one of the first seven L2-blocks is uniform.
+   */
+  static bool has_uniform_l2(std::array<uint16_t, 7> const& l2_entries) {
+    uint64_t previous = 0;
+    bool result = false;
+    for (uint64_t const entry : l2_entries) {
+      uint64_t const count = entry - previous;
+      result |= (count == 0 || count == FlatRankSelectConfig::L2_BIT_SIZE);
+      previous = entry;
+    }
+    return result;
+  }
 
-    uint64_t l1_entry = 0ULL;
+  /*!
+   * \brief Check whether an L1-block is followed by another L1-block, i.e.,
+   * whether it is not the last L1-block.
+   * \param l1_pos Index of the L1-block.
+   * \return \c true if the L1-block is not the last L1-block.
+   */
+  [[nodiscard]] bool is_full_l1(size_t const l1_pos) const {
+    return ((l1_pos + 1) * FlatRankSelectConfig::L1_WORD_SIZE) < data_size_;
+  }
+
+  /*!
+   * \brief Compute the L12-block of an L1-block.
+   * \param l1_pos Index of the L1-block.
+   * \param l1_entry Number of counted bits before the L1-block.
+   * \return The L12-block and the number of counted bits in the L1-block
+   * (the latter is only meaningful if the L1-block is not the last one).
+   */
+  [[nodiscard]] std::pair<BigL12Type, uint64_t>
+  compute_l12(size_t const l1_pos, uint64_t const l1_entry) const {
+    uint64_t const* data =
+        data_ + (l1_pos * FlatRankSelectConfig::L1_WORD_SIZE);
+    uint64_t const* const data_end = data_ + data_size_;
     std::array<uint16_t, 7> l2_entries = {0, 0, 0, 0, 0, 0, 0};
 
-    while (data + 64 < data_end) {
+    if (is_full_l1(l1_pos)) {
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
         l2_entries[0] = popcount<8>(data);
       } else {
@@ -193,16 +400,20 @@ private:
         }
         data += 8;
       }
-      l12_[l12_end_++] = BigL12Type(l1_entry, l2_entries);
+      uint64_t last_l2_entry;
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
-        l1_entry += l2_entries.back() + popcount<8>(data);
+        last_l2_entry = popcount<8>(data);
       } else {
-        l1_entry += l2_entries.back() + popcount_zeros<8>(data);
+        last_l2_entry = popcount_zeros<8>(data);
       }
-      data += 8;
+      bool const has_uniform =
+          has_uniform_l2(l2_entries) || last_l2_entry == 0 ||
+          last_l2_entry == FlatRankSelectConfig::L2_BIT_SIZE;
+      return {BigL12Type(l1_entry, l2_entries, has_uniform),
+              l2_entries.back() + last_l2_entry};
     }
+
     size_t l2_pos = 0;
-    l2_entries = {0, 0, 0, 0, 0, 0, 0};
     while (data + 8 < data_end) {
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
         l2_entries[l2_pos++] = popcount<8>(data);
@@ -221,7 +432,22 @@ private:
       }
     }
     std::partial_sum(l2_entries.begin(), l2_entries.end(), l2_entries.begin());
-    l12_[l12_end_++] = BigL12Type(l1_entry, l2_entries);
+    return {BigL12Type(l1_entry, l2_entries, has_uniform_l2(l2_entries)),
+            l2_entries.back()};
+  }
+
+  //! Function used for initializing data structure to reduce LOCs of
+  //! constructor.
+  void init() {
+    uint64_t l1_entry = 0ULL;
+    size_t l1_pos = 0;
+    for (; is_full_l1(l1_pos); ++l1_pos) {
+      auto const [l12, count] = compute_l12(l1_pos, l1_entry);
+      l12_[l1_pos] = l12;
+      l1_entry += count;
+    }
+    l12_[l1_pos] = compute_l12(l1_pos, l1_entry).first;
+    l12_end_ = l1_pos + 1;
   }
 }; // class FlatRank
 
@@ -82,7 +82,16 @@ class FlatRankSelect final : public FlatRank<optimized_for> {
   using FlatRank<optimized_for>::l12_;
   //! Get access to protected members of base class, as dependent
   //! names are not considered.
+  using FlatRank<optimized_for>::l12_data_;
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
   using FlatRank<optimized_for>::l12_end_;
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
+  using FlatRank<optimized_for>::l2_all_zeros;
+  //! Get access to protected members of base class, as dependent
+  //! names are not considered.
+  using FlatRank<optimized_for>::l2_all_ones;
 
   template <typename T>
   using Array = tlx::SimpleVector<T, tlx::SimpleVectorMode::NoInitNoDestroy>;
@@ -92,6 +101,21 @@ class FlatRankSelect final : public FlatRank<optimized_for> {
   std::vector<uint32_t> samples0_;
   //! Positions of every \c SELECT_SAMPLE_RATE one.
   std::vector<uint32_t> samples1_;
+  //! Pointer to the samples of zeros used by queries. Either points to
+  //! \c samples0_ or to external memory (see \ref SharedFlatRankSelect).
+  uint32_t const* samples0_data_ = nullptr;
+  //! Pointer to the samples of ones used by queries. Either points to
+  //! \c samples1_ or to external memory (see \ref SharedFlatRankSelect).
+  uint32_t const* samples1_data_ = nullptr;
+
+  //! Friend class, placing the rank and select information in shared memory.
+  template <OptimizedFor o, FindL2FlatWith f>
+  friend class SharedFlatRankSelect;
+
+  //! Friend class, keeping the rank and select information in memory while
+  //! the bit vector is stored on disk.
+  template <OptimizedFor o>
+  friend class ExternalFlatRankSelect;
 
 public:
   //! Default constructor w/o parameter.
@@ -105,6 +129,8 @@ public:
    */
   FlatRankSelect(VectorType& bv) : FlatRank<optimized_for, VectorType>(bv) {
     init();
+    samples0_data_ = samples0_.data();
+    samples1_data_ = samples1_.data();
   }
 
   //! Default move constructor.
@@ -127,28 +153,29 @@ public:
 
     size_t const sample_pos =
         ((rank - 1) / FlatRankSelectConfig::SELECT_SAMPLE_RATE);
-    size_t l1_pos = samples0_[sample_pos];
+    size_t l1_pos = samples0_data_[sample_pos];
     l1_pos += ((rank - 1) % FlatRankSelectConfig::SELECT_SAMPLE_RATE) /
               FlatRankSelectConfig::L1_BIT_SIZE;
     if constexpr (optimize_one_or_dont_care(optimized_for)) {
       while (l1_pos + 1 < l12_end &&
              ((l1_pos + 1) * FlatRankSelectConfig::L1_BIT_SIZE) -
-                     l12_[l1_pos + 1].l1() <
+                     l12_data_[l1_pos + 1].l1() <
                  rank) {
         ++l1_pos;
       }
-      rank -= (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) - l12_[l1_pos].l1();
+      rank -= (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) -
+              l12_data_[l1_pos].l1();
     } else {
-      while (l1_pos + 1 < l12_end && l12_[l1_pos + 1].l1() < rank) {
+      while (l1_pos + 1 < l12_end && l12_data_[l1_pos + 1].l1() < rank) {
         ++l1_pos;
       }
-      rank -= l12_[l1_pos].l1();
+      rank -= l12_data_[l1_pos].l1();
     }
     size_t l2_pos = 0;
     if constexpr (use_intrinsics(find_with)) {
 #if defined(__x86_64__)
       __m128i value =
-          _mm_loadu_si128(reinterpret_cast<__m128i const*>(&l12_[l1_pos]));
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(&l12_data_[l1_pos]));
       __m128i const shuffle_mask = _mm_setr_epi8(10,
                                                  11,
                                                  8,
@@ -226,13 +253,13 @@ public:
       l2_pos = (16 - std::popcount(result)) / 2;
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
         rank -= ((l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) -
-                 l12_[l1_pos][l2_pos]);
+                 l12_data_[l1_pos][l2_pos]);
       } else {
-        rank -= l12_[l1_pos][l2_pos];
+        rank -= l12_data_[l1_pos][l2_pos];
       }
 #endif
     } else if constexpr (use_linear_search(find_with)) {
-      auto tmp = l12_[l1_pos].data >> 32;
+      auto tmp = l12_data_[l1_pos].data >> 32;
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
         while ((l2_pos + 2) * FlatRankSelectConfig::L2_BIT_SIZE -
                        ((tmp >> 12) & uint16_t(0b111111111111)) <
@@ -249,13 +276,13 @@ public:
       }
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
         rank -= (l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) -
-                (l12_[l1_pos][l2_pos]);
+                (l12_data_[l1_pos][l2_pos]);
       } else {
-        rank -= (l12_[l1_pos][l2_pos]);
+        rank -= (l12_data_[l1_pos][l2_pos]);
       }
     } else if constexpr (use_binary_search(find_with)) {
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
-        auto tmp = l12_[l1_pos].data >> 44;
+        auto tmp = l12_data_[l1_pos].data >> 44;
         if (uint16_t const mid = (3 + 2) * FlatRankSelectConfig::L2_BIT_SIZE -
                                  ((tmp >> 36) & uint16_t(0b111111111111));
             mid < rank) {
@@ -311,7 +338,7 @@ public:
           }
         }
       } else {
-        auto tmp = l12_[l1_pos].data >> 44;
+        auto tmp = l12_data_[l1_pos].data >> 44;
         if (uint16_t const mid = ((tmp >> 36) & uint16_t(0b111111111111));
             mid < rank) {
           if (uint16_t const right = ((tmp >> 60) & uint16_t(0b111111111111));
@@ -361,6 +388,16 @@ public:
                     "Using unsupported search method for l2 entries");
     }
 
+    // In an L2-block containing only zeros, the position can be computed
+    // without accessing the bit vector. Note that the search above may stop
+    // at an L2-block before the one containing the result, in which case the
+    // remaining rank is larger than the L2-block.
+    if (rank <= FlatRankSelectConfig::L2_BIT_SIZE &&
+        l12_data_[l1_pos].has_uniform_l2() && l2_all_zeros(l1_pos, l2_pos)) {
+      return (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) +
+             (l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) + rank - 1;
+    }
+
     size_t last_pos = (FlatRankSelectConfig::L2_WORD_SIZE * l2_pos) +
                       (FlatRankSelectConfig::L1_WORD_SIZE * l1_pos);
     size_t popcount = 0;
@@ -383,26 +420,27 @@ public:
 
     size_t const sample_pos =
         ((rank - 1) / FlatRankSelectConfig::SELECT_SAMPLE_RATE);
-    size_t l1_pos = samples1_[sample_pos];
+    size_t l1_pos = samples1_data_[sample_pos];
     if constexpr (optimize_one_or_dont_care(optimized_for)) {
-      while ((l1_pos + 1) < l12_end && l12_[l1_pos + 1].l1() < rank) {
+      while ((l1_pos + 1) < l12_end && l12_data_[l1_pos + 1].l1() < rank) {
         ++l1_pos;
       }
-      rank -= l12_[l1_pos].l1();
+      rank -= l12_data_[l1_pos].l1();
     } else {
       while (l1_pos + 1 < l12_end &&
              ((l1_pos + 1) * FlatRankSelectConfig::L1_BIT_SIZE) -
-                     l12_[l1_pos + 1].l1() <
+                     l12_data_[l1_pos + 1].l1() <
                  rank) {
         ++l1_pos;
       }
-      rank -= (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) - l12_[l1_pos].l1();
+      rank -= (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) -
+              l12_data_[l1_pos].l1();
     }
     size_t l2_pos = 0;
     if constexpr (use_intrinsics(find_with)) {
 #if defined(__x86_64__)
       __m128i value =
-          _mm_loadu_si128(reinterpret_cast<__m128i const*>(&l12_[l1_pos]));
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(&l12_data_[l1_pos]));
       __m128i const shuffle_mask = _mm_setr_epi8(10,
                                                  11,
                                                  8,
@@ -474,20 +512,20 @@ public:
       // based on the movemask-operation above.
       l2_pos = (16 - std::popcount(result)) / 2;
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
-        rank -= l12_[l1_pos][l2_pos];
+        rank -= l12_data_[l1_pos][l2_pos];
       } else {
         rank -= ((l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) -
-                 l12_[l1_pos][l2_pos]);
+                 l12_data_[l1_pos][l2_pos]);
       }
 #endif
     } else if constexpr (use_linear_search(find_with)) {
-      auto tmp = l12_[l1_pos].data >> 32;
+      auto tmp = l12_data_[l1_pos].data >> 32;
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
         while (((tmp >> 12) & uint16_t(0b111111111111)) < rank && l2_pos < 7) {
           tmp >>= 12;
           ++l2_pos;
         }
-        rank -= (l12_[l1_pos][l2_pos]);
+        rank -= (l12_data_[l1_pos][l2_pos]);
       } else {
         while ((l2_pos + 2) * FlatRankSelectConfig::L2_BIT_SIZE -
                        ((tmp >> 12) & uint16_t(0b111111111111)) <
@@ -497,11 +535,11 @@ public:
           ++l2_pos;
         }
         rank -= (l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) -
-                (l12_[l1_pos][l2_pos]);
+                (l12_data_[l1_pos][l2_pos]);
       }
     } else if constexpr (use_binary_search(find_with)) {
       if constexpr (optimize_one_or_dont_care(optimized_for)) {
-        auto tmp = l12_[l1_pos].data >> 44;
+        auto tmp = l12_data_[l1_pos].data >> 44;
         if (uint16_t const mid = ((tmp >> 36) & uint16_t(0b111111111111));
             mid < rank) {
           if (uint16_t const right = ((tmp >> 60) & uint16_t(0b111111111111));
@@ -544,7 +582,7 @@ public:
           }
         }
       } else {
-        auto tmp = l12_[l1_pos].data >> 44;
+        auto tmp = l12_data_[l1_pos].data >> 44;
         if (uint16_t const mid = (3 + 2) * FlatRankSelectConfig::L2_BIT_SIZE -
                                  ((tmp >> 36) & uint16_t(0b111111111111));
             mid < rank) {
@@ -607,6 +645,16 @@ public:
                     "Using unsupported search method for l2 entries");
     }
 
+    // In an L2-block containing only ones, the position can be computed
+    // without accessing the bit vector. Note that the search above may stop
+    // at an L2-block before the one containing the result, in which case the
+    // remaining rank is larger than the L2-block.
+    if (rank <= FlatRankSelectConfig::L2_BIT_SIZE &&
+        l12_data_[l1_pos].has_uniform_l2() && l2_all_ones(l1_pos, l2_pos)) {
+      return (l1_pos * FlatRankSelectConfig::L1_BIT_SIZE) +
+             (l2_pos * FlatRankSelectConfig::L2_BIT_SIZE) + rank - 1;
+    }
+
     size_t last_pos = (FlatRankSelectConfig::L2_WORD_SIZE * l2_pos) +
                       (FlatRankSelectConfig::L1_WORD_SIZE * l1_pos);
     size_t popcount = 0;
@@ -618,6 +666,25 @@ public:
     return (last_pos * 64) + select(data_[last_pos], rank - 1);
   }
 
+  /*!
+   * \brief Update the rank and select information after bits in the bit
+   * vector have been modified.
+   *
+   * The rank information is refreshed using \ref FlatRank::refresh(), i.e.,
+   * only modified L1-blocks are recomputed. Afterwards, the select samples
+   * are recomputed from the L1-values.
+   * \param bv The bit vector this structure has been constructed for. Its
+   * size must not have changed since then.
+   */
+  void refresh(VectorType const& bv) {
+    FlatRank<optimized_for, VectorType>::refresh(bv);
+    samples0_.clear();
+    samples1_.clear();
+    init();
+    samples0_data_ = samples0_.data();
+    samples1_data_ = samples1_.data();
+  }
+
   /*!
    * \brief Estimate for the space usage.
    * \return Number of bytes used by this data structure.
@@ -629,6 +696,28 @@ public:
   }
 
 private:
+  /*!
+   * \brief Constructor. Uses rank and select information that has been
+   * computed before and is stored in external memory (see
+   * \ref SharedFlatRankSelect). Nothing is copied and the memory must outlive
+   * this object.
+   * \param data Pointer to the data of the bit vector.
+   * \param data_size Number of 64-bit words of the bit vector.
+   * \param l12 Pointer to the L1- and L2-blocks.
+   * \param l12_end Number of L1- and L2-blocks.
+   * \param samples0 Pointer to the samples of zeros.
+   * \param samples1 Pointer to the samples of ones.
+   */
+  FlatRankSelect(typename VectorType::RawDataConstAccess data,
+                 size_t const data_size,
+                 BigL12Type const* const l12,
+                 size_t const l12_end,
+                 uint32_t const* const samples0,
+                 uint32_t const* const samples1)
+      : FlatRank<optimized_for, VectorType>(data, data_size, l12, l12_end),
+        samples0_data_(samples0),
+        samples1_data_(samples1) {}
+
   //! Function used initializing data structure to reduce LOCs of constructor.
   void init() {
     size_t const l12_end = l12_.size();
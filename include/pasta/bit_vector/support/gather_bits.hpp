@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace pasta {
+
+/*! \file */
+
+//! Number of positions the words are prefetched ahead in \ref gather_bits().
+constexpr size_t GATHER_BITS_PREFETCH_DISTANCE = 32;
+
+/*!
+ * \brief Read the bits at up to 64 positions and pack them into a word.
+ *
+ * The words needed \c GATHER_BITS_PREFETCH_DISTANCE positions later are
+ * prefetched, such that the cache misses of different positions overlap.
+ * With AVX-512, the words of eight positions are gathered at once and the
+ * bits are extracted using variable shifts. Note that there are no bound
+ * checks.
+ *
+ * \param data Pointer to the 64-bit words.
+ * \param positions Positions of the bits that are read.
+ * \param count Number of bits that are read (at most 64).
+ * \param available Number of positions that can be accessed starting at
+ * \c positions (at least \c count), which limits the prefetching.
+ * \return Word where the i-th bit is the bit at position \c positions[i].
+ */
+[[nodiscard]] inline uint64_t gather_bits(uint64_t const* const data,
+                                          size_t const* const positions,
+                                          size_t const count,
+                                          size_t const available) {
+  uint64_t result = 0;
+  size_t i = 0;
+#if defined(__AVX512F__)
+  // The zero-masking variants are equivalent to the plain intrinsics but
+  // avoid false maybe-uninitialized warnings of some GCC versions.
+  __m512i const one = _mm512_set1_epi64(1);
+  __m512i const offset_mask = _mm512_set1_epi64(63);
+  for (; i + 8 <= count; i += 8) {
+    size_t const prefetch_end =
+        std::min(i + GATHER_BITS_PREFETCH_DISTANCE + 8, available);
+    for (size_t j = i + GATHER_BITS_PREFETCH_DISTANCE; j < prefetch_end; ++j) {
+      __builtin_prefetch(data + (positions[j] / 64));
+    }
+    __m512i const pos = _mm512_loadu_si512(positions + i);
+    __m512i const words =
+        _mm512_mask_i64gather_epi64(_mm512_setzero_si512(),
+                                    0xFF,
+                                    _mm512_maskz_srli_epi64(0xFF, pos, 6),
+                                    data,
+                                    8);
+    __m512i const bits =
+        _mm512_maskz_srlv_epi64(0xFF,
+                                words,
+                                _mm512_and_si512(pos, offset_mask));
+    result |= uint64_t{_mm512_test_epi64_mask(bits, one)} << i;
+  }
+#endif
+  for (; i < count; ++i) {
+    if (i + GATHER_BITS_PREFETCH_DISTANCE < available) {
+      __builtin_prefetch(
+          data + (positions[i + GATHER_BITS_PREFETCH_DISTANCE] / 64));
+    }
+    size_t const pos = positions[i];
+    result |= ((data[pos / 64] >> (pos % 64)) & 1ULL) << i;
+  }
+  return result;
+}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -90,6 +90,13 @@ static_assert(sizeof(L12Type) == 8);
  * The order of the 12-bit integers should remain the same (as they occur
  * in the bit vector). This helps us to determine the correct block later
  * on. To this end, we have to split
+ *
+ * The L1-information is stored in the lowest 42 bits of the 44-bit field.
+ * The next bit marks L1-blocks that contain at least one uniform L2-block,
+ * i.e., an L2-block that contains only zeros or only ones. Queries can be
+ * answered in such L2-blocks without accessing the bit vector. The flag
+ * allows us to check for uniform L2-blocks only in L1-blocks that contain
+ * one.
  */
 struct BigL12Type {
   //! Constructor. Empty constructor required for \c tlx::SimpleVector.
@@ -99,16 +106,20 @@ struct BigL12Type {
    * \brief Constructor. Setting all values and packing the L2-block entries.
    * \param _l1 Value of the L1-block entry.
    * \param _l2 Values of the three L2-block entries ( as\c std::array).
+   * \param has_uniform_l2 Whether the L1-block contains a uniform L2-block.
    */
-  BigL12Type(uint64_t const _l1, std::array<uint16_t, 7>& _l2)
-      : data(((__uint128_t{0b111111111111} & _l2[6]) << 116) |
+  BigL12Type(uint64_t const _l1,
+             std::array<uint16_t, 7>& _l2,
+             bool const has_uniform_l2 = false)
+      : data((__uint128_t{has_uniform_l2} << 42) |
+             ((__uint128_t{0b111111111111} & _l2[6]) << 116) |
              ((__uint128_t{0b111111111111} & _l2[5]) << 104) |
              ((__uint128_t{0b111111111111} & _l2[4]) << 92) |
              ((__uint128_t{0b111111111111} & _l2[3]) << 80) |
              ((__uint128_t{0b111111111111} & _l2[2]) << 68) |
              ((__uint128_t{0b111111111111} & _l2[1]) << 56) |
              ((__uint128_t{0b111111111111} & _l2[0]) << 44) |
-             ((__uint128_t{0xFFFFFFFFFFF} & _l1))) {}
+             ((__uint128_t{0x3FFFFFFFFFF} & _l1))) {}
 
   /*!
    * \brief Access operator used to access the L2-block entries individually.
@@ -127,7 +138,25 @@ struct BigL12Type {
    * \returns L1-value of the L12-block.
    */
   inline uint64_t l1() const {
-    return uint64_t{0xFFFFFFFFFFF} & data;
+    return uint64_t{0x3FFFFFFFFFF} & data;
+  }
+
+  /*!
+   * \brief Set the L1-value of the L12-block, keeping all other values.
+   * \param l1 New L1-value of the L12-block.
+   */
+  inline void set_l1(uint64_t const l1) {
+    data = (data & ~__uint128_t{0x3FFFFFFFFFF}) |
+           (__uint128_t{0x3FFFFFFFFFF} & l1);
+  }
+
+  /*!
+   * \brief Check whether the L1-block contains a uniform L2-block.
+   * \return \c true if at least one L2-block of the L1-block contains only
+   * zeros or only ones.
+   */
+  inline bool has_uniform_l2() const {
+    return (data >> 42) & 1;
   }
 
   //! All data of the \c BigL12Type packed into 128 bits.
@@ -23,6 +23,9 @@
 #include <bit>
 #include <cstdint>
 #include <iostream>
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#endif
 
 namespace pasta {
 
@@ -64,6 +67,31 @@ template <size_t Words>
   return popcount;
 }
 
+#if defined(__AVX2__)
+/*!
+ * \brief Compute the popcount of each of the four 64-bit lanes of an AVX2
+ * register.
+ *
+ * AVX2 has no popcount instruction. Instead, the popcount of each nibble is
+ * looked up using a byte shuffle and the bytes of each lane are summed up.
+ *
+ * \param v Register containing four 64-bit words.
+ * \return Register containing the popcounts of the four 64-bit words.
+ */
+[[nodiscard]] inline __m256i popcount_epi64(__m256i const v) {
+  __m256i const lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                          1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3,
+                                          1, 2, 2, 3, 2, 3, 3, 4);
+  __m256i const low_mask = _mm256_set1_epi8(0x0f);
+  __m256i const lo = _mm256_and_si256(v, low_mask);
+  __m256i const hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  __m256i const counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                         _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+#endif
+
 } // namespace pasta
 
 /******************************************************************************/
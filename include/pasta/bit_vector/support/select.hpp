@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <bit>
+#include <cstdint>
 #if defined(__x86_64__)
 #  include <immintrin.h>
 #endif
@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace pasta {
+
+/*! \file */
+
+/*!
+ * \brief Copy 64-bit words using non-temporal (streaming) stores.
+ *
+ * The stores bypass the cache, i.e., copying large ranges does not evict
+ * the working set and the destination does not have to be read before it is
+ * written. Words are copied one at a time until the destination is aligned
+ * to the vector width, then 512 bits (AVX-512) or 256 bits (AVX2) are
+ * stored at once. Without SIMD support, this is a plain copy. Note that
+ * there are no bound checks and the ranges must not overlap.
+ *
+ * \param src Pointer to the first word that is copied.
+ * \param dst Pointer to the first word that is written.
+ * \param count Number of words that are copied.
+ */
+inline void stream_copy_words(uint64_t const* src,
+                              uint64_t* dst,
+                              size_t count) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+#  if defined(__AVX512F__)
+  constexpr size_t vector_words = 8;
+#  else
+  constexpr size_t vector_words = 4;
+#  endif
+  while (count > 0 &&
+         reinterpret_cast<uintptr_t>(dst) % (vector_words * 8) != 0) {
+    *dst++ = *src++;
+    --count;
+  }
+  for (; count >= vector_words; count -= vector_words) {
+#  if defined(__AVX512F__)
+    _mm512_stream_si512(reinterpret_cast<__m512i*>(dst),
+                        _mm512_loadu_si512(src));
+#  else
+    _mm256_stream_si256(
+        reinterpret_cast<__m256i*>(dst),
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src)));
+#  endif
+    src += vector_words;
+    dst += vector_words;
+  }
+  // Streaming stores are weakly ordered.
+  _mm_sfence();
+#endif
+  std::copy_n(src, count, dst);
+}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,253 @@
+/*******************************************************************************
+ * This file is part of pasta::bit_vector.
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "pasta/bit_vector/bit_vector.hpp"
+#include "pasta/bit_vector/support/flat_rank.hpp"
+#include "pasta/bit_vector/support/optimized_for.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <pasta/utils/debug_asserts.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace pasta {
+
+//! \addtogroup pasta_bit_vector_applications
+//! \{
+
+/*!
+ * \brief Wavelet matrix \cite ClaudeNP2015WaveletMatrix over small (at most
+ * byte-sized) alphabets supporting access and rank queries.
+ *
+ * Each level consists of a \ref BitVector with \ref FlatRank support. A rank
+ * or access query requires one rank query per level, i.e., \f$\lceil \lg
+ * \sigma\rceil\f$ rank queries, where \f$\sigma\f$ is the largest symbol
+ * plus one.
+ */
+class WaveletMatrix {
+  //! Type of the rank support used on each level.
+  using RankType = FlatRank<OptimizedFor::ONE_QUERIES, BitVector>;
+
+  //! Number of symbols in the sequence.
+  size_t size_ = 0;
+  //! Number of levels (bits per symbol).
+  size_t levels_ = 0;
+  //! Bit vectors of all levels.
+  std::vector<BitVector> bit_vectors_;
+  //! Rank support for all levels.
+  std::vector<RankType> ranks_;
+  //! Number of zeros on each level.
+  std::vector<size_t> zeros_;
+  //! Position of the first occurrence of each symbol on the last level.
+  std::vector<size_t> starts_;
+
+public:
+  //! Default constructor w/o parameter.
+  WaveletMatrix() = default;
+
+  /*!
+   * \brief Constructor. Creates the wavelet matrix for a sequence.
+   * \param text Sequence of symbols the wavelet matrix is created for.
+   */
+  WaveletMatrix(std::span<uint8_t const> const text) : size_(text.size()) {
+    uint8_t const max_symbol =
+        text.empty() ? 0 : *std::max_element(text.begin(), text.end());
+    levels_ = std::max<size_t>(1, std::bit_width(max_symbol));
+    bit_vectors_.reserve(levels_);
+    ranks_.reserve(levels_);
+    zeros_.resize(levels_);
+
+    std::vector<uint8_t> current(text.begin(), text.end());
+    std::vector<uint8_t> next(size_);
+    for (size_t l = 0; l < levels_; ++l) {
+      size_t const shift = levels_ - l - 1;
+      BitVector& bv = bit_vectors_.emplace_back(size_, false);
+      auto bv_data = bv.data();
+      size_t zeros = 0;
+      for (size_t i = 0; i < size_; ++i) {
+        uint64_t const bit = (current[i] >> shift) & 1ULL;
+        bv_data[i / 64] |= bit << (i % 64);
+        zeros += 1 - bit;
+      }
+      zeros_[l] = zeros;
+      // Stable partition of the symbols w.r.t. the current bit.
+      size_t zero_pos = 0;
+      size_t one_pos = zeros;
+      for (size_t i = 0; i < size_; ++i) {
+        if ((current[i] >> shift) & 1ULL) {
+          next[one_pos++] = current[i];
+        } else {
+          next[zero_pos++] = current[i];
+        }
+      }
+      std::swap(current, next);
+      ranks_.emplace_back(bv);
+    }
+
+    starts_.resize(1ULL << levels_);
+    for (size_t c = 0; c < starts_.size(); ++c) {
+      starts_[c] = descend(static_cast<uint8_t>(c), 0);
+    }
+  }
+
+  //! Default move constructor.
+  WaveletMatrix(WaveletMatrix&&) = default;
+
+  //! Default move assignment.
+  WaveletMatrix& operator=(WaveletMatrix&&) = default;
+
+  /*!
+   * \brief Access the symbol at a position.
+   * \param index Position of the symbol.
+   * \return The symbol at position \c index.
+   */
+  [[nodiscard("access computed but not used")]] uint8_t
+  operator[](size_t const index) const {
+    return access_and_rank(index).first;
+  }
+
+  /*!
+   * \brief Computes the number of occurrences of a symbol before a position.
+   * \param symbol Symbol whose occurrences are counted.
+   * \param index Position the occurrences are counted before.
+   * \return Number of occurrences of \c symbol before position \c index.
+   */
+  [[nodiscard("rank computed but not used")]] size_t
+  rank(uint8_t const symbol, size_t const index) const {
+    PASTA_ASSERT(symbol < starts_.size(), "Symbol not in alphabet.");
+    return descend(symbol, index) - starts_[symbol];
+  }
+
+  /*!
+   * \brief Access the symbol at a position and compute its rank.
+   *
+   * This requires the same number of rank queries as an access query.
+   * \param index Position of the symbol.
+   * \return Pair containing the symbol \c c at position \c index and the
+   * number of occurrences of \c c before position \c index.
+   */
+  [[nodiscard("access and rank computed but not used")]] std::pair<uint8_t,
+                                                                   size_t>
+  access_and_rank(size_t index) const {
+    uint8_t symbol = 0;
+    for (size_t l = 0; l < levels_; ++l) {
+      size_t const ones = ranks_[l].rank1(index);
+      symbol <<= 1;
+      if (bit_vectors_[l][index]) {
+        symbol |= 1;
+        index = zeros_[l] + ones;
+      } else {
+        index -= ones;
+      }
+    }
+    return {symbol, index - starts_[symbol]};
+  }
+
+  /*!
+   * \brief Computes multiple rank queries at once.
+   *
+   * The queries are answered level by level, i.e., all rank queries on one
+   * level are issued before the next level is considered. Since the rank
+   * queries of different queries on the same level are independent, their
+   * cache misses can overlap.
+   *
+   * \param symbols Symbols whose occurrences are counted.
+   * \param positions Positions the occurrences are counted before. The
+   * results are written to this span.
+   */
+  void rank_batch(std::span<uint8_t const> const symbols,
+                  std::span<size_t> const positions) const {
+    PASTA_ASSERT(symbols.size() == positions.size(),
+                 "Number of symbols and positions must match.");
+    for (size_t l = 0; l < levels_; ++l) {
+      size_t const shift = levels_ - l - 1;
+      for (size_t q = 0; q < positions.size(); ++q) {
+        size_t const ones = ranks_[l].rank1(positions[q]);
+        positions[q] =
+            ((symbols[q] >> shift) & 1) ? zeros_[l] + ones : positions[q] - ones;
+      }
+    }
+    for (size_t q = 0; q < positions.size(); ++q) {
+      positions[q] -= starts_[symbols[q]];
+    }
+  }
+
+  /*!
+   * \brief Get the number of symbols.
+   * \return Number of symbols in the sequence.
+   */
+  [[nodiscard("size computed but not used")]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /*!
+   * \brief Get the number of levels.
+   * \return Number of levels, i.e., bits per symbol.
+   */
+  [[nodiscard("levels computed but not used")]] size_t
+  levels() const noexcept {
+    return levels_;
+  }
+
+  /*!
+   * \brief Estimate for the space usage.
+   * \return Number of bytes used by this data structure.
+   */
+  [[nodiscard("space usage computed but not used")]] size_t
+  space_usage() const {
+    size_t result = sizeof(*this) + (zeros_.size() + starts_.size()) *
+                                        sizeof(size_t);
+    for (size_t l = 0; l < levels_; ++l) {
+      result += bit_vectors_[l].space_usage() + ranks_[l].space_usage();
+    }
+    return result;
+  }
+
+private:
+  /*!
+   * \brief Follow the path of a symbol from the first to the last level.
+   * \param symbol Symbol whose path is followed.
+   * \param index Position on the first level.
+   * \return Position on the last level.
+   */
+  size_t descend(uint8_t const symbol, size_t index) const {
+    for (size_t l = 0; l < levels_; ++l) {
+      size_t const ones = ranks_[l].rank1(index);
+      if ((symbol >> (levels_ - l - 1)) & 1) {
+        index = zeros_[l] + ones;
+      } else {
+        index -= ones;
+      }
+    }
+    return index;
+  }
+}; // class WaveletMatrix
+
+//! \}
+
+} // namespace pasta
+
+/******************************************************************************/
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * tests/bit_vector/bit_code_array_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <pasta/bit_vector/bit_code_array.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void run_test(size_t const code_bits, size_t const num_codes) {
+  std::mt19937_64 gen(code_bits + num_codes);
+  size_t const words = (code_bits + 63) / 64;
+  uint64_t const mask =
+      (code_bits % 64 == 0) ? ~0ULL : (1ULL << (code_bits % 64)) - 1;
+
+  // Codes are derived from few centers, such that there are many ties and
+  // small distances.
+  std::vector<uint64_t> centers(4 * words);
+  for (auto& word : centers) {
+    word = gen();
+  }
+  std::vector<uint64_t> codes(num_codes * words);
+  pasta::BitCodeArray bca(code_bits);
+  for (size_t i = 0; i < num_codes; ++i) {
+    size_t const center = gen() % 4;
+    for (size_t j = 0; j < words; ++j) {
+      codes[(i * words) + j] =
+          centers[(center * words) + j] ^ (gen() & gen() & gen() & gen());
+    }
+    // Garbage after the end of the code must be ignored.
+    bca.push_back(std::span{codes.data() + (i * words), words});
+    codes[(i * words) + words - 1] &= mask;
+  }
+  die_unequal(num_codes, bca.size());
+  die_unequal(words, bca.code_words());
+  for (size_t i = 0; i < num_codes; ++i) {
+    for (size_t j = 0; j < words; ++j) {
+      die_unequal(codes[(i * words) + j], bca.word(i, j));
+    }
+  }
+
+  size_t const num_queries = 11;
+  std::vector<uint64_t> queries(num_queries * words);
+  for (size_t q = 0; q < num_queries; ++q) {
+    size_t const center = gen() % 4;
+    for (size_t j = 0; j < words; ++j) {
+      queries[(q * words) + j] =
+          centers[(center * words) + j] ^ (gen() & gen() & gen());
+    }
+  }
+
+  size_t const radius = code_bits / 8;
+  for (size_t const k : {0, 1, 5, 100}) {
+    auto const batch_top = bca.top_k_batch(queries, k);
+    auto const batch_radius = bca.within_radius_batch(queries, radius);
+    die_unequal(num_queries, batch_top.size());
+    for (size_t q = 0; q < num_queries; ++q) {
+      std::span<uint64_t const> const query{queries.data() + (q * words),
+                                            words};
+      std::vector<pasta::BitCodeArray::Neighbor> expected(num_codes);
+      std::vector<size_t> expected_radius;
+      for (size_t i = 0; i < num_codes; ++i) {
+        size_t distance = 0;
+        for (size_t j = 0; j < words; ++j) {
+          uint64_t const query_word =
+              (j + 1 == words) ? (query[j] & mask) : query[j];
+          distance += std::popcount(codes[(i * words) + j] ^ query_word);
+        }
+        die_unequal(distance, bca.hamming_distance(i, query));
+        expected[i] = {i, distance};
+        if (distance <= radius) {
+          expected_radius.push_back(i);
+        }
+      }
+      std::sort(expected.begin(), expected.end());
+      expected.resize(std::min(k, num_codes));
+
+      die_unless(expected == bca.top_k(query, k));
+      die_unless(expected == batch_top[q]);
+      die_unless(expected_radius == bca.within_radius(query, radius));
+      die_unless(expected_radius == batch_radius[q]);
+    }
+  }
+}
+
+int32_t main() {
+  for (size_t const code_bits : {1, 64, 100, 256, 1024}) {
+    for (size_t const num_codes : {0, 1, 7, 8, 9, 1000, 5003}) {
+      run_test(code_bits, num_codes);
+    }
+  }
+
+  // Codes from bit vectors.
+  pasta::BitCodeArray bca(130, 2);
+  pasta::BitVector a(130, false);
+  pasta::BitVector b(130, true);
+  bca.push_back(a);
+  bca.push_back(b);
+  std::vector<uint64_t> const query = {~0ULL, 0ULL, ~0ULL};
+  auto const result = bca.top_k(query, 2);
+  die_unequal(2ULL, result.size());
+  die_unequal(1ULL, result[0].index);
+  die_unequal(64ULL, result[0].distance);
+  die_unequal(0ULL, result[1].index);
+  die_unequal(66ULL, result[1].distance);
+  return 0;
+}
+
+/******************************************************************************/
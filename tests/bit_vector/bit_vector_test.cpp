@@ -18,8 +18,14 @@
  *
  ******************************************************************************/
 
+#include <bit>
+#include <filesystem>
 #include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/support/flat_rank_select.hpp>
+#include <random>
+#include <string>
 #include <tlx/die.hpp>
+#include <unistd.h>
 #include <vector>
 
 static constexpr size_t FIB_MAX = 94; // largest 64 bit Fibonacci number
@@ -344,10 +350,426 @@ void resize_test() {
   }
 }
 
+void find_test() {
+  std::mt19937 gen(42);
+  for (size_t const N : {1, 63, 64, 65, 511, 512, 513, 4096, 100'003}) {
+    // Sparse, dense, and long runs of equal bits.
+    for (size_t const density : {0, 1, 50, 99, 100}) {
+      pasta::BitVector bv(N);
+      for (size_t i = 0; i < N; ++i) {
+        bool const in_run = ((i / 1000) % 3) == 1;
+        bv[i] = in_run ? (density >= 50) : (gen() % 100 < density);
+      }
+
+      std::vector<size_t> next1(N + 1, N);
+      std::vector<size_t> next0(N + 1, N);
+      for (size_t i = N; i > 0; --i) {
+        next1[i - 1] = bv[i - 1] ? i - 1 : next1[i];
+        next0[i - 1] = bv[i - 1] ? next0[i] : i - 1;
+      }
+      std::vector<size_t> prev1(N + 1, N);
+      std::vector<size_t> prev0(N + 1, N);
+      for (size_t i = 1; i <= N; ++i) {
+        prev1[i] = bv[i - 1] ? i - 1 : prev1[i - 1];
+        prev0[i] = bv[i - 1] ? prev0[i - 1] : i - 1;
+      }
+
+      die_unequal(next1[0], bv.find_first1());
+      die_unequal(next0[0], bv.find_first0());
+      for (size_t i = 0; i < N; ++i) {
+        die_unequal(next1[i + 1], bv.find_next1(i));
+        die_unequal(next0[i + 1], bv.find_next0(i));
+        die_unequal(prev1[i], bv.find_prev1(i));
+        die_unequal(prev0[i], bv.find_prev0(i));
+      }
+      die_unequal(prev1[N], bv.find_prev1(N));
+      die_unequal(prev0[N], bv.find_prev0(N));
+      // Positions at or after the end (including the largest one).
+      for (size_t const index : {N, N + 1, ~size_t{0}}) {
+        die_unequal(N, bv.find_next1(index));
+        die_unequal(N, bv.find_next0(index));
+      }
+    }
+  }
+}
+
+void run_test() {
+  std::mt19937 gen(42);
+  for (size_t const N : {1, 63, 64, 65, 511, 512, 513, 4096, 100'003}) {
+    for (size_t const density : {0, 1, 50, 90, 99, 100}) {
+      pasta::BitVector bv(N);
+      for (size_t i = 0; i < N; ++i) {
+        bool const in_run = ((i / 1000) % 3) == 1;
+        bv[i] = in_run ? (density >= 50) : (gen() % 100 < density);
+      }
+
+      // Length of the run of ones/zeros starting at each position.
+      std::vector<size_t> ones(N + 1, 0);
+      std::vector<size_t> zeros(N + 1, 0);
+      for (size_t i = N; i > 0; --i) {
+        ones[i - 1] = bv[i - 1] ? ones[i] + 1 : 0;
+        zeros[i - 1] = bv[i - 1] ? 0 : zeros[i] + 1;
+      }
+      for (size_t const k : {1, 2, 3, 7, 20, 63, 64, 65, 100, 130, 1000}) {
+        std::vector<size_t> one_run(N + 1, N);
+        std::vector<size_t> zero_run(N + 1, N);
+        for (size_t i = N; i > 0; --i) {
+          one_run[i - 1] = (ones[i - 1] >= k) ? i - 1 : one_run[i];
+          zero_run[i - 1] = (zeros[i - 1] >= k) ? i - 1 : zero_run[i];
+        }
+        for (size_t i = 0; i <= N; i += 1 + (gen() % 13)) {
+          die_unequal(one_run[i], bv.find_one_run(k, i));
+          die_unequal(zero_run[i], bv.find_zero_run(k, i));
+        }
+      }
+      die_unequal(0ULL, bv.find_one_run(0, 0));
+      die_unequal(N, bv.find_one_run(N + 1, 0));
+
+      size_t pos = 0;
+      for (auto const& run : bv.runs()) {
+        die_unequal(pos, run.start);
+        die_unless(run.length > 0);
+        die_unequal(bool{bv[pos]}, run.value);
+        die_unequal(run.value ? ones[pos] : zeros[pos], run.length);
+        pos += run.length;
+      }
+      die_unequal(N, pos);
+    }
+  }
+}
+
+void pattern_test() {
+  std::mt19937_64 gen(42);
+  for (size_t const N : {1, 63, 64, 65, 127, 128, 129, 4096, 100'003}) {
+    pasta::BitVector bv(N);
+    for (size_t i = 0; i < N; ++i) {
+      // Few distinct bits, such that long patterns occur, too.
+      bv[i] = ((i / 7) % 5 == 0) || (gen() % 64 == 0);
+    }
+    for (size_t const length : {1, 2, 5, 17, 63, 64, 65}) {
+      for (size_t query = 0; query < 4; ++query) {
+        uint64_t pattern = gen();
+        // Take the pattern from the bit vector to obtain occurrences.
+        if (query > 0 && length <= N) {
+          size_t const start = gen() % (N - length + 1);
+          pattern = 0;
+          for (size_t j = 0; j < std::min<size_t>(length, 64); ++j) {
+            pattern |= uint64_t{bv[start + j]} << j;
+          }
+        }
+        std::vector<size_t> expected;
+        for (size_t i = 0; length <= 64 && i + length <= N; ++i) {
+          bool match = true;
+          for (size_t j = 0; j < length && match; ++j) {
+            match = (bool{bv[i + j]} == (((pattern >> j) & 1ULL) == 1ULL));
+          }
+          if (match) {
+            expected.push_back(i);
+          }
+        }
+        if (length > 64) {
+          continue;
+        }
+        die_unless(expected == bv.find_pattern(pattern, length));
+        die_unless(expected == bv.find_pattern_parallel(pattern, length));
+      }
+    }
+    die_unless(bv.find_pattern(0, 0).empty());
+  }
+}
+
+void get_bits_test() {
+  std::mt19937_64 gen(42);
+  pasta::BitVector bv(100'003);
+  for (size_t i = 0; i < bv.size(); ++i) {
+    bv[i] = (gen() % 3 == 0);
+  }
+  for (size_t const count : {0, 1, 7, 8, 63, 64, 65, 1000, 65'537}) {
+    std::vector<size_t> positions(count);
+    for (auto& pos : positions) {
+      pos = gen() % bv.size();
+    }
+
+    std::vector<uint8_t> bytes(count, 2);
+    std::vector<uint8_t> bytes_parallel(count, 2);
+    bv.get_bits(positions, bytes);
+    bv.get_bits_parallel(positions, bytes_parallel);
+    // Bits after the last position must not be changed.
+    pasta::BitVector bits(count + 10, true);
+    pasta::BitVector bits_parallel(count + 10, true);
+    bv.get_bits(positions, bits);
+    bv.get_bits_parallel(positions, bits_parallel);
+    for (size_t i = 0; i < count; ++i) {
+      bool const expected = bv[positions[i]];
+      die_unequal(uint8_t{expected}, bytes[i]);
+      die_unequal(uint8_t{expected}, bytes_parallel[i]);
+      die_unequal(expected, bool{bits[i]});
+      die_unequal(expected, bool{bits_parallel[i]});
+    }
+    for (size_t i = count; i < bits.size(); ++i) {
+      die_unless(bits[i]);
+      die_unless(bits_parallel[i]);
+    }
+  }
+}
+
+void copy_test() {
+  std::mt19937_64 gen(42);
+  auto const check_equal = [](pasta::BitVector const& a,
+                              pasta::BitVector const& b) {
+    die_unequal(a.size(), b.size());
+    die_unless(a.data().data() != b.data().data());
+    for (size_t i = 0; i < a.size(); ++i) {
+      die_unequal(bool{a[i]}, bool{b[i]});
+    }
+  };
+  for (size_t const N : {0, 1, 63, 64, 65, 4096, 1'000'007}) {
+    pasta::BitVector bv(N);
+    for (size_t i = 0; i < N; ++i) {
+      bv[i] = (gen() % 2 == 0);
+    }
+
+    pasta::BitVector copy(bv);
+    check_equal(bv, copy);
+    for (size_t const threads : {0, 1, 3}) {
+      check_equal(bv, bv.clone(threads));
+    }
+
+    // Copy assignment reuses the allocation if the sizes match.
+    pasta::BitVector same_size(N, true);
+    uint64_t const* const data = same_size.data().data();
+    same_size = bv;
+    check_equal(bv, same_size);
+    die_unless(data == same_size.data().data());
+    pasta::BitVector other_size(N + 1'000, true);
+    other_size = bv;
+    check_equal(bv, other_size);
+    auto& self = other_size;
+    other_size = self;
+    check_equal(bv, other_size);
+
+    // The copies are independent of the original.
+    if (N > 0) {
+      copy[N - 1] = !bv[N - 1];
+      die_unequal(!bool{bv[N - 1]}, bool{copy[N - 1]});
+    }
+  }
+
+  // Default-constructed bit vectors can be copied, too.
+  pasta::BitVector const empty;
+  pasta::BitVector copy(empty);
+  die_unequal(0ULL, copy.size());
+  die_unequal(0ULL, copy.data()[0]);
+  for (size_t const threads : {0, 1, 3}) {
+    pasta::BitVector const clone = empty.clone(threads);
+    die_unequal(0ULL, clone.size());
+    die_unequal(0ULL, clone.data()[0]);
+  }
+  for (size_t const N : {0, 1'000}) {
+    pasta::BitVector assigned(N, true);
+    assigned = empty;
+    die_unequal(0ULL, assigned.size());
+    die_unequal(0ULL, assigned.data()[0]);
+  }
+}
+
+void dirty_regions_test() {
+  constexpr size_t R = pasta::BitVector::DIRTY_REGION_BITS;
+  auto const is_dirty = [](pasta::BitVector const& bv, size_t const region) {
+    auto const dirty = bv.dirty_regions();
+    return ((dirty[region / 64] >> (region % 64)) & 1ULL) == 1ULL;
+  };
+  auto const num_dirty = [](pasta::BitVector const& bv) {
+    size_t result = 0;
+    for (uint64_t const word : bv.dirty_regions()) {
+      result += std::popcount(word);
+    }
+    return result;
+  };
+
+  size_t const N = 100 * R + 17;
+  pasta::BitVector bv(N, false);
+  die_unless(!bv.tracks_dirty_regions());
+  die_unequal(0ULL, bv.dirty_regions().size());
+  bv[5] = true;
+
+  bv.track_dirty_regions();
+  die_unless(bv.tracks_dirty_regions());
+  die_unequal(0ULL, num_dirty(bv));
+
+  // Writes through the access operator and the iterator.
+  bv[3 * R] = true;
+  bv[3 * R + 1] = false;
+  bv[70 * R - 1] = true;
+  bv[N - 1] = true;
+  *(bv.begin()) = false;
+  die_unequal(4ULL, num_dirty(bv));
+  die_unless(is_dirty(bv, 0) && is_dirty(bv, 3) && is_dirty(bv, 69));
+  die_unless(is_dirty(bv, 100));
+  die_unless(bool{bv[5]} && !bool{bv[0]});
+
+  // Reading does not mark regions.
+  bv.clear_dirty_regions();
+  for (size_t i = 0; i < N; i += 97) {
+    [[maybe_unused]] bool const bit = bv[i];
+  }
+  die_unequal(0ULL, num_dirty(bv));
+
+  // Manually marked ranges.
+  bv.mark_dirty(R - 1, 2 * R + 1);
+  die_unequal(3ULL, num_dirty(bv));
+  die_unless(is_dirty(bv, 0) && is_dirty(bv, 1) && is_dirty(bv, 2));
+  bv.mark_dirty(4 * R, 4 * R);
+  die_unequal(3ULL, num_dirty(bv));
+
+  // Copies keep the marks, growing marks all new regions.
+  pasta::BitVector copy(bv);
+  die_unless(copy.tracks_dirty_regions());
+  die_unequal(3ULL, num_dirty(copy));
+  copy[50 * R] = true;
+  die_unequal(3ULL, num_dirty(bv));
+  die_unequal(4ULL, num_dirty(copy.clone()));
+  copy.clear_dirty_regions();
+  copy.resize(N + (2 * R), true);
+  die_unequal(3ULL, num_dirty(copy));
+  die_unless(is_dirty(copy, 100) && is_dirty(copy, 102));
+
+  // Gathering bits into a bit vector marks the written prefix.
+  std::vector<size_t> const positions(R + 1, 3 * R);
+  copy.clear_dirty_regions();
+  bv.get_bits(positions, copy);
+  die_unequal(2ULL, num_dirty(copy));
+  die_unless(bool{copy[R]});
+
+  bv.track_dirty_regions(false);
+  die_unless(!bv.tracks_dirty_regions());
+  bv[0] = true;
+  die_unequal(0ULL, bv.dirty_regions().size());
+}
+
+void file_backed_test() {
+  std::string const path = (std::filesystem::temp_directory_path() /
+                             ("pasta_bit_vector_test_" +
+                              std::to_string(getpid())))
+                                .string();
+  std::filesystem::remove(path);
+  die_unless(!pasta::BitVector::open_file(path).has_value());
+
+  std::mt19937_64 gen(42);
+  size_t const N = 100'003;
+  std::vector<bool> bits(N);
+  {
+    auto bv = pasta::BitVector::create_file(path, N, true);
+    die_unless(bv.has_value());
+    die_unless(bv->is_file_backed());
+    // Files are created exclusively.
+    die_unless(!pasta::BitVector::create_file(path, N).has_value());
+    die_unequal(N, bv->size());
+    for (size_t i = 0; i < N; ++i) {
+      die_unless(bool{(*bv)[i]});
+      bits[i] = (gen() % 3 == 0);
+      (*bv)[i] = bits[i];
+    }
+    die_unless(bv->advise(pasta::AccessPattern::RANDOM));
+    die_unless(bv->flush(1'000, 5'000));
+    die_unless(bv->flush(true));
+
+    // Rank and select support works on file-backed bit vectors.
+    pasta::FlatRankSelect<> rs(*bv);
+    size_t rank1 = 0;
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(rank1, rs.rank1(i));
+      if (bits[i]) {
+        die_unequal(i, rs.select1(++rank1));
+      }
+    }
+
+    // Copies are stored in anonymous memory.
+    pasta::BitVector const copy = *bv;
+    die_unless(!copy.is_file_backed());
+    die_unless(!bv->clone().is_file_backed());
+    die_unequal(bool{copy[N - 1]}, bits[N - 1]);
+  }
+
+  // The bits survive reopening, growing remaps the file.
+  {
+    auto bv = pasta::BitVector::open_file(path);
+    die_unless(bv.has_value());
+    die_unequal(N, bv->size());
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(bits[i], bool{(*bv)[i]});
+    }
+    bv->resize(10 * N, true);
+    bits.resize(10 * N, true);
+    bv->advise(pasta::AccessPattern::SEQUENTIAL);
+    for (size_t i = 0; i < 10 * N; ++i) {
+      die_unequal(bits[i], bool{(*bv)[i]});
+    }
+    bv->resize(N / 2);
+    bits.resize(N / 2);
+    die_unless(bv->flush());
+
+    // Moving keeps the file-backed storage.
+    pasta::BitVector moved = std::move(*bv);
+    die_unless(moved.is_file_backed());
+    die_unequal(N / 2, moved.size());
+    moved[N / 2 - 1] = !bits[N / 2 - 1];
+    bits[N / 2 - 1] = !bits[N / 2 - 1];
+  }
+  {
+    auto bv = pasta::BitVector::open_file(path);
+    die_unless(bv.has_value());
+    die_unequal(N / 2, bv->size());
+    for (size_t i = 0; i < N / 2; ++i) {
+      die_unequal(bits[i], bool{(*bv)[i]});
+    }
+  }
+  // Files can be opened read-only.
+  {
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read);
+    auto bv = pasta::BitVector::open_file(path, true);
+    die_unless(bv.has_value());
+    die_unequal(N / 2, bv->size());
+    for (size_t i = 0; i < N / 2; ++i) {
+      die_unequal(bits[i], bool{(*bv)[i]});
+    }
+    std::filesystem::permissions(path,
+                                 std::filesystem::perms::owner_read |
+                                     std::filesystem::perms::owner_write);
+  }
+
+  // Patterns crossing word boundaries are found in file-backed bit vectors.
+  {
+    auto bv = pasta::BitVector::create_file(path + "_pattern", 256);
+    die_unless(bv.has_value());
+    pasta::BitVector in_memory(256, false);
+    for (size_t i = 62; i < 66; ++i) {
+      (*bv)[i] = true;
+      in_memory[i] = true;
+    }
+    die_unequal(1ULL, in_memory.find_pattern(0b1111, 4).size());
+    die_unless(bv->find_pattern(0b1111, 4) ==
+               in_memory.find_pattern(0b1111, 4));
+    std::filesystem::remove(path + "_pattern");
+  }
+
+  // Files not containing a bit vector are rejected.
+  std::filesystem::resize_file(path, 1'000);
+  die_unless(!pasta::BitVector::open_file(path).has_value());
+  std::filesystem::remove(path);
+}
+
 int32_t main() {
   direct_access_test();
   iterator_test();
   resize_test();
+  find_test();
+  run_test();
+  pattern_test();
+  get_bits_test();
+  copy_test();
+  dirty_regions_test();
+  file_backed_test();
 
   return 0;
 }
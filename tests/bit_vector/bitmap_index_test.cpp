@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * tests/bit_vector/bitmap_index_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <pasta/bit_vector/bitmap_index.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void run_test(std::vector<uint32_t> const& column,
+              size_t const cardinality,
+              bool const range_encoded,
+              bool const compress_sparse) {
+  pasta::BitmapIndex index(column, cardinality, range_encoded, compress_sparse);
+  die_unequal(column.size(), index.size());
+  size_t const c = index.cardinality();
+  std::mt19937_64 gen(column.size() + c);
+
+  auto const check = [&](pasta::BitVector const& bv,
+                         size_t const min_value,
+                         size_t const max_value) {
+    die_unequal(column.size(), bv.size());
+    for (size_t row = 0; row < column.size(); ++row) {
+      bool const expected =
+          min_value <= column[row] && column[row] <= max_value;
+      die_unequal(expected, bool{bv[row]});
+    }
+  };
+  auto const count = [&](size_t const min_value,
+                         size_t const max_value,
+                         size_t const row_end) {
+    size_t result = 0;
+    for (size_t row = 0; row < row_end; ++row) {
+      result += (min_value <= column[row] && column[row] <= max_value) ? 1 : 0;
+    }
+    return result;
+  };
+
+  for (size_t v = 0; v <= c; v += 1 + (c / 16)) {
+    check(index.equal(v), v, v);
+    die_unequal(count(v, v, column.size()), index.count_equal(v));
+    size_t const row_end = column.empty() ? 0 : gen() % column.size();
+    die_unequal(count(v, v, row_end), index.count_equal(v, row_end));
+    if (compress_sparse && v < c) {
+      die_unequal(count(v, v, column.size()) < (column.size() / 64) + 1,
+                  index.is_compressed(v));
+    }
+  }
+  for (size_t q = 0; q < 20; ++q) {
+    size_t const min_value = gen() % (c + 1);
+    size_t const max_value = min_value + (gen() % (c + 2));
+    check(index.range(min_value, max_value), min_value, max_value);
+    die_unequal(count(min_value, max_value, column.size()),
+                index.count_range(min_value, max_value));
+    size_t const row_end = column.empty() ? 0 : gen() % column.size();
+    die_unequal(count(min_value, max_value, row_end),
+                index.count_range(min_value, max_value, row_end));
+  }
+  check(index.range(0, c), 0, c);
+  check(index.range(2, 1), 2, 1);
+}
+
+int32_t main() {
+  std::mt19937_64 gen(42);
+  for (size_t const n : {0, 1, 63, 64, 65, 1000, 100'000}) {
+    for (size_t const c : {1, 2, 7, 100, 1000}) {
+      // Skewed values, such that some bitmaps are dense and others sparse.
+      std::geometric_distribution<uint32_t> skewed(std::min(0.5, 10.0 / c));
+      std::vector<uint32_t> column(n);
+      for (auto& value : column) {
+        value = std::min<uint32_t>(skewed(gen), c - 1);
+      }
+      for (bool const range_encoded : {false, true}) {
+        for (bool const compress_sparse : {false, true}) {
+          run_test(column, 0, range_encoded, compress_sparse);
+          run_test(column, c, range_encoded, compress_sparse);
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/******************************************************************************/
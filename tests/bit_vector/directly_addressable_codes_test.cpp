@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * tests/bit_vector/directly_addressable_codes_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <pasta/bit_vector/directly_addressable_codes.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+template <size_t ChunkBits>
+void run_test(std::vector<uint64_t> const& values) {
+  pasta::DirectlyAddressableCodes<ChunkBits> dac(values);
+  die_unequal(values.size(), dac.size());
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    die_unequal(values[i], dac[i]);
+  }
+
+  std::vector<uint64_t> decoded(values.size());
+  dac.decode(decoded);
+  die_unless(decoded == values);
+
+  for (size_t begin = 0; begin < values.size(); begin += 997) {
+    size_t const length = std::min<size_t>(3000, values.size() - begin);
+    std::vector<uint64_t> part(length);
+    dac.decode(begin, part);
+    for (size_t i = 0; i < length; ++i) {
+      die_unequal(values[begin + i], part[i]);
+    }
+  }
+}
+
+int32_t main() {
+  std::mt19937_64 gen(42);
+  for (size_t const n : {0, 1, 100, 10'000, 250'000}) {
+    // Mostly small values with a few large outliers.
+    std::vector<uint64_t> values(n);
+    std::geometric_distribution<uint64_t> small(0.05);
+    for (size_t i = 0; i < n; ++i) {
+      values[i] = (gen() % 100 == 0) ? gen() >> (gen() % 64) : small(gen);
+    }
+    if (n > 0) {
+      values[n / 2] = ~0ULL;
+    }
+    run_test<1>(values);
+    run_test<3>(values);
+    run_test<8>(values);
+    run_test<13>(values);
+    run_test<32>(values);
+    run_test<63>(values);
+
+    // Only small values result in a single level.
+    std::vector<uint64_t> tiny(n, 7);
+    pasta::DirectlyAddressableCodes<8> dac(tiny);
+    die_unequal(1ULL, dac.levels());
+    run_test<8>(tiny);
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * tests/bit_vector/distributed_bit_vector_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+
+#include <cstdint>
+#include <mpi.h>
+#include <pasta/bit_vector/distributed_bit_vector.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void run_test(size_t const N, size_t const density, bool const empty_parts) {
+  int32_t rank = 0;
+  int32_t num_processes = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
+
+  // All processes generate the same global bit vector as reference.
+  std::mt19937_64 gen(N + density);
+  std::vector<bool> bits(N);
+  std::vector<size_t> prefix(N + 1, 0);
+  for (size_t i = 0; i < N; ++i) {
+    bits[i] = (gen() % 100 < density);
+    prefix[i + 1] = prefix[i] + (bits[i] ? 1 : 0);
+  }
+  // Uneven parts, every other part is empty if requested.
+  std::vector<size_t> borders(num_processes + 1, N);
+  borders[0] = 0;
+  for (int32_t p = 1; p < num_processes; ++p) {
+    borders[p] = (empty_parts && p % 2 == 1) ?
+                     borders[p - 1] :
+                     std::min(N, borders[p - 1] + (gen() % (N + 1)));
+  }
+
+  pasta::BitVector local(borders[rank + 1] - borders[rank], false);
+  for (size_t i = borders[rank]; i < borders[rank + 1]; ++i) {
+    local[i - borders[rank]] = bits[i];
+  }
+  pasta::DistributedBitVector dbv(std::move(local), MPI_COMM_WORLD);
+  die_unequal(N, dbv.size());
+  die_unequal(prefix[N], dbv.ones());
+  die_unequal(borders[rank], dbv.local_offset());
+
+  // Each process asks different queries.
+  std::mt19937_64 query_gen(rank);
+  size_t const num_queries = 1000 * static_cast<size_t>(rank % 3);
+  std::vector<size_t> positions(num_queries);
+  for (auto& position : positions) {
+    position = query_gen() % (N + 1);
+  }
+  auto const rank1 = dbv.rank1_batch(positions);
+  auto const rank0 = dbv.rank0_batch(positions);
+  for (size_t i = 0; i < num_queries; ++i) {
+    die_unequal(prefix[positions[i]], rank1[i]);
+    die_unequal(positions[i] - prefix[positions[i]], rank0[i]);
+  }
+
+  size_t const ones = prefix[N];
+  size_t const zeros = N - ones;
+  std::vector<size_t> ranks1(ones > 0 ? num_queries : 0);
+  for (auto& r : ranks1) {
+    r = 1 + (query_gen() % ones);
+  }
+  std::vector<size_t> ranks0(zeros > 0 ? num_queries : 0);
+  for (auto& r : ranks0) {
+    r = 1 + (query_gen() % zeros);
+  }
+  auto const select1 = dbv.select1_batch(ranks1);
+  auto const select0 = dbv.select0_batch(ranks0);
+  for (size_t i = 0; i < ranks1.size(); ++i) {
+    die_unless(bits[select1[i]]);
+    die_unequal(ranks1[i], prefix[select1[i] + 1]);
+  }
+  for (size_t i = 0; i < ranks0.size(); ++i) {
+    die_unless(!bits[select0[i]]);
+    die_unequal(ranks0[i], select0[i] + 1 - prefix[select0[i] + 1]);
+  }
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  for (size_t const N : {1, 1000, 100'003}) {
+    for (size_t const density : {0, 10, 50, 100}) {
+      run_test(N, density, false);
+      run_test(N, density, true);
+    }
+  }
+  MPI_Finalize();
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * tests/bit_vector/external_flat_rank_select_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/external_flat_rank_select.hpp>
+#include <pasta/bit_vector/support/flat_rank_select.hpp>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tlx/die.hpp>
+#include <unistd.h>
+#include <vector>
+
+template <pasta::OptimizedFor optimized_for>
+void run_test(size_t const N,
+              size_t const cache_size,
+              std::string const& path) {
+  std::mt19937_64 gen(N);
+  std::vector<bool> bits(N);
+  {
+    auto bv = pasta::BitVector::create_file(path, N);
+    die_unless(bv.has_value());
+    // Mix of L2-blocks containing only zeros, only ones, or random bits.
+    for (size_t begin = 0; begin < N; begin += 512) {
+      size_t const type = gen() % 4;
+      for (size_t i = begin; i < std::min(N, begin + 512); ++i) {
+        bits[i] = (type == 0) ? false :
+                                ((type == 1) ? true : (gen() % 3 == 0));
+        (*bv)[i] = bits[i];
+      }
+    }
+    die_unless(bv->flush());
+  }
+  // Only read permission is required and the file is not modified.
+  std::filesystem::permissions(path, std::filesystem::perms::owner_read);
+  auto const last_write_time =
+      std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+  std::filesystem::last_write_time(path, last_write_time);
+
+  auto ext = pasta::ExternalFlatRankSelect<optimized_for>::open_file(
+      path,
+      cache_size);
+  die_unless(ext.has_value());
+  die_unequal(N, ext->size());
+
+  std::vector<size_t> rank1(N + 1, 0);
+  std::vector<size_t> ones;
+  std::vector<size_t> zeros;
+  for (size_t i = 0; i < N; ++i) {
+    rank1[i + 1] = rank1[i] + bits[i];
+    (bits[i] ? ones : zeros).push_back(i);
+  }
+
+  for (size_t i = 0; i <= N; i += 1 + (gen() % 101)) {
+    die_unequal(rank1[i], ext->rank1(i));
+    die_unequal(i - rank1[i], ext->rank0(i));
+  }
+  for (size_t r = 1; r <= ones.size(); r += 1 + (gen() % 53)) {
+    die_unequal(ones[r - 1], ext->select1(r));
+  }
+  for (size_t r = 1; r <= zeros.size(); r += 1 + (gen() % 53)) {
+    die_unequal(zeros[r - 1], ext->select0(r));
+  }
+  if (!ones.empty()) {
+    die_unequal(ones.back(), ext->select1(ones.size()));
+  }
+  if (!zeros.empty()) {
+    die_unequal(zeros.back(), ext->select0(zeros.size()));
+  }
+
+  // Batched queries at random positions.
+  size_t const num_queries = 5'000;
+  std::vector<size_t> queries(num_queries);
+  std::vector<size_t> results(num_queries);
+  for (auto& query : queries) {
+    query = gen() % (N + 1);
+  }
+  ext->rank1_batch(queries, results);
+  for (size_t i = 0; i < num_queries; ++i) {
+    die_unequal(rank1[queries[i]], results[i]);
+  }
+  if (!ones.empty()) {
+    for (auto& query : queries) {
+      query = 1 + (gen() % ones.size());
+    }
+    ext->select1_batch(queries, results);
+    for (size_t i = 0; i < num_queries; ++i) {
+      die_unequal(ones[queries[i] - 1], results[i]);
+    }
+  }
+  if (!zeros.empty()) {
+    for (auto& query : queries) {
+      query = 1 + (gen() % zeros.size());
+    }
+    ext->select0_batch(queries, results);
+    for (size_t i = 0; i < num_queries; ++i) {
+      die_unequal(zeros[queries[i] - 1], results[i]);
+    }
+  }
+
+  // The memory usage is bounded by the cache and the in-memory information.
+  auto const& cache = ext->cache();
+  die_unequal(std::max<size_t>(1, cache_size / 4096), cache.num_frames());
+  die_unless(ext->space_usage() < (N / 8) + cache_size + 100'000);
+  die_unless(cache.misses() > 0 || N < 512);
+  ext = std::nullopt;
+  die_unless(std::filesystem::last_write_time(path) == last_write_time);
+
+  std::filesystem::remove(path);
+}
+
+int32_t main() {
+  std::string const path = (std::filesystem::temp_directory_path() /
+                            ("pasta_external_flat_rank_select_test_" +
+                             std::to_string(getpid())))
+                               .string();
+  std::filesystem::remove(path);
+  die_unless(!pasta::ExternalFlatRankSelect<>::open_file(path, 4096)
+                  .has_value());
+
+  // Batches with more distinct blocks than frames are rejected and leave
+  // the cache usable.
+  {
+    auto bv = pasta::BitVector::create_file(path, 3 * 8 * 4096, true);
+    die_unless(bv.has_value());
+  }
+  {
+    auto cache = pasta::BlockCache::open_file(path, 2 * 4096);
+    die_unless(cache.has_value());
+    std::vector<size_t> const blocks = {0, 1, 2};
+    bool rejected = false;
+    try {
+      cache->fetch(blocks);
+    } catch (std::length_error const&) {
+      rejected = true;
+    }
+    die_unless(rejected);
+    cache->fetch(std::span{blocks}.subspan(1));
+    die_unequal(0xFFU, unsigned{cache->cached_block(1)[0]});
+    die_unequal(0xFFU, unsigned{cache->cached_block(2)[0]});
+  }
+  std::filesystem::remove(path);
+
+  for (size_t const N : {1, 511, 4096, 100'000, 2'000'003}) {
+    for (size_t const cache_size : {0, 4 * 4096, 1 << 20}) {
+      run_test<pasta::OptimizedFor::DONT_CARE>(N, cache_size, path);
+      run_test<pasta::OptimizedFor::ZERO_QUERIES>(N, cache_size, path);
+    }
+  }
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * tests/bit_vector/fm_index_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <pasta/bit_vector/fm_index.hpp>
+#include <pasta/bit_vector/wavelet_matrix.hpp>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tlx/die.hpp>
+#include <vector>
+
+void wavelet_matrix_test(std::string const& text) {
+  std::span<uint8_t const> symbols(
+      reinterpret_cast<uint8_t const*>(text.data()),
+      text.size());
+  pasta::WaveletMatrix wm(symbols);
+  std::vector<size_t> ranks(256, 0);
+  for (size_t i = 0; i < text.size(); ++i) {
+    uint8_t const c = symbols[i];
+    die_unequal(c, wm[i]);
+    die_unequal(ranks[c], wm.rank(c, i));
+    auto const [access, rank] = wm.access_and_rank(i);
+    die_unequal(c, access);
+    die_unequal(ranks[c], rank);
+    ++ranks[c];
+  }
+}
+
+void fm_index_test(std::string text, std::string_view const alphabet) {
+  text.push_back('\0');
+  size_t const n = text.size();
+  std::vector<uint64_t> sa(n);
+  std::iota(sa.begin(), sa.end(), 0);
+  std::sort(sa.begin(), sa.end(), [&](uint64_t const a, uint64_t const b) {
+    return std::string_view(text).substr(a) < std::string_view(text).substr(b);
+  });
+  std::vector<uint8_t> bwt(n);
+  for (size_t i = 0; i < n; ++i) {
+    bwt[i] = text[(sa[i] + n - 1) % n];
+  }
+
+  for (size_t const sample_rate : {1, 4, 32}) {
+    pasta::FmIndex fm(bwt, sa, sample_rate);
+    die_unequal(n, fm.size());
+    for (size_t i = 0; i < n; ++i) {
+      die_unequal(sa[i], fm.sa(i));
+    }
+
+    std::mt19937 gen(n);
+    std::vector<std::string> patterns;
+    for (size_t length = 1; length < 8; ++length) {
+      for (size_t k = 0; k < 10; ++k) {
+        size_t const pos = gen() % (n - 1);
+        patterns.push_back(text.substr(pos, length));
+        std::string random_pattern;
+        for (size_t j = 0; j < length; ++j) {
+          random_pattern.push_back(alphabet[gen() % alphabet.size()]);
+        }
+        patterns.push_back(random_pattern);
+      }
+    }
+    patterns.push_back("");
+    patterns.push_back("~not in text");
+
+    std::vector<std::string_view> views(patterns.begin(), patterns.end());
+    std::vector<size_t> batch_counts(views.size());
+    fm.count_batch(views, batch_counts);
+
+    for (size_t p = 0; p < patterns.size(); ++p) {
+      std::string_view const pattern = patterns[p];
+      std::vector<size_t> expected;
+      for (size_t i = 0; i < n && i + pattern.size() <= n; ++i) {
+        if (std::string_view(text).substr(i, pattern.size()) == pattern) {
+          expected.push_back(i);
+        }
+      }
+      die_unequal(expected.size(), fm.count(pattern));
+      die_unequal(expected.size(), batch_counts[p]);
+      auto located = fm.locate(pattern);
+      std::sort(located.begin(), located.end());
+      die_unless(located == expected);
+    }
+  }
+}
+
+int32_t main() {
+  std::mt19937 gen(42);
+  for (std::string_view const alphabet :
+       {std::string_view("A"), std::string_view("ACGT"),
+        std::string_view("abcdefghijklmnopqrstuvwxyz0123456789")}) {
+    for (size_t const n : {1, 10, 1000, 5000}) {
+      std::string text;
+      for (size_t i = 0; i < n; ++i) {
+        text.push_back(alphabet[gen() % alphabet.size()]);
+      }
+      wavelet_matrix_test(text);
+      fm_index_test(text, alphabet);
+    }
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
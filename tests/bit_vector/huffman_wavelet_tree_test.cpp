@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * tests/bit_vector/huffman_wavelet_tree_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <pasta/bit_vector/huffman_wavelet_tree.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void run_test(std::vector<uint8_t> const& text) {
+  pasta::HuffmanWaveletTree wt(text);
+  die_unequal(text.size(), wt.size());
+  std::vector<size_t> ranks(256, 0);
+  std::vector<std::vector<size_t>> occurrences(256);
+  for (size_t i = 0; i < text.size(); ++i) {
+    uint8_t const c = text[i];
+    die_unequal(c, wt[i]);
+    die_unequal(ranks[c], wt.rank(c, i));
+    // Rank of a symbol that may differ from the current one.
+    uint8_t const other = text[(i * 7) % text.size()];
+    die_unequal(ranks[other], wt.rank(other, i));
+    ++ranks[c];
+    occurrences[c].push_back(i);
+  }
+  for (size_t c = 0; c < 256; ++c) {
+    uint8_t const symbol = static_cast<uint8_t>(c);
+    die_unequal(ranks[c], wt.rank(symbol, text.size()));
+    for (size_t r = 0; r < occurrences[c].size(); ++r) {
+      die_unequal(occurrences[c][r], wt.select(symbol, r + 1));
+    }
+  }
+}
+
+int32_t main() {
+  run_test({});
+  run_test({42});
+  run_test(std::vector<uint8_t>(1000, 7));
+  run_test({0, 255, 0, 255, 255});
+
+  std::mt19937_64 gen(42);
+  for (size_t const n : {10, 1000, 100'000}) {
+    // Geometric distribution, i.e., skewed symbol frequencies.
+    std::geometric_distribution<uint32_t> skewed(0.3);
+    std::vector<uint8_t> text(n);
+    for (auto& c : text) {
+      c = static_cast<uint8_t>(std::min<uint32_t>(skewed(gen), 255));
+    }
+    run_test(text);
+    if (n == 100'000) {
+      // Frequent symbols have shorter codes.
+      pasta::HuffmanWaveletTree wt(text);
+      die_unless(wt.code_length(0) < wt.code_length(10));
+      die_unless(wt.code_length(10) > 0);
+    }
+
+    // Uniform distribution over all bytes.
+    for (auto& c : text) {
+      c = static_cast<uint8_t>(gen());
+    }
+    run_test(text);
+  }
+  return 0;
+}
+
+/******************************************************************************/
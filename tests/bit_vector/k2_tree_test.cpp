@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * tests/bit_vector/k2_tree_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <pasta/bit_vector/k2_tree.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <utility>
+#include <vector>
+
+template <size_t k>
+void run_test(size_t const n, size_t const num_edges) {
+  using Edge = std::pair<size_t, size_t>;
+  std::mt19937_64 gen(n * num_edges);
+  std::vector<Edge> edges;
+  for (size_t e = 0; e < num_edges; ++e) {
+    // Clustered edges, such that some submatrices are dense.
+    size_t const row = gen() % n;
+    size_t const col = (e % 2 == 0) ? gen() % n : (row + (gen() % 8)) % n;
+    edges.emplace_back(row, col);
+  }
+  if (num_edges > 0) {
+    edges.push_back(edges.front());
+  }
+
+  pasta::K2Tree<k> tree(n, edges);
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  die_unequal(n, tree.size());
+  die_unequal(edges.size(), tree.num_edges());
+
+  std::vector<std::vector<size_t>> out(n);
+  std::vector<std::vector<size_t>> in(n);
+  for (auto const& [row, col] : edges) {
+    out[row].push_back(col);
+  }
+  for (auto const& [row, col] : edges) {
+    in[col].push_back(row);
+  }
+
+  for (auto const& [row, col] : edges) {
+    die_unless(tree.contains(row, col));
+  }
+  for (size_t q = 0; q < 1000; ++q) {
+    size_t const row = gen() % n;
+    size_t const col = gen() % n;
+    die_unequal(std::binary_search(out[row].begin(), out[row].end(), col),
+                tree.contains(row, col));
+  }
+
+  std::vector<size_t> rows;
+  for (size_t v = 0; v < n; v += 1 + (gen() % 5)) {
+    die_unless(out[v] == tree.neighbors(v));
+    die_unless(in[v] == tree.reverse_neighbors(v));
+    rows.push_back(v);
+  }
+  auto const batch = tree.neighbors_batch(rows);
+  die_unequal(rows.size(), batch.size());
+  for (size_t q = 0; q < rows.size(); ++q) {
+    die_unless(out[rows[q]] == batch[q]);
+  }
+
+  for (size_t q = 0; q < 50; ++q) {
+    size_t const row_begin = gen() % n;
+    size_t const row_end = row_begin + (gen() % (n - row_begin + 1));
+    size_t const col_begin = gen() % n;
+    size_t const col_end = col_begin + (gen() % (n - col_begin + 1));
+    std::vector<Edge> expected;
+    for (auto const& [row, col] : edges) {
+      if (row_begin <= row && row < row_end && col_begin <= col &&
+          col < col_end) {
+        expected.emplace_back(row, col);
+      }
+    }
+    auto result = tree.range(row_begin, row_end, col_begin, col_end);
+    std::sort(result.begin(), result.end());
+    die_unless(expected == result);
+  }
+  die_unequal(edges.size(), tree.range(0, n, 0, n).size());
+}
+
+int32_t main() {
+  for (size_t const n : {1, 2, 3, 8, 100, 1000, 4097}) {
+    for (size_t const num_edges : {0, 1, 10, 5000, 20000}) {
+      run_test<2>(n, num_edges);
+      run_test<4>(n, num_edges);
+      run_test<8>(n, num_edges);
+    }
+  }
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * tests/bit_vector/quotient_filter_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <map>
+#include <pasta/bit_vector/quotient_filter.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void run_test(size_t const quotient_bits, size_t const remainder_bits) {
+  std::mt19937_64 gen(quotient_bits * 64 + remainder_bits);
+  pasta::QuotientFilter qf(quotient_bits, remainder_bits);
+  size_t const capacity = qf.capacity();
+  die_unequal(1ULL << quotient_bits, capacity);
+  std::map<uint64_t, size_t> counts;
+
+  // Only few distinct keys, such that there are duplicates.
+  auto const random_key = [&]() {
+    return gen() % (capacity * 2);
+  };
+  auto const check = [&]() {
+    size_t total = 0;
+    for (auto const& [key, count] : counts) {
+      die_unless(qf.count(key) >= count);
+      // With long remainders, fingerprints of different keys do not collide.
+      if (qf.remainder_bits() >= 20) {
+        die_unequal(count, qf.count(key));
+      }
+      die_unless(count == 0 || qf.contains(key));
+      total += count;
+    }
+    die_unequal(total, qf.size());
+    std::vector<uint64_t> keys;
+    for (auto const& [key, count] : counts) {
+      keys.push_back(key);
+    }
+    std::vector<size_t> batch(keys.size());
+    qf.count_batch(keys, batch);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      die_unequal(qf.count(keys[i]), batch[i]);
+    }
+  };
+
+  // Fill the filter up to a load factor of 0.9.
+  while (qf.size() < (capacity * 9) / 10) {
+    uint64_t const key = random_key();
+    die_unless(qf.insert(key));
+    ++counts[key];
+  }
+  check();
+
+  // Mixed updates.
+  for (size_t i = 0; i < 2 * capacity; ++i) {
+    uint64_t const key = random_key();
+    if (gen() % 2 == 0 && counts[key] > 0) {
+      die_unless(qf.remove(key));
+      --counts[key];
+    } else if (qf.size() < (capacity * 9) / 10) {
+      die_unless(qf.insert(key));
+      ++counts[key];
+    }
+  }
+  check();
+
+  // With long remainders, false positives are unlikely.
+  if (remainder_bits >= 20) {
+    size_t false_positives = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+      uint64_t const key = (capacity * 2) + gen();
+      false_positives += qf.contains(key) ? 1 : 0;
+    }
+    die_unless(false_positives < 5);
+  }
+
+  // Grow the filter by rehashing.
+  die_unless(qf.resize(quotient_bits + 1));
+  die_unequal(2 * capacity, qf.capacity());
+  die_unequal(remainder_bits - 1, qf.remainder_bits());
+  check();
+
+  // Remove all keys.
+  for (auto& [key, count] : counts) {
+    for (; count > 0; --count) {
+      die_unless(qf.remove(key));
+    }
+  }
+  check();
+  die_unequal(0ULL, qf.size());
+}
+
+int32_t main() {
+  for (size_t const quotient_bits : {0, 1, 3, 6, 7, 10, 14}) {
+    for (size_t const remainder_bits : {2, 5, 13, 21, 40}) {
+      run_test(quotient_bits, remainder_bits);
+    }
+  }
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * tests/bit_vector/roaring_io_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+
+#include <cstdint>
+#include <pasta/bit_vector/roaring_io.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void round_trip_test(pasta::BitVector const& bv) {
+  std::vector<uint8_t> const bytes = pasta::write_roaring(bv);
+  auto const decoded = pasta::read_roaring(bytes, bv.size());
+  die_unless(decoded.has_value());
+  die_unequal(bv.size(), decoded->size());
+  for (size_t i = 0; i < bv.size(); ++i) {
+    die_unequal(bool{bv[i]}, bool{(*decoded)[i]});
+  }
+
+  // Without a size, the bit vector ends after the last set bit.
+  auto const shortest = pasta::read_roaring(bytes);
+  die_unless(shortest.has_value());
+  size_t const last_one = bv.find_prev1(bv.size());
+  die_unequal((last_one == bv.size()) ? 0 : last_one + 1, shortest->size());
+
+  // Truncated input.
+  if (bytes.size() > 8) {
+    die_unless(!pasta::read_roaring(std::span{bytes.data(), bytes.size() - 1})
+                    .has_value());
+  }
+}
+
+int32_t main() {
+  std::mt19937_64 gen(42);
+  for (size_t const N :
+       {0, 1, 64, 1000, 65'535, 65'536, 65'537, 200'000, 1'000'003}) {
+    // Sparse (array containers), dense (bitmap containers), and long runs
+    // (run containers), starting with garbage in the padding bits.
+    for (size_t const density : {0, 1, 10, 50, 100}) {
+      pasta::BitVector bv(N, true);
+      for (size_t i = 0; i < N; ++i) {
+        bool const in_run = ((i / 10'000) % 3) == 1;
+        bv[i] = in_run || (gen() % 1000 < density);
+      }
+      round_trip_test(bv);
+    }
+  }
+
+  // Array container {1, 2, 3, 1000} in the format without run containers.
+  std::vector<uint8_t> const array_bytes = {
+      0x3A, 0x30, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00,
+      0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0xE8, 0x03};
+  auto const array_bv = pasta::read_roaring(array_bytes);
+  die_unless(array_bv.has_value());
+  die_unequal(1001ULL, array_bv->size());
+  die_unequal(0b1110ULL, array_bv->data(0));
+  die_unequal(true, bool{(*array_bv)[1000]});
+  die_unless(pasta::write_roaring(*array_bv) == array_bytes);
+  die_unless(!pasta::read_roaring(array_bytes, 1000).has_value());
+
+  // Run container [10, 20] in the format with run containers.
+  std::vector<uint8_t> const run_bytes = {0x3B, 0x30, 0x00, 0x00, 0x01,
+                                          0x00, 0x00, 0x0A, 0x00, 0x01,
+                                          0x00, 0x0A, 0x00, 0x0A, 0x00};
+  auto const run_bv = pasta::read_roaring(run_bytes);
+  die_unless(run_bv.has_value());
+  die_unequal(21ULL, run_bv->size());
+  die_unequal(0b111111111110000000000ULL, run_bv->data(0));
+  die_unless(pasta::write_roaring(*run_bv) == run_bytes);
+
+  // Malformed array containers with unsorted ({60000, 3}) or duplicate
+  // ({3, 3}) values.
+  std::vector<uint8_t> const unsorted_bytes = {
+      0x3A, 0x30, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x01, 0x00, 0x10, 0x00, 0x00, 0x00, 0x60, 0xEA, 0x03, 0x00};
+  die_unless(!pasta::read_roaring(unsorted_bytes).has_value());
+  die_unless(!pasta::read_roaring(unsorted_bytes, 100).has_value());
+  std::vector<uint8_t> const duplicate_bytes = {
+      0x3A, 0x30, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x01, 0x00, 0x10, 0x00, 0x00, 0x00, 0x03, 0x00, 0x03, 0x00};
+  die_unless(!pasta::read_roaring(duplicate_bytes).has_value());
+
+  // Invalid cookie.
+  std::vector<uint8_t> const invalid = {0x00, 0x00, 0x00, 0x00};
+  die_unless(!pasta::read_roaring(invalid).has_value());
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * tests/bit_vector/sdsl_io_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <pasta/bit_vector/sdsl_io.hpp>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tlx/die.hpp>
+
+int32_t main() {
+  std::mt19937_64 gen(42);
+  for (size_t const N : {0, 1, 63, 64, 65, 1000, 100'003}) {
+    pasta::BitVector bv(N, true);
+    for (size_t i = 0; i < N; ++i) {
+      bv[i] = (gen() % 3 == 0);
+    }
+
+    std::stringstream stream;
+    die_unless(pasta::write_sdsl_bit_vector(bv, stream));
+    std::string const bytes = stream.str();
+    // Size header followed by the words (with cleared padding).
+    die_unequal(sizeof(uint64_t) * (1 + ((N + 63) / 64)), bytes.size());
+    uint64_t size = 0;
+    bytes.copy(reinterpret_cast<char*>(&size), sizeof(size));
+    die_unequal(N, size);
+    if (N % 64 != 0) {
+      uint64_t last_word = 0;
+      bytes.copy(reinterpret_cast<char*>(&last_word),
+                 sizeof(last_word),
+                 bytes.size() - sizeof(last_word));
+      die_unequal(0ULL, last_word >> (N % 64));
+    }
+
+    auto const read = pasta::read_sdsl_bit_vector(stream);
+    die_unless(read.has_value());
+    die_unequal(N, read->size());
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(bool{bv[i]}, bool{(*read)[i]});
+    }
+
+    // Truncated input.
+    if (N > 0) {
+      std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+      die_unless(!pasta::read_sdsl_bit_vector(truncated).has_value());
+    }
+  }
+
+  // Corrupted size headers are rejected before allocating the bit vector.
+  for (uint64_t const size : {uint64_t{1} << 62,
+                              std::numeric_limits<uint64_t>::max(),
+                              std::numeric_limits<uint64_t>::max() - 63,
+                              uint64_t{129}}) {
+    std::string bytes(sizeof(size), '\0');
+    std::copy_n(reinterpret_cast<char const*>(&size), sizeof(size), &bytes[0]);
+    bytes.append(2 * sizeof(uint64_t), '\0');
+    std::stringstream corrupted(bytes);
+    die_unless(!pasta::read_sdsl_bit_vector(corrupted).has_value());
+  }
+
+  // Round trip through a file.
+  std::string const path =
+      (std::filesystem::temp_directory_path() / "pasta_sdsl_io_test.sdsl")
+          .string();
+  pasta::BitVector bv(777, false);
+  bv[0] = true;
+  bv[776] = true;
+  die_unless(pasta::write_sdsl_bit_vector(bv, path));
+  auto const read = pasta::read_sdsl_bit_vector(path);
+  std::filesystem::remove(path);
+  die_unless(read.has_value());
+  die_unequal(777ULL, read->size());
+  die_unequal(2ULL, read->data(0) + (read->data(12) >> 8));
+  die_unless(!pasta::read_sdsl_bit_vector(path + ".missing").has_value());
+  return 0;
+}
+
+/******************************************************************************/
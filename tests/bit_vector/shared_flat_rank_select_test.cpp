@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * tests/bit_vector/shared_flat_rank_select_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <fcntl.h>
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/shared_flat_rank_select.hpp>
+#include <pasta/bit_vector/support/flat_rank_select.hpp>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <tlx/die.hpp>
+#include <unistd.h>
+#include <utility>
+
+template <typename SharedType, typename RankSelectType>
+bool equal_queries(SharedType const& shared,
+                   RankSelectType const& rs,
+                   pasta::BitVector const& bv,
+                   size_t const ones) {
+  size_t const N = bv.size();
+  for (size_t i = 0; i <= N; i += 1 + (i % 61)) {
+    if (shared.rank1(i) != rs.rank1(i) || shared.rank0(i) != rs.rank0(i)) {
+      return false;
+    }
+    if (i < N && shared[i] != bool{bv[i]}) {
+      return false;
+    }
+  }
+  for (size_t r = 1; r <= ones; r += 1 + (r % 37)) {
+    if (shared.select1(r) != rs.select1(r)) {
+      return false;
+    }
+  }
+  for (size_t r = 1; r <= N - ones; r += 1 + (r % 37)) {
+    if (shared.select0(r) != rs.select0(r)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Overwrites one 64-bit field of the header of a segment and returns the
+// previous value.
+uint64_t
+set_header_field(std::string const& name, size_t const field, uint64_t value) {
+  int const fd = shm_open(name.c_str(), O_RDWR, 0);
+  die_unless(fd >= 0);
+  void* const header =
+      mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  die_unless(header != MAP_FAILED);
+  std::swap(static_cast<uint64_t*>(header)[field], value);
+  munmap(header, 4096);
+  return value;
+}
+
+template <pasta::OptimizedFor optimized_for, pasta::FindL2FlatWith find_with>
+void run_test(size_t const N, std::string const& name) {
+  using Shared = pasta::SharedFlatRankSelect<optimized_for, find_with>;
+
+  std::mt19937_64 gen(N);
+  pasta::BitVector bv(N, false);
+  size_t ones = 0;
+  for (size_t i = 0; i < N; ++i) {
+    bool const bit = (gen() % 3 == 0);
+    bv[i] = bit;
+    ones += bit;
+  }
+  pasta::FlatRankSelect<optimized_for, find_with> rs(bv);
+
+  Shared::remove(name);
+  die_unless(!Shared::attach(name).has_value());
+  die_unless(Shared::create(name, bv));
+  // Segments are created exclusively.
+  die_unless(!Shared::create(name, bv));
+
+  {
+    auto shared = Shared::attach(name);
+    die_unless(shared.has_value());
+    die_unequal(N, shared->size());
+    die_unless(shared->segment_size() > (N / 8));
+    die_unless(equal_queries(*shared, rs, bv, ones));
+
+    // A second process attaching the same segment.
+    pid_t const pid = fork();
+    die_unless(pid >= 0);
+    if (pid == 0) {
+      auto child_shared = Shared::attach(name);
+      bool const ok = child_shared.has_value() &&
+                      equal_queries(*child_shared, rs, bv, ones);
+      _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    die_unequal(pid, waitpid(pid, &status, 0));
+    die_unless(WIFEXITED(status));
+    die_unequal(0, WEXITSTATUS(status));
+
+    // Segments whose arrays are not within the segment, are not aligned,
+    // or do not match the size of the bit vector are rejected. The header
+    // fields after the size of the segment are: bit size, data offset and
+    // size, L12 offset, size, and end, and offset and size of both samples.
+    for (size_t field = 3; field < 13; ++field) {
+      for (uint64_t const value : {uint64_t{1} << 40,
+                                   ~uint64_t{0},
+                                   shared->segment_size() + 1}) {
+        uint64_t const previous = set_header_field(name, field, value);
+        die_unless(!Shared::attach(name).has_value());
+        set_header_field(name, field, previous);
+      }
+    }
+    for (size_t const offset_field : {4, 6, 9, 11}) {
+      uint64_t const offset = set_header_field(name, offset_field, 0);
+      die_unless(!Shared::attach(name).has_value());
+      set_header_field(name, offset_field, offset + 8);
+      die_unless(!Shared::attach(name).has_value());
+      set_header_field(name, offset_field, offset);
+    }
+    die_unless(Shared::attach(name).has_value());
+
+    // Moving keeps the mapping valid.
+    Shared moved = std::move(*shared);
+    die_unless(equal_queries(moved, rs, bv, ones));
+
+    // Removing the segment keeps existing mappings valid.
+    die_unless(Shared::remove(name));
+    die_unless(equal_queries(moved, rs, bv, ones));
+  }
+  die_unless(!Shared::attach(name).has_value());
+  die_unless(!Shared::remove(name));
+}
+
+int32_t main() {
+  std::string const name =
+      "/pasta_shared_flat_rank_select_test_" + std::to_string(getpid());
+  for (size_t const N : {1, 64, 1'000, 100'000, 1'000'000}) {
+    run_test<pasta::OptimizedFor::DONT_CARE,
+             pasta::FindL2FlatWith::LINEAR_SEARCH>(N, name);
+    run_test<pasta::OptimizedFor::ZERO_QUERIES,
+             pasta::FindL2FlatWith::BINARY_SEARCH>(N, name);
+    run_test<pasta::OptimizedFor::ONE_QUERIES,
+             pasta::FindL2FlatWith::INTRINSICS>(N, name);
+  }
+  return 0;
+}
+
+/******************************************************************************/
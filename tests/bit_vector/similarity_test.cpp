@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * tests/bit_vector/similarity_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+
+#include <bit>
+#include <cstdint>
+#include <pasta/bit_vector/similarity.hpp>
+#include <random>
+#include <tlx/die.hpp>
+
+int32_t main() {
+  std::mt19937_64 gen(42);
+  for (size_t const N : {0, 1, 63, 64, 65, 255, 256, 257, 4096, 100'003}) {
+    for (size_t const density : {0, 1, 50, 99, 100}) {
+      // The second bit vector contains the ones of the first one, but some
+      // bits are flipped.
+      pasta::BitVector a(N, false);
+      pasta::BitVector b(N, true);
+      for (size_t i = 0; i < N; ++i) {
+        a[i] = (gen() % 100 < density);
+        b[i] = (gen() % 100 < 3) ? !a[i] : bool{a[i]};
+      }
+
+      size_t intersection = 0;
+      size_t union_count = 0;
+      size_t difference = 0;
+      for (size_t i = 0; i < N; ++i) {
+        bool const bit_a = a[i];
+        bool const bit_b = b[i];
+        intersection += (bit_a && bit_b) ? 1 : 0;
+        union_count += (bit_a || bit_b) ? 1 : 0;
+        difference += (bit_a != bit_b) ? 1 : 0;
+      }
+
+      auto const counts = pasta::similarity(a, b);
+      die_unequal(intersection, counts.intersection);
+      die_unequal(union_count, counts.union_count);
+      die_unequal(difference, counts.hamming_distance);
+      if (union_count > 0) {
+        die_unequal(static_cast<double>(intersection) / union_count,
+                    counts.jaccard());
+      } else {
+        die_unequal(1.0, counts.jaccard());
+      }
+      die_unequal(difference, pasta::hamming_distance(a, b));
+
+      die_unless(pasta::hamming_distance_at_most(a, b, difference));
+      die_unless(pasta::hamming_distance_at_most(a, b, difference + 1));
+      if (difference > 0) {
+        die_unless(!pasta::hamming_distance_at_most(a, b, difference - 1));
+        die_unless(!pasta::hamming_distance_at_most(a, b, 0));
+      }
+      die_unless(pasta::hamming_distance_at_most(a, a, 0));
+    }
+  }
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * tests/bit_vector/sparse_array_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <pasta/bit_vector/sparse_array.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <utility>
+#include <vector>
+
+void run_test(size_t const N, size_t const K, bool const shuffle) {
+  std::vector<std::pair<size_t, uint64_t>> entries;
+  std::vector<uint64_t> expected(N, 0);
+  for (size_t i = 0; i < N; i += K) {
+    entries.emplace_back(i, (i * 7) + 1);
+    expected[i] = (i * 7) + 1;
+  }
+  if (shuffle) {
+    std::mt19937 gen(N);
+    std::shuffle(entries.begin(), entries.end(), gen);
+  }
+
+  pasta::SparseArray<uint64_t> sa(
+      N,
+      std::span<std::pair<size_t, uint64_t> const>(entries));
+  die_unequal(N, sa.size());
+  die_unequal(entries.size(), sa.count());
+
+  for (size_t i = 0; i < N; ++i) {
+    die_unequal(expected[i] != 0, sa.contains(i));
+    die_unequal(expected[i], sa.get(i));
+  }
+
+  std::vector<size_t> positions(N);
+  for (size_t i = 0; i < N; ++i) {
+    positions[i] = (i * 31) % N;
+  }
+  std::vector<uint64_t> out(N);
+  sa.get_batch(positions, out);
+  for (size_t i = 0; i < N; ++i) {
+    die_unequal(expected[positions[i]], out[i]);
+  }
+
+  size_t count = 0;
+  size_t last_position = 0;
+  for (auto const [position, value] : sa) {
+    die_unless(count == 0 || last_position < position);
+    die_unequal(expected[position], value);
+    last_position = position;
+    ++count;
+  }
+  die_unequal(entries.size(), count);
+}
+
+int32_t main() {
+  for (size_t const N : {1, 63, 64, 65, 4096, 100'000, 1'000'003}) {
+    for (size_t const K : {1, 2, 50, 1000}) {
+      run_test(N, K, false);
+      run_test(N, K, true);
+    }
+  }
+
+  // Empty sparse array.
+  {
+    pasta::SparseArray<uint32_t> sa(1000, {});
+    die_unequal(0ULL, sa.count());
+    die_unless(sa.begin() == sa.end());
+    for (size_t i = 0; i < 1000; ++i) {
+      die_unequal(0U, sa.get(i));
+    }
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
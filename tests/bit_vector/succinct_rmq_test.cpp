@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * tests/bit_vector/succinct_rmq_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <pasta/bit_vector/succinct_rmq.hpp>
+#include <random>
+#include <span>
+#include <tlx/die.hpp>
+#include <utility>
+#include <vector>
+
+// Sparse table returning the leftmost minimum of a range (inclusive).
+class SparseTable {
+  std::vector<uint32_t> const& values_;
+  std::vector<std::vector<size_t>> table_;
+
+  size_t min_of(size_t const a, size_t const b) const {
+    return (values_[b] < values_[a]) ? b : a;
+  }
+
+public:
+  SparseTable(std::vector<uint32_t> const& values) : values_(values) {
+    table_.emplace_back(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      table_[0][i] = i;
+    }
+    for (size_t k = 1; (1ULL << k) <= values.size(); ++k) {
+      size_t const half = 1ULL << (k - 1);
+      auto& level = table_.emplace_back(values.size() - (2 * half) + 1);
+      for (size_t i = 0; i < level.size(); ++i) {
+        level[i] = min_of(table_[k - 1][i], table_[k - 1][i + half]);
+      }
+    }
+  }
+
+  size_t rmq(size_t const begin, size_t const end) const {
+    size_t const k = std::bit_width(end - begin + 1) - 1;
+    return min_of(table_[k][begin], table_[k][end + 1 - (1ULL << k)]);
+  }
+};
+
+void run_test(std::vector<uint32_t> const& values) {
+  size_t const n = values.size();
+  std::mt19937_64 gen(n);
+  pasta::SuccinctRmq rmq(std::span<uint32_t const>{values});
+  die_unequal(n, rmq.size());
+  if (n == 0) {
+    return;
+  }
+  SparseTable table(values);
+
+  std::vector<std::pair<size_t, size_t>> ranges;
+  if (n <= 100) {
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = i; j < n; ++j) {
+        ranges.emplace_back(i, j);
+      }
+    }
+  } else {
+    for (size_t q = 0; q < 20'000; ++q) {
+      size_t i = gen() % n;
+      size_t j = gen() % n;
+      if (q % 2 == 0) {
+        // Short ranges.
+        j = std::min(n - 1, i + (gen() % 2'000));
+      }
+      ranges.emplace_back(std::min(i, j), std::max(i, j));
+    }
+    ranges.emplace_back(0, n - 1);
+  }
+  for (auto const& [i, j] : ranges) {
+    die_unequal(table.rmq(i, j), rmq.rmq(i, j));
+  }
+
+  std::vector<size_t> out(ranges.size());
+  rmq.rmq_batch(ranges, out);
+  for (size_t q = 0; q < ranges.size(); ++q) {
+    die_unequal(table.rmq(ranges[q].first, ranges[q].second), out[q]);
+  }
+}
+
+int32_t main() {
+  for (size_t const n : {0, 1, 2, 3, 64, 100, 257, 4'096, 70'001, 300'007}) {
+    std::mt19937_64 gen(n);
+    std::vector<uint32_t> values(n);
+
+    // Random values (with and without many duplicates).
+    for (uint32_t const max : {3U, 1'000U, ~0U}) {
+      for (auto& value : values) {
+        value = static_cast<uint32_t>(gen() % (uint64_t{max} + 1));
+      }
+      run_test(values);
+    }
+
+    // Increasing, decreasing, and constant values.
+    for (size_t i = 0; i < n; ++i) {
+      values[i] = static_cast<uint32_t>(i);
+    }
+    run_test(values);
+    std::reverse(values.begin(), values.end());
+    run_test(values);
+    std::fill(values.begin(), values.end(), 42);
+    run_test(values);
+
+    // Values resembling an LCP array: long increasing runs.
+    for (size_t i = 0; i < n; ++i) {
+      values[i] = static_cast<uint32_t>((gen() % 64 == 0) ? 0 : i % 1'000);
+    }
+    run_test(values);
+  }
+
+  // Space usage is close to 2n bits.
+  std::vector<uint32_t> values(1'000'000);
+  std::mt19937_64 gen(42);
+  for (auto& value : values) {
+    value = static_cast<uint32_t>(gen());
+  }
+  pasta::SuccinctRmq rmq(std::span<uint32_t const>{values});
+  die_unless(rmq.space_usage() * 8 < 3 * values.size());
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * tests/bit_vector/summarized_bit_vector_test.cpp
+ *
+ * Copyright (C) 2024 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <pasta/bit_vector/summarized_bit_vector.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+void run_test(size_t const N, bool const init_value) {
+  std::mt19937_64 gen(N);
+  pasta::SummarizedBitVector sbv(N, init_value);
+  std::vector<bool> bits(N, init_value);
+  die_unequal(N, sbv.size());
+
+  std::vector<size_t> next_one(N + 1, N);
+  std::vector<size_t> next_zero(N + 1, N);
+  auto check = [&]() {
+    for (size_t i = N; i > 0; --i) {
+      next_one[i - 1] = bits[i - 1] ? i - 1 : next_one[i];
+      next_zero[i - 1] = bits[i - 1] ? next_zero[i] : i - 1;
+    }
+    for (size_t i = 0; i <= N; i += 1 + (gen() % 97)) {
+      die_unequal(next_one[i], sbv.find_next_one(i));
+      die_unequal(next_zero[i], sbv.find_next_zero(i));
+    }
+  };
+  check();
+
+  // Flip single bits, such that the vector becomes almost full/empty.
+  for (size_t round = 0; round < 4; ++round) {
+    for (size_t k = 0; k < N; ++k) {
+      size_t const pos = gen() % N;
+      bool const value = (round % 2 == 0) ? !init_value : init_value;
+      sbv[pos] = value;
+      bits[pos] = value;
+    }
+    check();
+  }
+
+  // Set and clear single bits in an otherwise empty vector.
+  for (size_t i = 0; i < N; ++i) {
+    sbv.set(i, false);
+    bits[i] = false;
+  }
+  check();
+  for (size_t k = 0; k < 10; ++k) {
+    size_t const pos = gen() % N;
+    sbv[pos] = true;
+    bits[pos] = true;
+    die_unequal(bool{sbv[pos]}, true);
+    check();
+    sbv[pos] = false;
+    bits[pos] = false;
+    check();
+  }
+
+  // Fill the vector completely and remove single bits.
+  for (size_t i = 0; i < N; ++i) {
+    sbv[i] = true;
+    bits[i] = true;
+  }
+  check();
+  for (size_t k = 0; k < 10; ++k) {
+    size_t const pos = gen() % N;
+    sbv[pos] = false;
+    bits[pos] = false;
+    check();
+  }
+}
+
+int32_t main() {
+  for (size_t const N : {1, 64, 65, 4096, 4097, 262'144, 300'007}) {
+    run_test(N, false);
+    run_test(N, true);
+  }
+
+  // Summary of an existing bit vector.
+  {
+    pasta::BitVector bv(10'000, false);
+    bv[9'999] = true;
+    pasta::SummarizedBitVector sbv(std::move(bv));
+    die_unequal(9'999ULL, sbv.find_next_one(0));
+    die_unequal(0ULL, sbv.find_next_zero(0));
+    die_unequal(10'000ULL, sbv.find_next_zero(9'999));
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
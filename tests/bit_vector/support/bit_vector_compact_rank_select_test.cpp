@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * tests/bit_vector/support/bit_vector_compact_rank_select_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/support/compact_rank_select.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+template <typename TestFunction>
+void run_test(TestFunction test_config) {
+  std::vector<size_t> offsets = {0, 723};
+  std::vector<size_t> bit_sizes = {1ULL << 2, 1ULL << 12, 1ULL << 22};
+  for (auto const& bit_size : bit_sizes) {
+    for (auto const offset : offsets) {
+      size_t const vector_size = bit_size + offset;
+      for (size_t k = 0; k <= 4; ++k) {
+        size_t const set_every_kth = 1ULL << k;
+        // if k > bit_size this testing doesn't make any sense
+        if (k < bit_size) {
+          test_config(vector_size, set_every_kth);
+        }
+      }
+    }
+  }
+  // Largest supported size.
+  test_config((1ULL << 32) - 1, 3);
+}
+
+template <pasta::OptimizedFor optimized_for>
+void check_select(pasta::BitVector& bv, size_t const N, size_t const K) {
+  size_t const query_pos_offset = (N > (1ULL << 30)) ? 101 : 1;
+  pasta::CompactRankSelect<optimized_for> bvrs(bv);
+  for (size_t i = 1; i <= N / K; i += query_pos_offset) {
+    die_unequal(K * (i - 1), bvrs.select1(i));
+  }
+  for (size_t i = 1; i <= N - ((N + K - 1) / K);
+       i += (std::max<size_t>(1, N / 100) + 1)) {
+    size_t const pos = bvrs.select0(i);
+    die_unless(pos % K != 0);
+    die_unequal(i, bvrs.rank0(pos + 1));
+  }
+}
+
+int32_t main() {
+  run_test([](size_t N, size_t K) {
+    pasta::BitVector bv(N, 0);
+    auto bv_data = bv.data();
+    for (size_t i = 0; i < bv_data.size(); ++i) {
+      uint64_t word = 0ULL;
+      for (size_t j = 0; j < 64; ++j) {
+        word >>= 1;
+        if (size_t bit_pos = ((i * 64) + j); bit_pos >= N) {
+          word >>= (63 - j);
+          break;
+        } else if (bit_pos % K == 0) {
+          word |= (1ULL << 63);
+        }
+      }
+      bv_data.data()[i] = word;
+    }
+    check_select<pasta::OptimizedFor::ONE_QUERIES>(bv, N, K);
+    check_select<pasta::OptimizedFor::ZERO_QUERIES>(bv, N, K);
+  });
+
+  // Random and very sparse bit vectors.
+  for (size_t const one_every : {2, 100, 100'000}) {
+    size_t const N = 3'000'017;
+    std::mt19937_64 gen(one_every);
+    pasta::BitVector bv(N, false);
+    std::vector<uint32_t> ones;
+    std::vector<uint32_t> zeros;
+    for (size_t i = 0; i < N; ++i) {
+      bool const bit = (gen() % one_every == 0);
+      bv[i] = bit;
+      (bit ? ones : zeros).push_back(static_cast<uint32_t>(i));
+    }
+    pasta::CompactRankSelect<pasta::OptimizedFor::ONE_QUERIES> one_rs(bv);
+    pasta::CompactRankSelect<pasta::OptimizedFor::ZERO_QUERIES> zero_rs(bv);
+    for (size_t i = 0; i < ones.size(); ++i) {
+      die_unequal(ones[i], one_rs.select1(i + 1));
+      die_unequal(ones[i], zero_rs.select1(i + 1));
+    }
+    for (size_t i = 0; i < zeros.size(); i += 7) {
+      die_unequal(zeros[i], one_rs.select0(i + 1));
+      die_unequal(zeros[i], zero_rs.select0(i + 1));
+    }
+  }
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * tests/bit_vector/support/bit_vector_compact_rank_test.cpp
+ *
+ * Copyright (C) 2021 Florian Kurpicz <florian@kurpicz.org>
+ *
+ * pasta::bit_vector is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * pasta::bit_vector is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with pasta::bit_vector.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <pasta/bit_vector/bit_vector.hpp>
+#include <pasta/bit_vector/support/compact_rank.hpp>
+#include <random>
+#include <tlx/die.hpp>
+#include <vector>
+
+template <typename TestFunction>
+void run_test(TestFunction test_config) {
+  std::vector<size_t> offsets = {0, 7, 723, 1347};
+  for (size_t n = 2; n <= 22; n += 10) {
+    for (auto const offset : offsets) {
+      size_t const vector_size = (1ULL << n) + offset;
+      for (size_t k = 0; k <= 4; ++k) {
+        size_t const set_every_kth = 1 + (1ULL << k);
+        if (k < n) { // if k > n this testing doesn't make any sense
+          test_config(vector_size, set_every_kth);
+        }
+      }
+    }
+  }
+  // Largest supported size.
+  test_config((1ULL << 32) - 1, 1ULL << 2);
+}
+
+template <typename RankType>
+void check_batch(RankType const& bvr, size_t const N) {
+  std::mt19937_64 gen(N);
+  std::vector<uint32_t> positions(1'003);
+  for (auto& pos : positions) {
+    pos = static_cast<uint32_t>(gen() % (N + 1));
+  }
+  positions[0] = static_cast<uint32_t>(N);
+  std::vector<uint32_t> out(positions.size());
+  bvr.rank1_batch(positions, out);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    die_unequal(bvr.rank1(positions[i]), out[i]);
+  }
+  bvr.rank0_batch(positions, out);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    die_unequal(bvr.rank0(positions[i]), out[i]);
+  }
+}
+
+int32_t main() {
+  run_test([](size_t N, size_t K) {
+    pasta::BitVector bv(N, 0);
+    size_t set_ones = 0;
+
+    auto bv_data = bv.data();
+    for (size_t i = 0; i < bv_data.size(); ++i) {
+      uint64_t word = 0ULL;
+      for (size_t j = 0; j < 64; ++j) {
+        word >>= 1;
+        if (size_t bit_pos = ((i * 64) + j); bit_pos >= N) {
+          word >>= (63 - j);
+          break;
+        } else if (bit_pos % K == 0) {
+          ++set_ones;
+          word |= (1ULL << 63);
+        }
+      }
+      bv_data.data()[i] = word;
+    }
+
+    size_t const query_pos_offset = (N > (1ULL << 30)) ? 101 : 1;
+
+    // Test optimized for one queries
+    {
+      pasta::CompactRank<pasta::OptimizedFor::ONE_QUERIES> bvr(bv);
+
+      die_unequal(set_ones, bvr.rank1(N));
+      for (size_t i = 1; i <= N / K; i += query_pos_offset) {
+        die_unequal(i, bvr.rank1((K * i)));
+      }
+
+      die_unequal((N - set_ones), bvr.rank0(N));
+      for (size_t i = 1; i <= N / K; i += query_pos_offset) {
+        die_unequal((K - 1) * i, bvr.rank0((K * i)));
+      }
+      check_batch(bvr, N);
+    }
+    // Test optimized for zero queries
+    {
+      pasta::CompactRank<pasta::OptimizedFor::ZERO_QUERIES> bvr(bv);
+
+      die_unequal(set_ones, bvr.rank1(N));
+      for (size_t i = 1; i <= N / K; i += query_pos_offset) {
+        die_unequal(i, bvr.rank1((K * i)));
+      }
+
+      die_unequal((N - set_ones), bvr.rank0(N));
+      for (size_t i = 1; i <= N / K; i += query_pos_offset) {
+        die_unequal((K - 1) * i, bvr.rank0((K * i)));
+      }
+      check_batch(bvr, N);
+    }
+  });
+
+  return 0;
+}
+
+/******************************************************************************/
@@ -21,8 +21,11 @@
 #include <cstdint>
 #include <pasta/bit_vector/bit_vector.hpp>
 #include <pasta/bit_vector/support/find_l2_flat_with.hpp>
+#include <pasta/bit_vector/support/flat_rank.hpp>
 #include <pasta/bit_vector/support/flat_rank_select.hpp>
+#include <random>
 #include <tlx/die.hpp>
+#include <vector>
 
 template <typename TestFunction>
 void run_test(TestFunction test_config) {
@@ -50,7 +53,127 @@ void run_test(TestFunction test_config) {
   }
 }
 
+template <pasta::OptimizedFor optimized_for, pasta::FindL2FlatWith find_with>
+void check_uniform_blocks(pasta::BitVector& bv,
+                          std::vector<size_t> const& rank1,
+                          std::vector<size_t> const& ones,
+                          std::vector<size_t> const& zeros) {
+  pasta::FlatRankSelect<optimized_for, find_with> bvrs(bv);
+  for (size_t i = 0; i < rank1.size(); ++i) {
+    die_unequal(rank1[i], bvrs.rank1(i));
+    die_unequal(i - rank1[i], bvrs.rank0(i));
+  }
+  for (size_t i = 0; i < ones.size(); ++i) {
+    die_unequal(ones[i], bvrs.select1(i + 1));
+  }
+  for (size_t i = 0; i < zeros.size(); ++i) {
+    die_unequal(zeros[i], bvrs.select0(i + 1));
+  }
+}
+
+// Bit vectors consisting of L2-blocks that contain only zeros, only ones, or
+// random bits, which are handled differently by rank and select queries.
+void uniform_blocks_test() {
+  for (size_t const N : {512, 4096, 4096 * 3 + 512, 100'000, 1'000'000}) {
+    std::mt19937_64 gen(N);
+    pasta::BitVector bv(N, false);
+    size_t const run_length = (N > 100'000) ? 512 : 300;
+    for (size_t begin = 0; begin < N; begin += run_length) {
+      size_t const type = gen() % 3;
+      for (size_t i = begin; i < std::min(N, begin + run_length); ++i) {
+        bv[i] = (type == 0) ? false : ((type == 1) ? true : (gen() % 2 == 0));
+      }
+    }
+    std::vector<size_t> rank1(N + 1, 0);
+    std::vector<size_t> ones;
+    std::vector<size_t> zeros;
+    for (size_t i = 0; i < N; ++i) {
+      bool const bit = bv[i];
+      rank1[i + 1] = rank1[i] + bit;
+      (bit ? ones : zeros).push_back(i);
+    }
+    check_uniform_blocks<pasta::OptimizedFor::ONE_QUERIES,
+                         pasta::FindL2FlatWith::LINEAR_SEARCH>(bv,
+                                                               rank1,
+                                                               ones,
+                                                               zeros);
+    check_uniform_blocks<pasta::OptimizedFor::ZERO_QUERIES,
+                         pasta::FindL2FlatWith::BINARY_SEARCH>(bv,
+                                                               rank1,
+                                                               ones,
+                                                               zeros);
+    check_uniform_blocks<pasta::OptimizedFor::DONT_CARE,
+                         pasta::FindL2FlatWith::INTRINSICS>(bv,
+                                                            rank1,
+                                                            ones,
+                                                            zeros);
+  }
+}
+
+template <pasta::OptimizedFor optimized_for, pasta::FindL2FlatWith find_with>
+void check_refresh(size_t const N) {
+  std::mt19937_64 gen(N);
+  pasta::BitVector bv(N);
+  for (size_t i = 0; i < N; ++i) {
+    bv[i] = (gen() % 2 == 0);
+  }
+  bv.track_dirty_regions();
+  pasta::FlatRank<optimized_for> rank(bv);
+  pasta::FlatRankSelect<optimized_for, find_with> bvrs(bv);
+
+  for (size_t round = 0; round < 6; ++round) {
+    // Scattered writes, whole L2-blocks set to zeros or ones (uniform
+    // blocks), and writes to the raw data that are marked manually.
+    for (size_t k = 0; k < 1 + (N / 20'000); ++k) {
+      bv[gen() % N] = (gen() % 2 == 0);
+    }
+    if (round % 2 == 0 && N >= 512) {
+      size_t const begin = (gen() % (N / 512)) * 512;
+      bool const value = (round % 4 == 0);
+      for (size_t i = begin; i < begin + 512; ++i) {
+        bv[i] = value;
+      }
+    }
+    if (round == 3) {
+      size_t const word = gen() % (N / 64 + 1);
+      bv.data()[word] = (N / 64 > word) ? gen() : 0ULL;
+      bv.mark_dirty(word * 64, (word + 1) * 64);
+    }
+    rank.refresh(bv);
+    bvrs.refresh(bv);
+    bv.clear_dirty_regions();
+
+    size_t rank1 = 0;
+    for (size_t i = 0; i < N; ++i) {
+      die_unequal(rank1, rank.rank1(i));
+      die_unequal(rank1, bvrs.rank1(i));
+      if (bv[i]) {
+        die_unequal(i, bvrs.select1(++rank1));
+      } else {
+        die_unequal(i, bvrs.select0(i + 1 - rank1));
+      }
+    }
+    die_unequal(rank1, bvrs.rank1(N));
+  }
+}
+
+// Refreshing the rank and select information after modifications of the
+// bit vector must result in the same answers as a new construction.
+void refresh_test() {
+  for (size_t const N : {1, 4096, 4096 * 3 + 512, 8192, 300'007}) {
+    check_refresh<pasta::OptimizedFor::ONE_QUERIES,
+                  pasta::FindL2FlatWith::LINEAR_SEARCH>(N);
+    check_refresh<pasta::OptimizedFor::ZERO_QUERIES,
+                  pasta::FindL2FlatWith::BINARY_SEARCH>(N);
+    check_refresh<pasta::OptimizedFor::DONT_CARE,
+                  pasta::FindL2FlatWith::INTRINSICS>(N);
+  }
+}
+
 int32_t main() {
+  uniform_blocks_test();
+  refresh_test();
+
   // Test select
   run_test([](size_t N, size_t K) {
     pasta::BitVector bv(N, 0);